@@ -0,0 +1,86 @@
+#ifndef COMMAND_CONDITIONER_H
+#define COMMAND_CONDITIONER_H
+
+#include <Arduino.h>
+#include "HardwareController.h"
+
+// Acondicionamiento de los comandos de movimiento antes de los motores.
+// - Un movimiento se mantiene al menos COMMAND_MIN_DWELL_MS antes de pasar a
+//   otro; lo que llegue mientras tanto se junta y vale solo el último (una
+//   ráfaga LEFT/RIGHT/LEFT termina en un solo cambio, o en ninguno).
+// - Invertir el sentido (adelante/atrás, izquierda/derecha) pasa primero por
+//   una parada de COMMAND_REVERSAL_STOP_MS para no castigar el puente H.
+// - STOP se aplica siempre al instante.
+// No reserva memoria: solo guarda el último pedido y el estado de salida.
+
+#ifndef COMMAND_MIN_DWELL_MS
+#define COMMAND_MIN_DWELL_MS 150
+#endif
+#ifndef COMMAND_REVERSAL_STOP_MS
+#define COMMAND_REVERSAL_STOP_MS 80
+#endif
+
+class CommandConditioner {
+    public:
+        // Nuevo movimiento pedido por el operador
+        void request(Motion motion) {
+            requested = motion;
+        }
+
+        // Movimiento que toca mandar ahora a los motores
+        Motion update(uint32_t nowUs) {
+            if (requested == output) {
+                pausing = false;
+                return output;
+            }
+            if (requested == MOTION_STOP) {
+                change(MOTION_STOP, nowUs);
+                return output;
+            }
+            if (pausing) {
+                if (nowUs - changedAt < COMMAND_REVERSAL_STOP_MS * 1000UL) {
+                    return output;
+                }
+                pausing = false;
+                change(requested, nowUs);
+                return output;
+            }
+            if (output != MOTION_STOP && nowUs - changedAt < COMMAND_MIN_DWELL_MS * 1000UL) {
+                return output;
+            }
+            if (reverses(output, requested)) {
+                change(MOTION_STOP, nowUs);
+                pausing = true;
+                return output;
+            }
+            change(requested, nowUs);
+            return output;
+        }
+
+        // Cambios mandados a los motores desde el inicio
+        uint32_t appliedCount() const {
+            return applied;
+        }
+
+    private:
+        Motion requested = MOTION_STOP;
+        Motion output = MOTION_STOP;
+        uint32_t changedAt = 0;
+        bool pausing = false;
+        uint32_t applied = 0;
+
+        void change(Motion motion, uint32_t nowUs) {
+            output = motion;
+            changedAt = nowUs;
+            applied++;
+        }
+
+        static bool reverses(Motion from, Motion to) {
+            return (from == MOTION_FORWARD && to == MOTION_BACKWARD)
+                || (from == MOTION_BACKWARD && to == MOTION_FORWARD)
+                || (from == MOTION_LEFT && to == MOTION_RIGHT)
+                || (from == MOTION_RIGHT && to == MOTION_LEFT);
+        }
+};
+
+#endif
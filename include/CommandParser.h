@@ -0,0 +1,261 @@
+#ifndef COMMAND_PARSER_H
+#define COMMAND_PARSER_H
+
+#include <Arduino.h>
+
+// Lectura de los comandos JSON del servidor en una sola pasada.
+// No arma un documento ni copia cadenas: recorre el texto una vez, reconoce
+// las claves de primer nivel que usa el carro y deja los valores de texto
+// como puntero + largo dentro del mismo mensaje (valen mientras viva el
+// mensaje). Las demás claves, con cualquier valor (objetos y arreglos
+// anidados incluidos), se saltan sin importar el largo del mensaje.
+// Los escapes (\") de las cadenas se respetan al buscar el final, pero el
+// valor se devuelve tal cual, sin desescapar.
+
+// Claves reconocidas
+enum CommandField : uint16_t {
+    FIELD_STATE     = 1 << 0,
+    FIELD_THROTTLE  = 1 << 1,
+    FIELD_STEERING  = 1 << 2,
+    FIELD_LEFT      = 1 << 3,
+    FIELD_RIGHT     = 1 << 4,
+    FIELD_SEQ       = 1 << 5,
+    FIELD_HEARTBEAT = 1 << 6,
+    FIELD_COMPRESS  = 1 << 7,
+    FIELD_ACK       = 1 << 8,
+    FIELD_WATCHDOG  = 1 << 9
+};
+
+struct CommandFields {
+    uint16_t present;    // FIELD_* encontrados
+    const char* state;   // Dentro del mensaje, sin terminar en '\0'
+    uint8_t stateLength;
+    int32_t throttle;
+    int32_t steering;
+    int32_t left;
+    int32_t right;
+    uint32_t seq;
+    bool compress;       // El servidor acepta telemetría comprimida
+    uint32_t ack;        // Última trama de estado que recibió el servidor
+    uint32_t watchdogMs; // Plazo del watchdog del enlace (0 = desarmado)
+
+    bool has(CommandField field) const {
+        return present & field;
+    }
+};
+
+class CommandParser {
+    public:
+        // false si el mensaje no es un objeto JSON; dentro de los valores que
+        // se saltan solo se sigue el anidamiento, no se valida todo
+        static bool parse(const char* data, size_t length, CommandFields& fields) {
+            fields = CommandFields();
+            const char* p = data;
+            const char* end = data + length;
+            skipSpace(p, end);
+            if (p == end || *p != '{') {
+                return false;
+            }
+            p++;
+            skipSpace(p, end);
+            if (p < end && *p == '}') {
+                return true;
+            }
+            while (p < end) {
+                const char* key;
+                size_t keyLength;
+                if (!readString(p, end, key, keyLength)) {
+                    return false;
+                }
+                skipSpace(p, end);
+                if (p == end || *p != ':') {
+                    return false;
+                }
+                p++;
+                skipSpace(p, end);
+                if (!readValue(p, end, key, keyLength, fields)) {
+                    return false;
+                }
+                skipSpace(p, end);
+                if (p == end) {
+                    return false;
+                }
+                if (*p == '}') {
+                    return true;
+                }
+                if (*p != ',') {
+                    return false;
+                }
+                p++;
+                skipSpace(p, end);
+            }
+            return false;
+        }
+
+    private:
+        static void skipSpace(const char*& p, const char* end) {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+                p++;
+            }
+        }
+
+        static bool keyIs(const char* key, size_t keyLength, const char* name) {
+            return strlen(name) == keyLength && memcmp(key, name, keyLength) == 0;
+        }
+
+        // Cadena entre comillas; deja p después de la comilla final
+        static bool readString(const char*& p, const char* end, const char*& value, size_t& valueLength) {
+            if (p == end || *p != '"') {
+                return false;
+            }
+            p++;
+            value = p;
+            while (p < end && *p != '"') {
+                if (*p == '\\') {
+                    p++;
+                }
+                p++;
+            }
+            if (p >= end) {
+                return false;
+            }
+            valueLength = p - value;
+            p++;
+            return true;
+        }
+
+        // Entero con signo; la parte decimal o el exponente se descartan
+        static bool readNumber(const char*& p, const char* end, int32_t& value) {
+            bool negative = false;
+            if (p < end && *p == '-') {
+                negative = true;
+                p++;
+            }
+            if (p == end || *p < '0' || *p > '9') {
+                return false;
+            }
+            int64_t magnitude = 0;
+            while (p < end && *p >= '0' && *p <= '9') {
+                if (magnitude < 0x100000000LL) {
+                    magnitude = magnitude * 10 + (*p - '0');
+                }
+                p++;
+            }
+            while (p < end && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-')) {
+                p++;
+            }
+            // Positivos hasta 2^32 - 1 (seq), negativos hasta -2^31
+            if (negative) {
+                value = magnitude > 0x80000000LL ? INT32_MIN : (int32_t)-magnitude;
+            } else {
+                value = (int32_t)(uint32_t)(magnitude > 0xFFFFFFFFLL ? 0xFFFFFFFFLL : magnitude);
+            }
+            return true;
+        }
+
+        // Salta un objeto o arreglo completo contando la profundidad
+        static bool skipNested(const char*& p, const char* end) {
+            int depth = 0;
+            while (p < end) {
+                char c = *p;
+                if (c == '"') {
+                    const char* ignored;
+                    size_t ignoredLength;
+                    if (!readString(p, end, ignored, ignoredLength)) {
+                        return false;
+                    }
+                    continue;
+                }
+                if (c == '{' || c == '[') {
+                    depth++;
+                } else if (c == '}' || c == ']') {
+                    depth--;
+                    if (depth == 0) {
+                        p++;
+                        return true;
+                    }
+                }
+                p++;
+            }
+            return false;
+        }
+
+        static bool skipLiteral(const char*& p, const char* end, const char* literal) {
+            size_t length = strlen(literal);
+            if ((size_t)(end - p) < length || memcmp(p, literal, length) != 0) {
+                return false;
+            }
+            p += length;
+            return true;
+        }
+
+        static bool readValue(const char*& p, const char* end, const char* key, size_t keyLength, CommandFields& fields) {
+            if (p == end) {
+                return false;
+            }
+            // El latido vale con cualquier valor
+            if (keyIs(key, keyLength, "heartbeat")) {
+                fields.present |= FIELD_HEARTBEAT;
+            }
+            char c = *p;
+            if (c == '"') {
+                const char* value;
+                size_t valueLength;
+                if (!readString(p, end, value, valueLength)) {
+                    return false;
+                }
+                if (keyIs(key, keyLength, "state")) {
+                    fields.state = value;
+                    fields.stateLength = valueLength < 255 ? valueLength : 255;
+                    fields.present |= FIELD_STATE;
+                }
+                return true;
+            }
+            if (c == '-' || (c >= '0' && c <= '9')) {
+                int32_t value;
+                if (!readNumber(p, end, value)) {
+                    return false;
+                }
+                storeNumber(key, keyLength, value, fields);
+                return true;
+            }
+            if (c == '{' || c == '[') {
+                return skipNested(p, end);
+            }
+            if (keyIs(key, keyLength, "compress")) {
+                fields.compress = c == 't';
+                fields.present |= FIELD_COMPRESS;
+            }
+            return skipLiteral(p, end, c == 't' ? "true" : c == 'f' ? "false" : "null");
+        }
+
+        static void storeNumber(const char* key, size_t keyLength, int32_t value, CommandFields& fields) {
+            if (keyIs(key, keyLength, "seq")) {
+                fields.seq = (uint32_t)value;
+                fields.present |= FIELD_SEQ;
+            } else if (keyIs(key, keyLength, "throttle")) {
+                fields.throttle = value;
+                fields.present |= FIELD_THROTTLE;
+            } else if (keyIs(key, keyLength, "steering")) {
+                fields.steering = value;
+                fields.present |= FIELD_STEERING;
+            } else if (keyIs(key, keyLength, "left")) {
+                fields.left = value;
+                fields.present |= FIELD_LEFT;
+            } else if (keyIs(key, keyLength, "right")) {
+                fields.right = value;
+                fields.present |= FIELD_RIGHT;
+            } else if (keyIs(key, keyLength, "ack")) {
+                fields.ack = (uint32_t)value;
+                fields.present |= FIELD_ACK;
+            } else if (keyIs(key, keyLength, "compress")) {
+                fields.compress = value != 0;
+                fields.present |= FIELD_COMPRESS;
+            } else if (keyIs(key, keyLength, "watchdog_ms")) {
+                fields.watchdogMs = value > 0 ? (uint32_t)value : 0;
+                fields.present |= FIELD_WATCHDOG;
+            }
+        }
+};
+
+#endif
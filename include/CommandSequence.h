@@ -0,0 +1,48 @@
+#ifndef COMMAND_SEQUENCE_H
+#define COMMAND_SEQUENCE_H
+
+#include <stdint.h>
+
+// Números de secuencia de los comandos de un canal.
+// Por el WebSocket (TCP) todo llega en orden: el seq es opcional (0 = sin
+// seq) y solo sirve para contar los comandos que el servidor numeró pero
+// nunca llegaron. Por UDP gana el más nuevo: un comando sin seq, repetido o
+// más viejo que el último aceptado se descarta. La comparación es por
+// diferencia con signo, así que el seq puede dar la vuelta.
+class CommandSequence {
+    public:
+        explicit CommandSequence(bool newestWins) : newestWins(newestWins) {}
+
+        // false si el comando hay que descartarlo; si no, lost queda con los
+        // comandos que faltaron entre el último aceptado y este
+        bool accept(uint32_t seq, uint32_t& lost) {
+            lost = 0;
+            int32_t ahead = (int32_t)(seq - lastSeq);
+            if (newestWins && (seq == 0 || (lastSeq != 0 && ahead <= 0))) {
+                return false;
+            }
+            if (seq == 0) {
+                return true;
+            }
+            if (lastSeq != 0 && ahead > 1) {
+                lost = ahead - 1;
+            }
+            lastSeq = seq;
+            return true;
+        }
+
+        uint32_t last() const {
+            return lastSeq;
+        }
+
+        // Conexión nueva: el servidor puede volver a empezar desde 1
+        void reset() {
+            lastSeq = 0;
+        }
+
+    private:
+        const bool newestWins;
+        uint32_t lastSeq = 0;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef DISTANCE_FILTER_H
+#define DISTANCE_FILTER_H
+
+#include <Arduino.h>
+
+// Filtro de las lecturas del sensor ultrasónico, todo en enteros.
+// Convierte el eco a milímetros y guarda las últimas DISTANCE_FILTER_WINDOW
+// lecturas. Si la nueva se aleja de la mediana de la ventana más de
+// HAMPEL_K veces la desviación (MAD escalada), se toma como atípica y se
+// devuelve la mediana en su lugar (filtro de Hampel). Así un cero o un
+// máximo suelto no llega a la decisión de frenado. Un cambio real sobre una
+// ventana plana (MAD 0) también se descarta hasta que es mayoría: se retrasa
+// DISTANCE_FILTER_WINDOW / 2 lecturas (2 con la ventana de 5, unos 60 ms a
+// PING_INTERVAL_US), lo mismo que una mediana pura. Con ruido en la ventana
+// los cambios dentro de HAMPEL_K desviaciones pasan sin retraso.
+// Las lecturas sin eco entran en la ventana como tales: una sola se descarta,
+// y si son mayoría la salida es 0 (sin eco).
+
+// Tamaño de la ventana (impar, como máximo 9)
+#ifndef DISTANCE_FILTER_WINDOW
+#define DISTANCE_FILTER_WINDOW 5
+#endif
+// Umbral en desviaciones estándar equivalentes, en punto fijo Q8 (3.0)
+#ifndef HAMPEL_K_Q8
+#define HAMPEL_K_Q8 768
+#endif
+// Diferencia mínima con la mediana para descartar, por si la ventana es plana
+#ifndef HAMPEL_MIN_MM
+#define HAMPEL_MIN_MM 30
+#endif
+
+// Eco máximo que se espera (~4 m ida y vuelta); úsese como timeout de pulseIn
+#define ECHO_TIMEOUT_US 25000
+
+class DistanceFilter {
+    public:
+        static const uint16_t MIN_MM = 20;
+        static const uint16_t MAX_MM = 4000;
+        // Lectura sin eco; es más lejos que cualquier válida y ordena al final
+        static const uint16_t NO_ECHO = 0xFFFF;
+
+        // Procesa la duración del eco en µs (0 = sin eco) y devuelve la
+        // distancia filtrada en mm (0 = sin eco)
+        uint16_t update(uint32_t echoUs) {
+            uint16_t sample = toMillimeters(echoUs);
+            window[next] = sample;
+            next = (next + 1) % DISTANCE_FILTER_WINDOW;
+            if (count < DISTANCE_FILTER_WINDOW) {
+                count++;
+            }
+
+            uint16_t sorted[DISTANCE_FILTER_WINDOW] = {};
+            for (uint8_t i = 0; i < count; i++) {
+                insertSorted(sorted, i, window[i]);
+            }
+            uint16_t median = sorted[count / 2];
+
+            uint16_t deviations[DISTANCE_FILTER_WINDOW] = {};
+            for (uint8_t i = 0; i < count; i++) {
+                insertSorted(deviations, i, distance(window[i], median));
+            }
+            // 1.4826 * MAD estima la desviación estándar; 380 / 256 ~ 1.4826
+            uint32_t sigma = ((uint32_t)deviations[count / 2] * 380) >> 8;
+            uint32_t threshold = (sigma * HAMPEL_K_Q8) >> 8;
+            if (threshold < HAMPEL_MIN_MM) {
+                threshold = HAMPEL_MIN_MM;
+            }
+
+            uint16_t output = distance(sample, median) > threshold ? median : sample;
+            if (output != sample) {
+                rejected++;
+            }
+            return output == NO_ECHO ? 0 : output;
+        }
+
+        // Lecturas reemplazadas por la mediana desde el inicio
+        uint32_t outliers() const {
+            return rejected;
+        }
+
+        void reset() {
+            count = 0;
+            next = 0;
+        }
+
+        // µs de eco a mm: 0.17 mm/µs (0.034 cm/µs ida y vuelta) en Q16
+        static uint16_t toMillimeters(uint32_t echoUs) {
+            uint32_t mm = (echoUs * 11141u) >> 16;
+            if (echoUs == 0 || echoUs > ECHO_TIMEOUT_US || mm < MIN_MM || mm > MAX_MM) {
+                return NO_ECHO;
+            }
+            return mm;
+        }
+
+    private:
+        uint16_t window[DISTANCE_FILTER_WINDOW];
+        uint8_t count = 0;
+        uint8_t next = 0;
+        uint32_t rejected = 0;
+
+        static uint16_t distance(uint16_t a, uint16_t b) {
+            return a > b ? a - b : b - a;
+        }
+
+        // Inserción en un arreglo ya ordenado de n elementos
+        static void insertSorted(uint16_t* values, uint8_t n, uint16_t value) {
+            while (n > 0 && values[n - 1] > value) {
+                values[n] = values[n - 1];
+                n--;
+            }
+            values[n] = value;
+        }
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef DRIVE_MIXER_H
+#define DRIVE_MIXER_H
+
+#include <Arduino.h>
+#include "HardwareController.h"
+
+// Mezcla acelerador/dirección a ciclo útil de cada rueda (tracción diferencial).
+// La tabla se calcula una sola vez en pasos de MIX_STEP y ya incluye:
+// - la mezcla: izquierda = acelerador + dirección, derecha = acelerador -
+//   dirección, reescaladas si alguna pasa de 100 para conservar la curva;
+// - la zona muerta de los motores: por debajo de MOTOR_MIN_DUTY no giran,
+//   así que cualquier valor distinto de cero arranca desde ahí.
+// En loop() cada comando queda en una búsqueda en la tabla.
+
+// Resolución de la tabla en % (divide a 100)
+#define MIX_STEP 5
+#define MIX_SIZE (2 * 100 / MIX_STEP + 1)
+// Ciclo útil mínimo con el que los motores empiezan a girar
+#ifndef MOTOR_MIN_DUTY
+#define MOTOR_MIN_DUTY 35
+#endif
+
+class DriveMixer {
+    public:
+        struct Wheels {
+            int8_t left;
+            int8_t right;
+        };
+
+        DriveMixer() {
+            for (int t = 0; t < MIX_SIZE; t++) {
+                for (int s = 0; s < MIX_SIZE; s++) {
+                    int left = valueAt(t) + valueAt(s);
+                    int right = valueAt(t) - valueAt(s);
+                    int peak = abs(left) > abs(right) ? abs(left) : abs(right);
+                    if (peak > 100) {
+                        left = left * 100 / peak;
+                        right = right * 100 / peak;
+                    }
+                    table[t][s] = {deadband(left), deadband(right)};
+                }
+            }
+        }
+
+        // Acelerador (-100..100, positivo adelante) y dirección (-100..100,
+        // positivo a la derecha)
+        Wheels mix(int throttle, int steering) const {
+            return table[indexOf(throttle)][indexOf(steering)];
+        }
+
+        // Velocidad de cada rueda dada directamente (modo tanque)
+        Wheels tank(int left, int right) const {
+            return {deadband(constrain(left, -100, 100)), deadband(constrain(right, -100, 100))};
+        }
+
+        // Movimiento discreto más parecido, para el frenado y el barrido
+        static Motion motionOf(const Wheels& wheels) {
+            if (wheels.left == 0 && wheels.right == 0) {
+                return MOTION_STOP;
+            }
+            if (wheels.left > 0 && wheels.right > 0) {
+                return MOTION_FORWARD;
+            }
+            if (wheels.left < 0 && wheels.right < 0) {
+                return MOTION_BACKWARD;
+            }
+            return wheels.left < wheels.right ? MOTION_LEFT : MOTION_RIGHT;
+        }
+
+    private:
+        Wheels table[MIX_SIZE][MIX_SIZE];
+
+        static int valueAt(int index) {
+            return index * MIX_STEP - 100;
+        }
+
+        // Redondea al paso más cercano de la tabla
+        static int indexOf(int value) {
+            value = constrain(value, -100, 100) + 100;
+            return (value + MIX_STEP / 2) / MIX_STEP;
+        }
+
+        static int8_t deadband(int value) {
+            if (value == 0) {
+                return 0;
+            }
+            int magnitude = MOTOR_MIN_DUTY + abs(value) * (100 - MOTOR_MIN_DUTY) / 100;
+            return value > 0 ? magnitude : -magnitude;
+        }
+};
+
+#endif
@@ -2,6 +2,37 @@
 #define HARDWARE_CONTROLLER_H
 
 #include <Arduino.h>
+#include <ESP32Servo.h>
+
+// Frecuencia y resolución del PWM de los motores en modo continuo
+#define MOTOR_PWM_FREQUENCY 1000
+#define MOTOR_PWM_BITS 8
+
+// Movimiento que están mandando los pines de los motores
+enum Motion {
+    MOTION_STOP,
+    MOTION_FORWARD,
+    MOTION_BACKWARD,
+    MOTION_LEFT,
+    MOTION_RIGHT,
+    MOTION_COUNT
+};
+
+// Salida de los motores: un movimiento todo o nada, o en modo continuo
+// (pwm) el ciclo útil de cada rueda, -100..100 (negativo = hacia atrás)
+struct MotorOutputs {
+    Motion motion = MOTION_STOP;
+    bool pwm = false;
+    int8_t left = 0;
+    int8_t right = 0;
+
+    bool operator==(const MotorOutputs& other) const {
+        return pwm == other.pwm && (pwm ? left == other.left && right == other.right : motion == other.motion);
+    }
+    bool operator!=(const MotorOutputs& other) const {
+        return !(*this == other);
+    }
+};
 
 class HardwareController {
     public:
@@ -25,6 +56,7 @@ class HardwareController {
         pinMode(PIN_MOTOR_LEFT_BACKWARD, OUTPUT);
         pinMode(PIN_MOTOR_RIGHT_BACKWARD, OUTPUT);
         pinMode(PIN_LIGHT, OUTPUT);
+        ESP32PWM::allocateTimer(1);
 
         stop();
         lightOff();
@@ -32,44 +64,52 @@ class HardwareController {
 
   // Método para avanzar
     void Forward() {
+        digitalMode();
         digitalWrite(PIN_MOTOR_LEFT_BACKWARD, LOW);
         digitalWrite(PIN_MOTOR_RIGHT_BACKWARD, LOW);
         digitalWrite(PIN_MOTOR_LEFT_FORWARD, HIGH);
         digitalWrite(PIN_MOTOR_RIGHT_FORWARD, HIGH);
+        currentMotion = MOTION_FORWARD;
     }
 
     // Método para retroceder
     void Backward() {
+        digitalMode();
         digitalWrite(PIN_MOTOR_LEFT_FORWARD, LOW);
         digitalWrite(PIN_MOTOR_RIGHT_FORWARD, LOW);
         digitalWrite(PIN_MOTOR_LEFT_BACKWARD, HIGH);
         digitalWrite(PIN_MOTOR_RIGHT_BACKWARD, HIGH);
+        currentMotion = MOTION_BACKWARD;
     }
 
     // Método para girar a la izquierda
     void turnLeft() {
+        digitalMode();
         digitalWrite(PIN_MOTOR_LEFT_FORWARD, LOW);
         digitalWrite(PIN_MOTOR_LEFT_BACKWARD, HIGH); // Motor izquierdo hacia atrás
         digitalWrite(PIN_MOTOR_RIGHT_FORWARD, HIGH); // Motor derecho hacia adelante
         digitalWrite(PIN_MOTOR_RIGHT_BACKWARD, LOW);
+        currentMotion = MOTION_LEFT;
     }
 
     // Método para girar a la derecha
     void turnRight() {
+        digitalMode();
         digitalWrite(PIN_MOTOR_LEFT_FORWARD, HIGH); // Motor izquierdo hacia adelante
         digitalWrite(PIN_MOTOR_LEFT_BACKWARD, LOW);
         digitalWrite(PIN_MOTOR_RIGHT_FORWARD, LOW);
         digitalWrite(PIN_MOTOR_RIGHT_BACKWARD, HIGH); // Motor derecho hacia atrás
+        currentMotion = MOTION_RIGHT;
     }
 
     // Método para detener el robot
     void stop() {
+        digitalMode();
         digitalWrite(PIN_MOTOR_LEFT_FORWARD, LOW);
         digitalWrite(PIN_MOTOR_RIGHT_FORWARD, LOW);
         digitalWrite(PIN_MOTOR_LEFT_BACKWARD, LOW);
         digitalWrite(PIN_MOTOR_RIGHT_BACKWARD, LOW);
-        digitalWrite(PIN_MOTOR_LEFT_FORWARD, HIGH);
-        digitalWrite(PIN_MOTOR_RIGHT_FORWARD, HIGH);
+        currentMotion = MOTION_STOP;
     }
 
     // Método para apagar las luces
@@ -81,6 +121,45 @@ class HardwareController {
     void lightOn() {
         digitalWrite(PIN_LIGHT, HIGH);
     }
+
+    // Modo continuo: ciclo útil de cada rueda, -100..100 (negativo = atrás)
+    void drive(int8_t left, int8_t right) {
+        if (!pwmActive) {
+            pwm[0].attachPin(PIN_MOTOR_LEFT_FORWARD, MOTOR_PWM_FREQUENCY, MOTOR_PWM_BITS);
+            pwm[1].attachPin(PIN_MOTOR_LEFT_BACKWARD, MOTOR_PWM_FREQUENCY, MOTOR_PWM_BITS);
+            pwm[2].attachPin(PIN_MOTOR_RIGHT_FORWARD, MOTOR_PWM_FREQUENCY, MOTOR_PWM_BITS);
+            pwm[3].attachPin(PIN_MOTOR_RIGHT_BACKWARD, MOTOR_PWM_FREQUENCY, MOTOR_PWM_BITS);
+            pwmActive = true;
+        }
+        writeWheel(pwm[0], pwm[1], left);
+        writeWheel(pwm[2], pwm[3], right);
+        currentMotion = MOTION_COUNT;
+    }
+
+    // Manda a los pines la salida indicada
+    void apply(const MotorOutputs& outputs) {
+        if (outputs.pwm) {
+            drive(outputs.left, outputs.right);
+        } else {
+            apply(outputs.motion);
+        }
+    }
+
+    // Manda a los pines el movimiento indicado
+    void apply(Motion motion) {
+        switch (motion) {
+            case MOTION_FORWARD: Forward(); break;
+            case MOTION_BACKWARD: Backward(); break;
+            case MOTION_LEFT: turnLeft(); break;
+            case MOTION_RIGHT: turnRight(); break;
+            default: stop(); break;
+        }
+    }
+
+    // Último movimiento mandado a los motores
+    Motion motion() const {
+        return currentMotion;
+    }
     private:
         const int 
                 PIN_MOTOR_LEFT_FORWARD, 
@@ -88,6 +167,32 @@ class HardwareController {
                 PIN_MOTOR_LEFT_BACKWARD, 
                 PIN_MOTOR_RIGHT_BACKWARD, 
                 PIN_LIGHT;
+        Motion currentMotion = MOTION_STOP;
+        ESP32PWM pwm[4];
+        bool pwmActive = false;
+
+        // Devuelve los pines al control digital si estaban en PWM
+        void digitalMode() {
+            if (!pwmActive) {
+                return;
+            }
+            pwm[0].detachPin(PIN_MOTOR_LEFT_FORWARD);
+            pwm[1].detachPin(PIN_MOTOR_LEFT_BACKWARD);
+            pwm[2].detachPin(PIN_MOTOR_RIGHT_FORWARD);
+            pwm[3].detachPin(PIN_MOTOR_RIGHT_BACKWARD);
+            pinMode(PIN_MOTOR_LEFT_FORWARD, OUTPUT);
+            pinMode(PIN_MOTOR_LEFT_BACKWARD, OUTPUT);
+            pinMode(PIN_MOTOR_RIGHT_FORWARD, OUTPUT);
+            pinMode(PIN_MOTOR_RIGHT_BACKWARD, OUTPUT);
+            pwmActive = false;
+        }
+
+        static void writeWheel(ESP32PWM& forward, ESP32PWM& backward, int8_t duty) {
+            const uint32_t full = (1UL << MOTOR_PWM_BITS) - 1;
+            uint32_t value = (uint32_t)abs(duty) * full / 100;
+            forward.write(duty > 0 ? value : 0);
+            backward.write(duty < 0 ? value : 0);
+        }
 };
 
 #endif
@@ -0,0 +1,101 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <Arduino.h>
+
+// Histograma de latencias en microsegundos sin memoria dinámica.
+// Las cubetas son logarítmicas con 8 subdivisiones por potencia de dos, así que
+// los percentiles tienen un error menor al 12.5% en cualquier rango.
+class LatencyStats {
+    public:
+        LatencyStats() { reset(); }
+
+        void reset() {
+            memset(buckets, 0, sizeof(buckets));
+            samples = 0;
+            maxUs = 0;
+            droppedSamples = 0;
+            supersededSamples = 0;
+        }
+
+        void record(uint32_t us) {
+            buckets[bucketFor(us)]++;
+            samples++;
+            if (us > maxUs) {
+                maxUs = us;
+            }
+        }
+
+        // Comandos que nunca llegaron a aplicarse: perdidos en la red o sin lugar en la cola
+        void dropped(uint32_t count = 1) {
+            droppedSamples += count;
+        }
+
+        // Comandos que llegaron, pero otro más nuevo los reemplazó antes de aplicarse
+        void superseded(uint32_t count = 1) {
+            supersededSamples += count;
+        }
+
+        // Valor bajo el cual queda el p% de las muestras (límite superior de la cubeta)
+        uint32_t percentile(uint8_t p) const {
+            if (samples == 0) {
+                return 0;
+            }
+            uint32_t target = ((uint64_t)samples * p + 99) / 100;
+            uint32_t seen = 0;
+            for (int i = 0; i < BUCKET_COUNT; i++) {
+                seen += buckets[i];
+                if (seen >= target) {
+                    uint32_t upper = bucketUpperBound(i);
+                    return upper < maxUs ? upper : maxUs;
+                }
+            }
+            return maxUs;
+        }
+
+        uint32_t count() const { return samples; }
+        uint32_t max() const { return maxUs; }
+        uint32_t droppedCount() const { return droppedSamples; }
+        uint32_t supersededCount() const { return supersededSamples; }
+
+        void report(Print& out, const char* name) const {
+            out.printf("%s: n=%u p50=%uus p99=%uus max=%uus perdidos=%u reemplazados=%u\n",
+                name,
+                (unsigned)samples,
+                (unsigned)percentile(50),
+                (unsigned)percentile(99),
+                (unsigned)maxUs,
+                (unsigned)droppedSamples,
+                (unsigned)supersededSamples);
+        }
+
+    private:
+        static const int SUB_BUCKETS = 8;
+        static const int BUCKET_COUNT = 30 * SUB_BUCKETS;
+
+        uint32_t buckets[BUCKET_COUNT];
+        uint32_t samples;
+        uint32_t maxUs;
+        uint32_t droppedSamples;
+        uint32_t supersededSamples;
+
+        static int bucketFor(uint32_t us) {
+            if (us < SUB_BUCKETS) {
+                return us;
+            }
+            int exponent = 31 - __builtin_clz(us);
+            int mantissa = (us >> (exponent - 3)) & (SUB_BUCKETS - 1);
+            return (exponent - 2) * SUB_BUCKETS + mantissa;
+        }
+
+        static uint32_t bucketUpperBound(int bucket) {
+            if (bucket < SUB_BUCKETS) {
+                return bucket;
+            }
+            int exponent = bucket / SUB_BUCKETS + 2;
+            uint32_t lower = (uint32_t)(SUB_BUCKETS + bucket % SUB_BUCKETS) << (exponent - 3);
+            return lower + ((1UL << (exponent - 3)) - 1);
+        }
+};
+
+#endif
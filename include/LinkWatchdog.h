@@ -0,0 +1,116 @@
+#ifndef LINK_WATCHDOG_H
+#define LINK_WATCHDOG_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Hombre muerto del enlace con el servidor.
+// La tarea de red llama heartbeat() con cada latido y feed() con cada comando;
+// el tick de motores llama check() y, si pasó más que el plazo sin nada, el
+// watchdog se dispara y los motores se paran en ese mismo tick. Como el tick
+// corre en el esp_timer, la parada no depende de que la tarea de red esté
+// viva (un client.poll() bloqueado no la retrasa): el peor caso es el plazo
+// más MOTOR_TICK_US.
+// Disparado se queda así hasta que la tarea de control lo rearma, después de
+// haber dejado publicado STOP; así al volver el enlace no se retoma el último
+// movimiento.
+// El plazo es un ajuste en marcha y cualquier trama lo cumple:
+// - el primer comando lo arma con LINK_COMMAND_TIMEOUT_MS, que alcanza a un
+//   servidor que repite el comando vigente sin mandar latidos;
+// - el primer latido lo baja a LINK_TIMEOUT_MS: un servidor que manda
+//   latidos los tiene que mandar más seguido que eso (por ejemplo cada 30 ms);
+// - el servidor puede fijar otro con {"watchdog_ms":N}; con 0 queda
+//   desarmado hasta la próxima conexión.
+// Cada conexión nueva empieza desarmada y sin plazo fijado.
+
+// Tiempo máximo sin comandos ni latidos antes de parar, con latidos
+#ifndef LINK_TIMEOUT_MS
+#define LINK_TIMEOUT_MS 90
+#endif
+// Lo mismo para un servidor que solo manda comandos
+#ifndef LINK_COMMAND_TIMEOUT_MS
+#define LINK_COMMAND_TIMEOUT_MS 500
+#endif
+
+class LinkWatchdog {
+    public:
+        // heartbeat(), feed(), setTimeout() y disarm() los llama solo la
+        // tarea de red; check() el tick de motores
+
+        // Llegó un latido: renueva el plazo y lo baja a LINK_TIMEOUT_MS si
+        // el servidor no fijó otro
+        void heartbeat(uint32_t nowUs) {
+            lastFeed.store(nowUs, std::memory_order_relaxed);
+            if (!configured) {
+                timeoutUs.store(LINK_TIMEOUT_MS * 1000UL, std::memory_order_release);
+            }
+        }
+
+        // Llegó un comando (o cualquier otra trama válida): renueva el plazo
+        // y, si todavía no estaba armado, lo arma con LINK_COMMAND_TIMEOUT_MS
+        void feed(uint32_t nowUs) {
+            lastFeed.store(nowUs, std::memory_order_relaxed);
+            if (!configured && timeoutUs.load(std::memory_order_relaxed) == 0) {
+                timeoutUs.store(LINK_COMMAND_TIMEOUT_MS * 1000UL, std::memory_order_release);
+            }
+        }
+
+        // El servidor fija el plazo; 0 desarma hasta la próxima conexión
+        void setTimeout(uint32_t timeoutMs, uint32_t nowUs) {
+            configured = true;
+            lastFeed.store(nowUs, std::memory_order_relaxed);
+            timeoutUs.store(timeoutMs * 1000UL, std::memory_order_release);
+        }
+
+        // Conexión nueva: desarmado hasta la primera trama
+        void disarm() {
+            configured = false;
+            timeoutUs.store(0, std::memory_order_release);
+        }
+
+        bool isArmed() const {
+            return timeoutUs.load(std::memory_order_acquire) != 0;
+        }
+
+        // Plazo vigente en ms (0 = desarmado)
+        uint32_t timeoutMs() const {
+            return timeoutUs.load(std::memory_order_acquire) / 1000;
+        }
+
+        // Tick de motores: true si hay que parar
+        bool check(uint32_t nowUs) {
+            if (trippedFlag.load(std::memory_order_acquire)) {
+                return true;
+            }
+            uint32_t timeout = timeoutUs.load(std::memory_order_acquire);
+            if (timeout == 0) {
+                return false;
+            }
+            // Con signo: feed() puede haber corrido justo después de tomar nowUs
+            if ((int32_t)(nowUs - lastFeed.load(std::memory_order_relaxed)) > (int32_t)timeout) {
+                trippedFlag.store(true, std::memory_order_release);
+                return true;
+            }
+            return false;
+        }
+
+        bool tripped() const {
+            return trippedFlag.load(std::memory_order_acquire);
+        }
+
+        // Tarea de control: ya publicó STOP, el tick puede volver a aplicar
+        // lo publicado (si el enlace sigue caído se vuelve a disparar)
+        void rearm() {
+            trippedFlag.store(false, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<uint32_t> lastFeed{0};
+        // 0 = desarmado
+        std::atomic<uint32_t> timeoutUs{0};
+        // El servidor fijó el plazo; solo lo toca la tarea de red
+        bool configured = false;
+        std::atomic<bool> trippedFlag{false};
+};
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <atomic>
+
+// Registro de mensajes que no bloquea al que escribe.
+// Los mensajes se formatean en un buffer circular reservado de antemano y una
+// tarea de baja prioridad los manda por serial, así loop() nunca espera a la
+// UART. Cada punto de registro lleva su propio límite de frecuencia: los
+// mensajes que lo exceden solo incrementan un contador y se informan con el
+// siguiente que sí sale ("(+N suprimidos)").
+// Logger hereda de Print, así que también sirve para los report(Print&).
+
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Nivel máximo que se compila; lo demás desaparece del firmware
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Estado de cada punto del código que registra. Un mismo punto se puede
+// llamar desde varias tareas, por eso es atómico; el constructor constexpr
+// hace que el static de LOG_AT se inicialice sin guarda ni lock
+struct LogSite {
+    constexpr explicit LogSite(uint32_t intervalMs) : intervalMs(intervalMs), lastMs(0), suppressed(0), emitted(false) {}
+    const uint32_t intervalMs;
+    std::atomic<uint32_t> lastMs;
+    std::atomic<uint32_t> suppressed;
+    std::atomic<bool> emitted;
+};
+
+class Logger : public Print {
+    public:
+        static const size_t BUFFER_SIZE = 2048;
+        static const size_t LINE_SIZE = 160;
+
+        static Logger& instance() {
+            static Logger logger;
+            return logger;
+        }
+
+        // Inicia la tarea que vacía el buffer hacia la salida
+        void begin(Print& output) {
+            setOutput(output);
+            xTaskCreatePinnedToCore(drainTask, "log", 3072, this, 1, NULL, 0);
+        }
+
+        // Solo la salida de drain(), sin tarea: para vaciarlo a mano
+        void setOutput(Print& output) {
+            out = &output;
+        }
+
+        __attribute__((format(printf, 4, 5)))
+        void log(LogSite& site, uint8_t level, const char* format, ...) {
+            uint32_t now = millis();
+            if (site.intervalMs) {
+                uint32_t last = site.lastMs.load(std::memory_order_relaxed);
+                bool waiting = site.emitted.load(std::memory_order_relaxed) && now - last < site.intervalMs;
+                // Si otra tarea sale en el mismo intervalo, esta cuenta como suprimida
+                if (waiting || !site.lastMs.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+                    site.suppressed.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                site.emitted.store(true, std::memory_order_relaxed);
+            }
+            uint32_t suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+
+            static const char levels[] = "?EWID";
+            char line[LINE_SIZE];
+            int len = snprintf(line, sizeof(line), "[%lu] %c ", (unsigned long)now, levels[level < 5 ? level : 0]);
+            va_list args;
+            va_start(args, format);
+            len += vsnprintf(line + len, sizeof(line) - len, format, args);
+            va_end(args);
+            if (suppressed && len < (int)sizeof(line)) {
+                len += snprintf(line + len, sizeof(line) - len, " (+%u suprimidos)", (unsigned)suppressed);
+            }
+            if (len > (int)sizeof(line) - 2) {
+                len = sizeof(line) - 2;
+            }
+            line[len++] = '\n';
+            push((const uint8_t*)line, len);
+        }
+
+        size_t write(uint8_t c) override {
+            return push(&c, 1);
+        }
+
+        size_t write(const uint8_t* buffer, size_t size) override {
+            return push(buffer, size);
+        }
+        using Print::write;
+
+        // Pasa a la salida lo que haya en el buffer; devuelve los bytes escritos
+        size_t drain(size_t maxBytes = BUFFER_SIZE) {
+            if (!out) {
+                return 0;
+            }
+            size_t total = 0;
+            uint8_t chunk[64];
+            while (total < maxBytes) {
+                size_t count = 0;
+                uint32_t lost;
+                portENTER_CRITICAL(&mux);
+                while (count < sizeof(chunk) && tail != head) {
+                    chunk[count++] = buffer[tail];
+                    tail = (tail + 1) % BUFFER_SIZE;
+                }
+                lost = droppedBytes;
+                droppedBytes = 0;
+                portEXIT_CRITICAL(&mux);
+
+                if (lost) {
+                    out->printf("[log] %u bytes perdidos\n", (unsigned)lost);
+                }
+                if (count == 0) {
+                    break;
+                }
+                out->write(chunk, count);
+                total += count;
+            }
+            return total;
+        }
+
+    private:
+        Print* out = nullptr;
+        portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+        uint8_t buffer[BUFFER_SIZE];
+        size_t head = 0;
+        size_t tail = 0;
+        uint32_t droppedBytes = 0;
+
+        // Todo o nada: un mensaje que no cabe se descarta entero
+        size_t push(const uint8_t* data, size_t size) {
+            portENTER_CRITICAL(&mux);
+            size_t used = (head + BUFFER_SIZE - tail) % BUFFER_SIZE;
+            if (size > BUFFER_SIZE - 1 - used) {
+                droppedBytes += size;
+                portEXIT_CRITICAL(&mux);
+                return 0;
+            }
+            for (size_t i = 0; i < size; i++) {
+                buffer[head] = data[i];
+                head = (head + 1) % BUFFER_SIZE;
+            }
+            portEXIT_CRITICAL(&mux);
+            return size;
+        }
+
+        static void drainTask(void* parameters) {
+            Logger* logger = (Logger*)parameters;
+            for (;;) {
+                logger->drain();
+                vTaskDelay(pdMS_TO_TICKS(20));
+            }
+        }
+};
+
+#define LOG_AT(level, intervalMs, format, ...) do { \
+        if ((level) <= LOG_LEVEL) { \
+            static LogSite logSite(intervalMs); \
+            Logger::instance().log(logSite, level, format, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_ERROR(format, ...) LOG_AT(LOG_LEVEL_ERROR, 0, format, ##__VA_ARGS__)
+#define LOG_WARN(format, ...) LOG_AT(LOG_LEVEL_WARN, 0, format, ##__VA_ARGS__)
+#define LOG_INFO(format, ...) LOG_AT(LOG_LEVEL_INFO, 0, format, ##__VA_ARGS__)
+#define LOG_DEBUG(format, ...) LOG_AT(LOG_LEVEL_DEBUG, 0, format, ##__VA_ARGS__)
+// Como los anteriores pero como máximo un mensaje cada intervalMs
+#define LOG_EVERY(level, intervalMs, format, ...) LOG_AT(level, intervalMs, format, ##__VA_ARGS__)
+
+#endif
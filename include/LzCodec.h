@@ -0,0 +1,164 @@
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+
+#include <Arduino.h>
+
+// Compresión LZ liviana (estilo LZSS) para las tramas de telemetría.
+// Las tramas sueltas son cortas y se parecen poco por dentro, pero se parecen
+// mucho entre sí (mismas claves, mismos ángulos, mismas teselas del mapa):
+// como permessage-deflate, las coincidencias pueden apuntar a las últimas
+// LZ_WINDOW bytes de tramas anteriores. Cada lado guarda esa historia con
+// append(), así que el servidor tiene que agregar todas las tramas en el
+// mismo orden, comprimidas o no, desde el último reset().
+// Formato: un byte de banderas adelante de cada grupo de 8 elementos; bit en
+// 0 = un literal (1 byte), bit en 1 = una coincidencia de 2 bytes en little
+// endian: 10 bits de distancia - 1 y 6 bits de largo - LZ_MIN_MATCH.
+// RAM fija: historia + trama actual + tabla hash de 512 posiciones (2.5 KB),
+// sin memoria dinámica.
+
+#define LZ_WINDOW_BITS 10
+#define LZ_WINDOW (1 << LZ_WINDOW_BITS)
+#define LZ_MIN_MATCH 3
+#define LZ_MAX_MATCH (LZ_MIN_MATCH + 63)
+#define LZ_HASH_BITS 9
+// Trama más larga que se puede comprimir
+#ifndef LZ_MAX_INPUT
+#define LZ_MAX_INPUT 512
+#endif
+
+class LzCodec {
+    public:
+        // Olvida la historia (conexión nueva)
+        void reset() {
+            historyLength = 0;
+        }
+
+        // Comprime en out usando la historia, sin modificarla; devuelve 0 si
+        // no entra en capacity, así quien llama decide cuánto tiene que ganar
+        // para que valga la pena
+        size_t compress(const uint8_t* in, size_t length, uint8_t* out, size_t capacity) {
+            if (length > LZ_MAX_INPUT) {
+                return 0;
+            }
+            memcpy(buffer + historyLength, in, length);
+            size_t end = historyLength + length;
+            memset(table, 0xFF, sizeof(table));
+            for (size_t i = 0; i + LZ_MIN_MATCH <= historyLength; i++) {
+                table[hash(buffer + i)] = i;
+            }
+
+            size_t used = 0;
+            size_t flagsAt = 0;
+            uint8_t bit = 8;
+            size_t pos = historyLength;
+            while (pos < end) {
+                if (bit == 8) {
+                    if (used >= capacity) {
+                        return 0;
+                    }
+                    flagsAt = used;
+                    out[used++] = 0;
+                    bit = 0;
+                }
+                size_t match = 0;
+                size_t distance = 0;
+                if (pos + LZ_MIN_MATCH <= end) {
+                    uint16_t& slot = table[hash(buffer + pos)];
+                    size_t candidate = slot;
+                    slot = pos;
+                    if (candidate < pos && pos - candidate <= LZ_WINDOW) {
+                        size_t limit = end - pos < LZ_MAX_MATCH ? end - pos : LZ_MAX_MATCH;
+                        while (match < limit && buffer[candidate + match] == buffer[pos + match]) {
+                            match++;
+                        }
+                        distance = pos - candidate;
+                    }
+                }
+                if (match >= LZ_MIN_MATCH) {
+                    if (used + 2 > capacity) {
+                        return 0;
+                    }
+                    uint16_t token = (uint16_t)((distance - 1) << 6 | (match - LZ_MIN_MATCH));
+                    out[used++] = token & 0xFF;
+                    out[used++] = token >> 8;
+                    out[flagsAt] |= 1 << bit;
+                    // Las posiciones salteadas también quedan en la tabla
+                    for (size_t i = pos + 1; i < pos + match && i + LZ_MIN_MATCH <= end; i++) {
+                        table[hash(buffer + i)] = i;
+                    }
+                    pos += match;
+                } else {
+                    if (used >= capacity) {
+                        return 0;
+                    }
+                    out[used++] = buffer[pos++];
+                }
+                bit++;
+            }
+            return used;
+        }
+
+        // Descomprime en out usando la historia, sin modificarla; devuelve el
+        // largo o 0 si los datos no son válidos
+        size_t decompress(const uint8_t* in, size_t length, uint8_t* out, size_t capacity) {
+            size_t used = historyLength;
+            size_t limit = historyLength + (capacity < LZ_MAX_INPUT ? capacity : LZ_MAX_INPUT);
+            size_t pos = 0;
+            while (pos < length) {
+                uint8_t flags = in[pos++];
+                for (uint8_t bit = 0; bit < 8 && pos < length; bit++) {
+                    if (!(flags & (1 << bit))) {
+                        if (used >= limit) {
+                            return 0;
+                        }
+                        buffer[used++] = in[pos++];
+                        continue;
+                    }
+                    if (pos + 2 > length) {
+                        return 0;
+                    }
+                    uint16_t token = in[pos] | (uint16_t)in[pos + 1] << 8;
+                    pos += 2;
+                    size_t distance = (token >> 6) + 1;
+                    size_t match = (token & 0x3F) + LZ_MIN_MATCH;
+                    if (distance > used || used + match > limit) {
+                        return 0;
+                    }
+                    // Byte a byte: la coincidencia puede solaparse con lo que se escribe
+                    for (size_t i = 0; i < match; i++, used++) {
+                        buffer[used] = buffer[used - distance];
+                    }
+                }
+            }
+            memcpy(out, buffer + historyLength, used - historyLength);
+            return used - historyLength;
+        }
+
+        // Agrega una trama ya enviada (o recibida) a la historia
+        void append(const uint8_t* in, size_t length) {
+            if (length >= LZ_WINDOW) {
+                memcpy(buffer, in + length - LZ_WINDOW, LZ_WINDOW);
+                historyLength = LZ_WINDOW;
+                return;
+            }
+            if (historyLength + length > LZ_WINDOW) {
+                size_t drop = historyLength + length - LZ_WINDOW;
+                memmove(buffer, buffer + drop, historyLength - drop);
+                historyLength -= drop;
+            }
+            memcpy(buffer + historyLength, in, length);
+            historyLength += length;
+        }
+
+    private:
+        uint8_t buffer[LZ_WINDOW + LZ_MAX_INPUT];
+        size_t historyLength = 0;
+        uint16_t table[1 << LZ_HASH_BITS];
+
+        static uint16_t hash(const uint8_t* p) {
+            uint32_t value = p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16;
+            return (uint32_t)(value * 2654435761u) >> (32 - LZ_HASH_BITS);
+        }
+};
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef MOTOR_TICKER_H
+#define MOTOR_TICKER_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <atomic>
+#include "HardwareController.h"
+#include "LatencyStats.h"
+#include "LinkWatchdog.h"
+
+// Aplicación de los motores a frecuencia fija.
+// loop() ya no escribe los pines: deja la salida deseada (movimiento o
+// ciclo útil de cada rueda) en un doble buffer y un esp_timer periódico la
+// pasa a los pines cada MOTOR_TICK_US, así el momento en que cambian los motores no depende de cuánto tardó el
+// resto de loop(). Cada tick mide cuánto se desvió del periodo (jitter).
+// tick() no sabe de dónde viene el tiempo, así que en el host se puede
+// manejar con un reloj simulado.
+// Si se le da un LinkWatchdog, cada tick lo revisa y, disparado, manda STOP
+// en lugar de lo publicado.
+
+// Periodo del tick de motores
+#ifndef MOTOR_TICK_US
+#define MOTOR_TICK_US 1000
+#endif
+
+class MotorTicker {
+    public:
+        explicit MotorTicker(HardwareController& hardware) : hardware(hardware) {}
+
+        void begin() {
+            esp_timer_create_args_t args = {};
+            args.callback = onTimer;
+            args.arg = this;
+            args.dispatch_method = ESP_TIMER_TASK;
+            args.name = "motors";
+            esp_timer_create(&args, &timer);
+            esp_timer_start_periodic(timer, MOTOR_TICK_US);
+        }
+
+        // Para los motores cuando el watchdog se dispara
+        void watch(LinkWatchdog& linkWatchdog) {
+            watchdog = &linkWatchdog;
+        }
+
+        // set() y drive() los llama una sola tarea (control): escriben el
+        // buffer de atrás y lo publican
+        void set(Motion motion) {
+            MotorOutputs outputs;
+            outputs.motion = motion;
+            publish(outputs);
+        }
+
+        // Modo continuo: ciclo útil de cada rueda, -100..100
+        void drive(int8_t left, int8_t right) {
+            MotorOutputs outputs;
+            outputs.pwm = true;
+            outputs.left = left;
+            outputs.right = right;
+            publish(outputs);
+        }
+
+        // Un tick: aplica lo último publicado si cambió (o STOP si el enlace
+        // se cayó) y registra el jitter
+        void tick(int64_t nowUs) {
+            // Si set()/drive() publicó durante la copia, puede que esté escribiendo
+            // el buffer que se estaba leyendo: se vuelve a leer
+            MotorOutputs outputs;
+            uint32_t before;
+            do {
+                before = version.load(std::memory_order_acquire);
+                outputs = buffers[before & 1];
+            } while (version.load(std::memory_order_acquire) != before);
+            if (watchdog && watchdog->check(nowUs)) {
+                outputs = MotorOutputs();
+            }
+
+            if (outputs != current) {
+                hardware.apply(outputs);
+                current = outputs;
+                appliedPacked.store(pack(outputs), std::memory_order_release);
+            }
+
+            if (lastTick) {
+                int64_t interval = nowUs - lastTick;
+                int64_t jitter = interval > MOTOR_TICK_US ? interval - MOTOR_TICK_US : MOTOR_TICK_US - interval;
+                portENTER_CRITICAL(&statsMux);
+                jitterStats.record(jitter);
+                portEXIT_CRITICAL(&statsMux);
+            }
+            lastTick = nowUs;
+        }
+
+        // Salida que ya está en los pines
+        MotorOutputs applied() const {
+            uint32_t packed = appliedPacked.load(std::memory_order_acquire);
+            MotorOutputs outputs;
+            outputs.motion = (Motion)(packed & 0xFF);
+            outputs.pwm = (packed >> 8) & 1;
+            outputs.left = (int8_t)(packed >> 16);
+            outputs.right = (int8_t)(packed >> 24);
+            return outputs;
+        }
+
+        // Imprime el jitter del tick desde el reporte anterior y lo reinicia.
+        // Solo el histograma: los contadores de comandos de LatencyStats no
+        // tienen sentido para un tick
+        void report(Print& out, const char* name) {
+            portENTER_CRITICAL(&statsMux);
+            LatencyStats snapshot = jitterStats;
+            jitterStats.reset();
+            portEXIT_CRITICAL(&statsMux);
+            out.printf("%s: periodo=%uus ticks=%u jitter p50=%uus p99=%uus max=%uus\n",
+                name,
+                (unsigned)MOTOR_TICK_US,
+                (unsigned)snapshot.count(),
+                (unsigned)snapshot.percentile(50),
+                (unsigned)snapshot.percentile(99),
+                (unsigned)snapshot.max());
+        }
+
+    private:
+        HardwareController& hardware;
+        esp_timer_handle_t timer = nullptr;
+        LinkWatchdog* watchdog = nullptr;
+        MotorOutputs buffers[2];
+        std::atomic<uint32_t> version{0};
+        MotorOutputs current; // solo la usa tick()
+        // Copia de current para otras tareas, en una sola palabra atómica
+        std::atomic<uint32_t> appliedPacked{0};
+        int64_t lastTick = 0;
+        portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+        LatencyStats jitterStats;
+
+        void publish(const MotorOutputs& outputs) {
+            uint32_t published = version.load(std::memory_order_relaxed);
+            buffers[(published + 1) & 1] = outputs;
+            version.store(published + 1, std::memory_order_release);
+        }
+
+        static uint32_t pack(const MotorOutputs& outputs) {
+            return (uint32_t)outputs.motion
+                | (uint32_t)outputs.pwm << 8
+                | (uint32_t)(uint8_t)outputs.left << 16
+                | (uint32_t)(uint8_t)outputs.right << 24;
+        }
+
+        static void onTimer(void* arg) {
+            MotorTicker* ticker = (MotorTicker*)arg;
+            ticker->tick(esp_timer_get_time());
+        }
+};
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef OCCUPANCY_GRID_H
+#define OCCUPANCY_GRID_H
+
+#include <Arduino.h>
+
+// Mapa local de ocupación a partir de las lecturas del ultrasónico.
+// Cada celda guarda el logaritmo de la razón de probabilidades (log-odds) en
+// un int8: positivo = ocupada, negativo = libre, 0 = desconocida. Cada
+// lectura se traza con Bresenham desde el carro: las celdas del camino se
+// marcan libres y la del final ocupada.
+// La memoria es fija: el mapa son OCC_TILES x OCC_TILES baldosas alrededor
+// del carro, guardadas en un arreglo circular. Al moverse el carro, las
+// baldosas que quedan atrás se limpian y se reutilizan para las de adelante.
+// Las celdas que cambian quedan marcadas para que exportDelta() mande solo
+// lo nuevo.
+// El haz del sensor es un cono de ~15°; aquí se trata como una línea.
+
+// Lado de una celda en cm
+#ifndef OCC_CELL_CM
+#define OCC_CELL_CM 10
+#endif
+// Baldosas por lado (impar, el carro va en la del centro)
+#ifndef OCC_TILES
+#define OCC_TILES 5
+#endif
+// Incrementos de log-odds por lectura (ocupada / libre) y límite
+#define OCC_HIT 12
+#define OCC_MISS -4
+#define OCC_LIMIT 100
+// Sin eco se marca libre solo hasta esta distancia
+#ifndef OCC_FREE_RANGE_CM
+#define OCC_FREE_RANGE_CM 200
+#endif
+
+// Celdas por lado de una baldosa
+#define OCC_TILE_CELLS 16
+
+class OccupancyGrid {
+    public:
+        // Posición del carro en cm y rumbo en grados (0 = eje x, antihorario)
+        void setPose(int32_t xCm, int32_t yCm, int16_t headingDeg) {
+            carX = xCm;
+            carY = yCm;
+            heading = headingDeg;
+        }
+
+        // Registra una lectura tomada con el sensor girado bearingDeg respecto
+        // al frente del carro (positivo a la izquierda); rangeCm 0 = sin eco
+        void addRay(int16_t bearingDeg, uint16_t rangeCm) {
+            bool hit = rangeCm > 0;
+            uint16_t length = hit ? rangeCm : OCC_FREE_RANGE_CM;
+            float angle = (heading + bearingDeg) * (PI / 180.0f);
+
+            int32_t x0 = cellOf(carX);
+            int32_t y0 = cellOf(carY);
+            int32_t x1 = cellOf(carX + (int32_t)lroundf(length * cosf(angle)));
+            int32_t y1 = cellOf(carY + (int32_t)lroundf(length * sinf(angle)));
+
+            // Bresenham entero de (x0, y0) a (x1, y1)
+            int32_t dx = abs(x1 - x0);
+            int32_t dy = -abs(y1 - y0);
+            int32_t sx = x0 < x1 ? 1 : -1;
+            int32_t sy = y0 < y1 ? 1 : -1;
+            int32_t error = dx + dy;
+            for (;;) {
+                bool last = x0 == x1 && y0 == y1;
+                if (!updateCell(x0, y0, last && hit ? OCC_HIT : OCC_MISS)) {
+                    break; // fuera del mapa
+                }
+                if (last) {
+                    break;
+                }
+                int32_t e2 = 2 * error;
+                if (e2 >= dy) {
+                    error += dy;
+                    x0 += sx;
+                }
+                if (e2 <= dx) {
+                    error += dx;
+                    y0 += sy;
+                }
+            }
+            rays++;
+        }
+
+        // Log-odds de la celda que contiene el punto (cm); 0 si no se conoce
+        int8_t at(int32_t xCm, int32_t yCm) const {
+            const Tile* tile = find(tileOf(cellOf(xCm)), tileOf(cellOf(yCm)));
+            if (!tile) {
+                return 0;
+            }
+            return tile->cells[cellIndex(cellOf(xCm), cellOf(yCm))];
+        }
+
+        // Escribe en buffer las celdas que cambiaron desde el último envío y
+        // devuelve los bytes usados (0 si no hay nada nuevo). Formato, en
+        // little-endian: 'M', tamaño de celda en cm, y por cada baldosa
+        // int16 tx, int16 ty, uint8 n y n pares (índice de celda, valor).
+        // Lo que no cabe queda para la próxima llamada.
+        size_t exportDelta(uint8_t* buffer, size_t size) {
+            if (size < 2 + 5 + 2) {
+                return 0;
+            }
+            size_t used = 0;
+            buffer[used++] = 'M';
+            buffer[used++] = OCC_CELL_CM;
+            for (uint8_t t = 0; t < OCC_TILES * OCC_TILES && size - used >= 5 + 2; t++) {
+                Tile& tile = tiles[t];
+                if (!tile.valid || tile.dirtyCount == 0) {
+                    continue;
+                }
+                buffer[used++] = tile.tx & 0xFF;
+                buffer[used++] = (tile.tx >> 8) & 0xFF;
+                buffer[used++] = tile.ty & 0xFF;
+                buffer[used++] = (tile.ty >> 8) & 0xFF;
+                uint8_t* count = &buffer[used++];
+                *count = 0;
+                for (uint16_t i = 0; i < CELLS_PER_TILE && *count < 255 && size - used >= 2; i++) {
+                    if (tile.dirty[i / 32] & (1UL << (i % 32))) {
+                        tile.dirty[i / 32] &= ~(1UL << (i % 32));
+                        tile.dirtyCount--;
+                        buffer[used++] = i;
+                        buffer[used++] = (uint8_t)tile.cells[i];
+                        (*count)++;
+                    }
+                }
+            }
+            return used > 2 ? used : 0;
+        }
+
+        // Lecturas procesadas desde el inicio
+        uint32_t rayCount() const {
+            return rays;
+        }
+
+        // RAM que ocupa el mapa
+        static constexpr size_t memoryBytes() {
+            return sizeof(Tile) * OCC_TILES * OCC_TILES;
+        }
+
+    private:
+        static const uint16_t CELLS_PER_TILE = OCC_TILE_CELLS * OCC_TILE_CELLS;
+
+        struct Tile {
+            int16_t tx = 0;
+            int16_t ty = 0;
+            bool valid = false;
+            uint16_t dirtyCount = 0;
+            uint32_t dirty[CELLS_PER_TILE / 32] = {};
+            int8_t cells[CELLS_PER_TILE] = {};
+        };
+
+        Tile tiles[OCC_TILES * OCC_TILES];
+        int32_t carX = 0;
+        int32_t carY = 0;
+        int16_t heading = 0;
+        uint32_t rays = 0;
+
+        // División que redondea hacia abajo también con negativos
+        static int32_t floorDiv(int32_t value, int32_t divisor) {
+            return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+        }
+
+        static int32_t cellOf(int32_t cm) {
+            return floorDiv(cm, OCC_CELL_CM);
+        }
+
+        static int32_t tileOf(int32_t cell) {
+            return floorDiv(cell, OCC_TILE_CELLS);
+        }
+
+        static uint16_t cellIndex(int32_t cx, int32_t cy) {
+            return (cy - tileOf(cy) * OCC_TILE_CELLS) * OCC_TILE_CELLS + (cx - tileOf(cx) * OCC_TILE_CELLS);
+        }
+
+        static uint8_t slotOf(int32_t tx, int32_t ty) {
+            int32_t sx = tx % OCC_TILES;
+            int32_t sy = ty % OCC_TILES;
+            if (sx < 0) sx += OCC_TILES;
+            if (sy < 0) sy += OCC_TILES;
+            return sy * OCC_TILES + sx;
+        }
+
+        // La baldosa está dentro de la ventana centrada en el carro
+        bool inWindow(int32_t tx, int32_t ty) const {
+            int32_t centerX = tileOf(cellOf(carX));
+            int32_t centerY = tileOf(cellOf(carY));
+            return abs(tx - centerX) <= OCC_TILES / 2 && abs(ty - centerY) <= OCC_TILES / 2;
+        }
+
+        const Tile* find(int32_t tx, int32_t ty) const {
+            const Tile& tile = tiles[slotOf(tx, ty)];
+            return tile.valid && tile.tx == tx && tile.ty == ty ? &tile : nullptr;
+        }
+
+        bool updateCell(int32_t cx, int32_t cy, int8_t delta) {
+            int32_t tx = tileOf(cx);
+            int32_t ty = tileOf(cy);
+            if (!inWindow(tx, ty)) {
+                return false;
+            }
+            Tile& tile = tiles[slotOf(tx, ty)];
+            if (!tile.valid || tile.tx != tx || tile.ty != ty) {
+                // Baldosa que quedó atrás: se reutiliza para la nueva posición
+                tile = Tile();
+                tile.tx = tx;
+                tile.ty = ty;
+                tile.valid = true;
+            }
+            uint16_t i = cellIndex(cx, cy);
+            int16_t value = tile.cells[i] + delta;
+            value = constrain(value, -OCC_LIMIT, OCC_LIMIT);
+            if (value != tile.cells[i]) {
+                tile.cells[i] = value;
+                if (!(tile.dirty[i / 32] & (1UL << (i % 32)))) {
+                    tile.dirty[i / 32] |= 1UL << (i % 32);
+                    tile.dirtyCount++;
+                }
+            }
+            return true;
+        }
+};
+
+#endif
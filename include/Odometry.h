@@ -0,0 +1,177 @@
+#ifndef ODOMETRY_H
+#define ODOMETRY_H
+
+#include <Arduino.h>
+#include "HardwareController.h"
+
+// Estimación de la posición del carro por navegación a estima.
+// No hay encoders: se integra la velocidad que corresponde al movimiento
+// mandado a los motores, según una tabla de calibración por movimiento
+// (se mide una vez con el carro real). Los motores no alcanzan la velocidad
+// al instante, así que la velocidad sigue a la de la tabla con un retraso
+// de primer orden. En modo continuo la velocidad sale del ciclo útil de
+// cada rueda, proporcional a la calibración de avanzar y de girar.
+// Todo en enteros: posición en µm, rumbo como ángulo binario de 32 bits
+// (2^32 = una vuelta, se envuelve solo) y seno por tabla. Se integra en
+// pasos fijos de ODOM_STEP_US con el rumbo del punto medio del paso.
+
+// Paso de integración
+#ifndef ODOM_STEP_US
+#define ODOM_STEP_US 10000
+#endif
+// Constante de tiempo de los motores al cambiar de movimiento
+#ifndef ODOM_RESPONSE_MS
+#define ODOM_RESPONSE_MS 150
+#endif
+
+class Odometry {
+    public:
+        // Velocidad lineal (mm/s, positiva hacia adelante) y de giro
+        // (grados/s, positiva a la izquierda) de cada movimiento
+        struct Calibration {
+            int16_t mmPerSecond;
+            int16_t degPerSecond;
+        };
+
+        Odometry() {
+            setCalibration(MOTION_STOP, 0, 0);
+            setCalibration(MOTION_FORWARD, 300, 0);
+            setCalibration(MOTION_BACKWARD, -250, 0);
+            setCalibration(MOTION_LEFT, 0, 180);
+            setCalibration(MOTION_RIGHT, 0, -180);
+        }
+
+        void setCalibration(Motion motion, int16_t mmPerSecond, int16_t degPerSecond) {
+            if (motion < MOTION_COUNT) {
+                calibration[motion] = {mmPerSecond, degPerSecond};
+            }
+        }
+
+        // Integra hasta nowUs con la salida anterior y pasa a la nueva
+        void update(Motion motion, uint32_t nowUs) {
+            advance(nowUs);
+            const Calibration& target = calibration[motion < MOTION_COUNT ? motion : MOTION_STOP];
+            targetSpeed = (int32_t)target.mmPerSecond * 1000;
+            targetTurn = (int32_t)target.degPerSecond * 1000;
+        }
+
+        void update(const MotorOutputs& outputs, uint32_t nowUs) {
+            if (!outputs.pwm) {
+                update(outputs.motion, nowUs);
+                return;
+            }
+            advance(nowUs);
+            // Media de las ruedas para avanzar, semidiferencia para girar
+            // (rueda derecha más rápida = giro a la izquierda)
+            int32_t forward = (outputs.left + outputs.right) / 2;
+            int32_t turn = (outputs.right - outputs.left) / 2;
+            targetSpeed = forward >= 0
+                ? (int32_t)calibration[MOTION_FORWARD].mmPerSecond * 10 * forward
+                : (int32_t)calibration[MOTION_BACKWARD].mmPerSecond * 10 * -forward;
+            targetTurn = (int32_t)calibration[MOTION_LEFT].degPerSecond * 10 * turn;
+        }
+
+        void reset() {
+            x = 0;
+            y = 0;
+            heading = 0;
+            speed = 0;
+            turnRate = 0;
+        }
+
+        int32_t xCm() const {
+            return x / 10000;
+        }
+
+        int32_t yCm() const {
+            return y / 10000;
+        }
+
+        // Rumbo en grados, -180..180 (0 = rumbo inicial, positivo a la izquierda)
+        int16_t headingDeg() const {
+            return ((int64_t)(int32_t)heading * 360) >> 32;
+        }
+
+        // Velocidad hacia adelante en cm/s
+        int32_t speedCmPerSecond() const {
+            return speed / 10000;
+        }
+
+    private:
+        static const int32_t STEPS_PER_SECOND = 1000000 / ODOM_STEP_US;
+        static const int32_t RESPONSE_STEPS = ODOM_RESPONSE_MS * 1000L / ODOM_STEP_US;
+
+        Calibration calibration[MOTION_COUNT];
+        int32_t targetSpeed = 0; // µm/s
+        int32_t targetTurn = 0;  // miligrados/s
+        bool started = false;
+        uint32_t lastUs = 0;
+
+        int32_t x = 0;          // µm
+        int32_t y = 0;          // µm
+        uint32_t heading = 0;   // ángulo binario
+        int32_t speed = 0;      // µm/s
+        int32_t turnRate = 0;   // miligrados/s
+
+        void advance(uint32_t nowUs) {
+            if (!started) {
+                started = true;
+                lastUs = nowUs;
+            }
+            while ((int32_t)(nowUs - lastUs) >= ODOM_STEP_US) {
+                step();
+                lastUs += ODOM_STEP_US;
+            }
+        }
+
+        void step() {
+            if (RESPONSE_STEPS > 1) {
+                speed += (targetSpeed - speed) / RESPONSE_STEPS;
+                turnRate += (targetTurn - turnRate) / RESPONSE_STEPS;
+            } else {
+                speed = targetSpeed;
+                turnRate = targetTurn;
+            }
+
+            // Giro de este paso en ángulo binario
+            int32_t turn = ((int64_t)turnRate << 32) / (360000LL * STEPS_PER_SECOND);
+            uint32_t middle = heading + turn / 2;
+            int32_t distance = speed / STEPS_PER_SECOND;
+            x += ((int64_t)distance * cosQ15(middle)) >> 15;
+            y += ((int64_t)distance * sinQ15(middle)) >> 15;
+            heading += turn;
+        }
+
+        // Seno en Q15 de un ángulo binario: cuarto de onda por tabla e
+        // interpolación lineal
+        static int32_t sinQ15(uint32_t angle) {
+            static const int16_t QUARTER[65] = {
+                0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393,
+                7179, 7962, 8739, 9512, 10278, 11039, 11793, 12539, 13279,
+                14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868, 19519,
+                20159, 20787, 21403, 22005, 22594, 23170, 23731, 24279, 24811,
+                25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898,
+                29268, 29621, 29956, 30273, 30571, 30852, 31113, 31356, 31580,
+                31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728,
+                32757, 32767,
+            };
+            uint8_t quadrant = angle >> 30;
+            uint32_t offset = (angle >> 16) & 0x3FFF;
+            if (quadrant & 1) {
+                offset = 0x4000 - offset;
+            }
+            uint32_t index = offset >> 8;
+            int32_t fraction = offset & 0xFF;
+            int32_t value = QUARTER[index];
+            if (index < 64) {
+                value += ((QUARTER[index + 1] - value) * fraction) >> 8;
+            }
+            return quadrant & 2 ? -value : value;
+        }
+
+        static int32_t cosQ15(uint32_t angle) {
+            return sinQ15(angle + 0x40000000UL);
+        }
+};
+
+#endif
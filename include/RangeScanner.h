@@ -0,0 +1,170 @@
+#ifndef RANGE_SCANNER_H
+#define RANGE_SCANNER_H
+
+#include <Arduino.h>
+#include <ESP32Servo.h>
+
+// Barrido del sensor ultrasónico con el servo.
+// El servo recorre el arco de ida y vuelta en pasos fijos y en cada ángulo
+// se toma una lectura. Apenas llega el eco se manda el servo al ángulo
+// siguiente, así el movimiento coincide con la espera que necesita el sensor
+// entre disparos (para que no se cuele el eco anterior); el siguiente disparo
+// sale en cuanto se cumplen las dos cosas. Cada vez que se llega a un extremo
+// del arco el perfil polar queda completo.
+// Mientras el carro avanza el barrido se detiene y el sensor mira al frente
+// para el frenado.
+
+// Arco por defecto, en grados del servo (90 = al frente)
+#ifndef SCAN_MIN_DEG
+#define SCAN_MIN_DEG 30
+#endif
+#ifndef SCAN_MAX_DEG
+#define SCAN_MAX_DEG 150
+#endif
+#ifndef SCAN_STEP_DEG
+#define SCAN_STEP_DEG 10
+#endif
+// Velocidad del servo (SG90: 0.1 s cada 60°) y tiempo para que deje de vibrar
+#ifndef SERVO_US_PER_DEG
+#define SERVO_US_PER_DEG 1700
+#endif
+#ifndef SERVO_SETTLE_US
+#define SERVO_SETTLE_US 8000
+#endif
+// Espera mínima entre disparos del sensor
+#ifndef PING_INTERVAL_US
+#define PING_INTERVAL_US 30000
+#endif
+
+#define SCAN_CENTER_DEG 90
+// Puntos máximos del perfil (pasos de 5° en 180°)
+#define SCAN_MAX_POINTS 37
+
+class RangeScanner {
+    public:
+        void begin(int pin) {
+            ESP32PWM::allocateTimer(0);
+            servo.setPeriodHertz(50);
+            servo.attach(pin, 500, 2400);
+            moveTo(SCAN_CENTER_DEG, micros());
+        }
+
+        // Cambia el arco; el perfil se reinicia
+        void setArc(uint8_t minDeg, uint8_t maxDeg, uint8_t stepDeg) {
+            if (stepDeg == 0 || minDeg >= maxDeg || maxDeg > 180) {
+                return;
+            }
+            if ((maxDeg - minDeg) / stepDeg + 1 > SCAN_MAX_POINTS) {
+                stepDeg = (maxDeg - minDeg + SCAN_MAX_POINTS - 2) / (SCAN_MAX_POINTS - 1);
+            }
+            arcMin = minDeg;
+            arcStep = stepDeg;
+            points = (maxDeg - minDeg) / stepDeg + 1;
+            index = 0;
+            direction = 1;
+            for (uint8_t i = 0; i < SCAN_MAX_POINTS; i++) {
+                ranges[i] = 0;
+            }
+            if (sweeping) {
+                moveTo(angleAt(0), micros());
+            }
+        }
+
+        // Activa el barrido o deja el sensor mirando al frente
+        void setSweeping(bool enabled, uint32_t nowUs) {
+            if (enabled == sweeping) {
+                return;
+            }
+            sweeping = enabled;
+            moveTo(enabled ? angleAt(index) : SCAN_CENTER_DEG, nowUs);
+        }
+
+        bool isSweeping() const {
+            return sweeping;
+        }
+
+        // El servo está quieto y el sensor ya puede disparar
+        bool ready(uint32_t nowUs) const {
+            return (int32_t)(nowUs - readyAt) >= 0;
+        }
+
+        // Ángulo al que apunta el sensor en este momento (si ready())
+        uint8_t angle() const {
+            return targetAngle;
+        }
+
+        // Registra la lectura del ángulo actual (cm, 0 = sin eco) y manda el
+        // servo al siguiente. Devuelve true si con ella se completó un barrido
+        bool record(uint16_t distanceCm, uint32_t nowUs) {
+            if (!sweeping) {
+                readyAt = nowUs + PING_INTERVAL_US;
+                return false;
+            }
+            ranges[index] = distanceCm;
+
+            bool complete = false;
+            if ((direction > 0 && index + 1 >= points) || (direction < 0 && index == 0)) {
+                direction = -direction;
+                complete = true;
+                sweeps++;
+            }
+            if (points > 1) {
+                index += direction;
+            }
+            moveTo(angleAt(index), nowUs);
+            // El disparo siguiente espera al servo y también al sensor
+            if ((int32_t)(nowUs + PING_INTERVAL_US - readyAt) > 0) {
+                readyAt = nowUs + PING_INTERVAL_US;
+            }
+            return complete;
+        }
+
+        // Perfil polar: distancia en cm (0 = sin eco) del punto i, que está
+        // en startAngle() + i * stepAngle() grados
+        const uint16_t* profile() const {
+            return ranges;
+        }
+
+        uint8_t size() const {
+            return points;
+        }
+
+        uint8_t startAngle() const {
+            return arcMin;
+        }
+
+        uint8_t stepAngle() const {
+            return arcStep;
+        }
+
+        // Barridos completos desde el inicio
+        uint32_t sweepCount() const {
+            return sweeps;
+        }
+
+    private:
+        Servo servo;
+        uint8_t arcMin = SCAN_MIN_DEG;
+        uint8_t arcStep = SCAN_STEP_DEG;
+        uint8_t points = (SCAN_MAX_DEG - SCAN_MIN_DEG) / SCAN_STEP_DEG + 1;
+        uint16_t ranges[SCAN_MAX_POINTS] = {};
+        uint8_t index = 0;
+        int8_t direction = 1;
+        bool sweeping = false;
+        uint8_t targetAngle = SCAN_CENTER_DEG;
+        uint32_t readyAt = 0;
+        uint32_t sweeps = 0;
+
+        uint8_t angleAt(uint8_t i) const {
+            return arcMin + i * arcStep;
+        }
+
+        void moveTo(uint8_t angle, uint32_t nowUs) {
+            uint8_t delta = angle > targetAngle ? angle - targetAngle : targetAngle - angle;
+            targetAngle = angle;
+            servo.write(angle);
+            readyAt = nowUs + delta * SERVO_US_PER_DEG + SERVO_SETTLE_US;
+        }
+};
+
+#endif
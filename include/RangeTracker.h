@@ -0,0 +1,175 @@
+#ifndef RANGE_TRACKER_H
+#define RANGE_TRACKER_H
+
+#include <Arduino.h>
+
+// Seguimiento de la distancia al obstáculo a partir del sensor ultrasónico.
+// Un filtro alfa-beta estima la distancia y la velocidad de acercamiento;
+// con ellas se calcula la distancia que necesita el carro para detenerse
+// (reacción + frenado) y se decide si hay que reducir o parar antes de que
+// sea tarde. Una lectura suelta que no cuadra con la predicción se descarta,
+// así un eco falso no detiene el carro.
+
+// Máxima distancia que se considera válida (el HC-SR04 llega a ~400 cm)
+#ifndef RANGE_MAX_CM
+#define RANGE_MAX_CM 400
+#endif
+// Distancia que se quiere dejar libre al detenerse
+#ifndef RANGE_MARGIN_CM
+#define RANGE_MARGIN_CM 20
+#endif
+// Desaceleración del carro al cortar los motores
+#ifndef RANGE_DECEL_CM_S2
+#define RANGE_DECEL_CM_S2 150
+#endif
+// Tiempo que tardan los motores en responder a un cambio de pines
+#ifndef RANGE_MOTOR_RESPONSE_MS
+#define RANGE_MOTOR_RESPONSE_MS 100
+#endif
+// Con menos de este tiempo hasta la zona de frenado se empieza a reducir
+#ifndef RANGE_SLOW_HORIZON_MS
+#define RANGE_SLOW_HORIZON_MS 500
+#endif
+// Diferencia con la predicción a partir de la cual una lectura es sospechosa
+#ifndef RANGE_GATE_CM
+#define RANGE_GATE_CM 25
+#endif
+// Sin lecturas válidas durante este tiempo se olvida la estimación
+#ifndef RANGE_STALE_MS
+#define RANGE_STALE_MS 500
+#endif
+
+enum BrakeLevel {
+    BRAKE_NONE,
+    BRAKE_SLOW,
+    BRAKE_STOP
+};
+
+class RangeTracker {
+    public:
+        // Procesa una lectura (en cm; 0 = sin eco) y devuelve el nivel de frenado
+        BrakeLevel update(long distanceCm, uint32_t nowUs) {
+            float dt = (nowUs - lastUs) / 1e6f;
+            bool valid = distanceCm > 0 && distanceCm <= RANGE_MAX_CM;
+
+            if (dt * 1000 > RANGE_STALE_MS) {
+                reset();
+            }
+            if (!valid) {
+                // Sin eco: no hay nada delante dentro del alcance
+                return tracking ? level() : BRAKE_NONE;
+            }
+
+            if (!tracking) {
+                // Se empieza a seguir con dos lecturas seguidas que coinciden
+                tracking = suspects > 0 && fabsf(distanceCm - range) <= RANGE_GATE_CM;
+                suspects = tracking ? 0 : 1;
+                range = distanceCm;
+                // Sin historia se supone un obstáculo quieto y el carro a la
+                // velocidad que estima la odometría
+                closingSpeed = carSpeed;
+                lastUs = nowUs;
+                return level();
+            }
+            if (dt <= 0) {
+                return level();
+            }
+
+            float predicted = range - closingSpeed * dt;
+            float residual = distanceCm - predicted;
+            if (fabsf(residual) > RANGE_GATE_CM) {
+                // Una lectura aislada se descarta; si se repite es que el
+                // obstáculo cambió (alguien se cruzó) y se acepta tal cual,
+                // conservando la velocidad del carro
+                if (++suspects < 2) {
+                    return level();
+                }
+                range = distanceCm;
+                suspects = 0;
+                updatePeriod(dt);
+                lastUs = nowUs;
+                return level();
+            }
+            suspects = 0;
+
+            range = predicted + ALPHA * residual;
+            closingSpeed -= BETA * residual / dt;
+            if (closingSpeed < 0) {
+                closingSpeed = 0; // alejándose: para frenar da igual cuánto
+            }
+            updatePeriod(dt);
+            lastUs = nowUs;
+            return level();
+        }
+
+        // Distancia estimada al obstáculo en cm
+        float distance() const {
+            return range;
+        }
+
+        // Velocidad de acercamiento estimada en cm/s
+        float speed() const {
+            return closingSpeed;
+        }
+
+        // Segundos hasta el choque a la velocidad actual (infinito si no se acerca)
+        float timeToCollision() const {
+            if (!tracking || closingSpeed <= 0) {
+                return INFINITY;
+            }
+            return range / closingSpeed;
+        }
+
+        // Distancia que recorre el carro desde que se ve el obstáculo hasta que
+        // se detiene: lo que avanza mientras llega la siguiente lectura y
+        // responden los motores, más la de frenado, más el margen
+        float stoppingDistance() const {
+            float reaction = samplePeriod + RANGE_MOTOR_RESPONSE_MS / 1000.0f;
+            return closingSpeed * reaction
+                + closingSpeed * closingSpeed / (2.0f * RANGE_DECEL_CM_S2)
+                + RANGE_MARGIN_CM;
+        }
+
+        void reset() {
+            tracking = false;
+            suspects = 0;
+        }
+
+        // Velocidad del carro hacia adelante (cm/s) según la odometría; se usa
+        // como velocidad de acercamiento inicial al empezar a seguir
+        void setCarSpeed(float cmPerSecond) {
+            carSpeed = cmPerSecond > 0 ? cmPerSecond : 0;
+        }
+
+    private:
+        static constexpr float ALPHA = 0.5f;
+        static constexpr float BETA = 0.2f;
+
+        bool tracking = false;
+        float range = 0;
+        float closingSpeed = 0;
+        float carSpeed = 0;
+        float samplePeriod = 0.02f; // media móvil del periodo entre lecturas
+        uint32_t lastUs = 0;
+        uint8_t suspects = 0;
+
+        void updatePeriod(float dt) {
+            samplePeriod += (dt - samplePeriod) * 0.1f;
+        }
+
+        BrakeLevel level() const {
+            if (!tracking) {
+                return BRAKE_NONE;
+            }
+            float needed = stoppingDistance();
+            if (range <= needed) {
+                return BRAKE_STOP;
+            }
+            if (range - needed <= closingSpeed * RANGE_SLOW_HORIZON_MS / 1000.0f) {
+                return BRAKE_SLOW;
+            }
+            return BRAKE_NONE;
+        }
+};
+
+#endif
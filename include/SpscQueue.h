@@ -0,0 +1,78 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Cola sin bloqueos para un solo productor y un solo consumidor, cada uno en
+// su tarea (o núcleo). Ninguno de los dos lados espera al otro: si la cola
+// está llena el productor se entera y decide qué hacer con el elemento.
+// Los elementos se pueden escribir y leer en su lugar (reserve/commit y
+// front/pop) para no copiar los grandes.
+// N tiene que ser potencia de 2.
+template <typename T, size_t N>
+class SpscQueue {
+    public:
+        static_assert(N >= 2 && (N & (N - 1)) == 0, "N tiene que ser potencia de 2");
+
+        // Productor: copia el elemento; false si la cola está llena
+        bool push(const T& item) {
+            T* slot = reserve();
+            if (!slot) {
+                return false;
+            }
+            *slot = item;
+            commit();
+            return true;
+        }
+
+        // Productor: lugar libre donde escribir el siguiente elemento
+        // (nullptr si la cola está llena); commit() lo publica
+        T* reserve() {
+            uint32_t head = headIndex.load(std::memory_order_relaxed);
+            if (head - tailIndex.load(std::memory_order_acquire) >= N) {
+                return nullptr;
+            }
+            return &items[head & (N - 1)];
+        }
+
+        void commit() {
+            headIndex.store(headIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // Consumidor: copia y quita el primer elemento; false si está vacía
+        bool pop(T& item) {
+            const T* first = front();
+            if (!first) {
+                return false;
+            }
+            item = *first;
+            pop();
+            return true;
+        }
+
+        // Consumidor: primer elemento sin quitarlo (nullptr si está vacía)
+        const T* front() const {
+            uint32_t tail = tailIndex.load(std::memory_order_relaxed);
+            if (headIndex.load(std::memory_order_acquire) == tail) {
+                return nullptr;
+            }
+            return &items[tail & (N - 1)];
+        }
+
+        // Consumidor: quita el primer elemento (que tiene que existir)
+        void pop() {
+            tailIndex.store(tailIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        size_t size() const {
+            return headIndex.load(std::memory_order_acquire) - tailIndex.load(std::memory_order_acquire);
+        }
+
+    private:
+        T items[N];
+        std::atomic<uint32_t> headIndex{0};
+        std::atomic<uint32_t> tailIndex{0};
+};
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef STATE_ENCODER_H
+#define STATE_ENCODER_H
+
+#include <Arduino.h>
+
+// Telemetría del estado del carro por diferencias.
+// El estado (comando, distancia, posición, motores, tiempo de loop) cambia
+// poco entre una trama y la siguiente, así que en lugar de mandarlo entero se
+// mandan solo los campos que cambiaron respecto de una referencia, como
+// varints en zigzag. La referencia es la última trama que el servidor
+// confirmó con {"ack":seq} o, si no confirma, el último keyframe; cada
+// STATE_KEYFRAME_INTERVAL tramas va un keyframe completo para recuperarse si
+// se perdió algo.
+// Trama (binaria): 'S', banderas (bit 0 = keyframe), seq (varint), en las
+// diferencias seq - seq de la referencia (varint), máscara de campos
+// presentes (varint, bit i = campo i) y un varint zigzag por campo presente:
+// valor - referencia (en el keyframe la referencia es 0).
+
+enum StateField : uint8_t {
+    STATE_ACTION,     // CommandAction en curso
+    STATE_MOTION,     // Motion aplicado (MOTION_COUNT en modo continuo)
+    STATE_LEFT,       // Ciclo útil rueda izquierda (modo continuo)
+    STATE_RIGHT,      // Ciclo útil rueda derecha (modo continuo)
+    STATE_DISTANCE,   // cm al obstáculo del frente
+    STATE_X,          // cm
+    STATE_Y,          // cm
+    STATE_HEADING,    // grados
+    STATE_SPEED,      // cm/s
+    STATE_LOOP_US,    // Duración de la última vuelta de control
+    STATE_FIELD_COUNT
+};
+
+struct StateSnapshot {
+    int32_t values[STATE_FIELD_COUNT];
+};
+
+// Cada cuántas tramas se manda un keyframe completo
+#ifndef STATE_KEYFRAME_INTERVAL
+#define STATE_KEYFRAME_INTERVAL 50
+#endif
+// Tramas recientes que se recuerdan para poder usarlas de referencia al
+// llegar su confirmación
+#define STATE_HISTORY 8
+// Trama más larga: cabecera + un varint de 5 bytes por campo
+#define STATE_FRAME_MAX_BYTES (2 + 5 + 5 + 3 + 5 * STATE_FIELD_COUNT)
+
+class StateEncoder {
+    public:
+        // Vuelve a empezar con un keyframe (conexión nueva)
+        void reset() {
+            hasReference = false;
+        }
+
+        // Escribe la trama del estado en buffer (STATE_FRAME_MAX_BYTES) y
+        // devuelve su largo
+        size_t encode(const StateSnapshot& snapshot, uint8_t* buffer) {
+            uint32_t seq = ++lastSeq;
+            bool keyframe = !hasReference || sinceKeyframe >= STATE_KEYFRAME_INTERVAL;
+            size_t used = 0;
+            buffer[used++] = 'S';
+            buffer[used++] = keyframe ? 1 : 0;
+            used += writeVarint(buffer + used, seq);
+            if (!keyframe) {
+                used += writeVarint(buffer + used, seq - referenceSeq);
+            }
+            uint32_t mask = 0;
+            for (uint8_t i = 0; i < STATE_FIELD_COUNT; i++) {
+                int32_t base = keyframe ? 0 : reference.values[i];
+                if (snapshot.values[i] != base) {
+                    mask |= 1UL << i;
+                }
+            }
+            used += writeVarint(buffer + used, mask);
+            for (uint8_t i = 0; i < STATE_FIELD_COUNT; i++) {
+                if (mask & (1UL << i)) {
+                    int32_t base = keyframe ? 0 : reference.values[i];
+                    used += writeVarint(buffer + used, zigzag((int32_t)((uint32_t)snapshot.values[i] - (uint32_t)base)));
+                }
+            }
+
+            // Recordar la trama por si la confirman
+            history[seq % STATE_HISTORY] = snapshot;
+            historySeq[seq % STATE_HISTORY] = seq;
+            if (keyframe) {
+                reference = snapshot;
+                referenceSeq = seq;
+                hasReference = true;
+                sinceKeyframe = 0;
+            }
+            sinceKeyframe++;
+            return used;
+        }
+
+        // El servidor confirmó la trama seq: pasa a ser la referencia si
+        // todavía se recuerda y es más nueva que la actual
+        void acknowledge(uint32_t seq) {
+            if (!hasReference || (int32_t)(seq - referenceSeq) <= 0 || (int32_t)(lastSeq - seq) < 0) {
+                return;
+            }
+            if (historySeq[seq % STATE_HISTORY] != seq) {
+                return;
+            }
+            reference = history[seq % STATE_HISTORY];
+            referenceSeq = seq;
+        }
+
+    private:
+        StateSnapshot reference = {};
+        uint32_t referenceSeq = 0;
+        bool hasReference = false;
+        uint32_t lastSeq = 0;
+        uint32_t sinceKeyframe = 0;
+        StateSnapshot history[STATE_HISTORY] = {};
+        uint32_t historySeq[STATE_HISTORY] = {};
+
+        static uint32_t zigzag(int32_t value) {
+            return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+        }
+
+        static size_t writeVarint(uint8_t* buffer, uint32_t value) {
+            size_t used = 0;
+            while (value >= 0x80) {
+                buffer[used++] = (value & 0x7F) | 0x80;
+                value >>= 7;
+            }
+            buffer[used++] = value;
+            return used;
+        }
+};
+
+#endif
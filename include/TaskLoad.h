@@ -0,0 +1,91 @@
+#ifndef TASK_LOAD_H
+#define TASK_LOAD_H
+
+#include <Arduino.h>
+
+// Uso de CPU de una tarea periódica.
+// La tarea marca begin()/end() alrededor de su trabajo; con eso se calcula el
+// porcentaje del tiempo que estuvo ocupada, el peor tiempo de una vuelta y
+// cuántas veces se pasó de su periodo (plazo incumplido), contando también
+// las vueltas que empezaron tarde porque otra tarea no la dejó correr.
+class TaskLoad {
+    public:
+        explicit TaskLoad(uint32_t periodUs) : periodUs(periodUs) {}
+
+        void begin() {
+            uint32_t now = micros();
+            if (started && now - lastBegin > periodUs + periodUs / 2) {
+                late++;
+            }
+            if (!started) {
+                windowStart = now;
+                started = true;
+            }
+            lastBegin = now;
+        }
+
+        void end() {
+            uint32_t busy = micros() - lastBegin;
+            lastBusy = busy;
+            busyUs += busy;
+            iterations++;
+            if (busy > worstUs) {
+                worstUs = busy;
+            }
+            if (busy > periodUs) {
+                overruns++;
+            }
+        }
+
+        // Duración de la última vuelta completa
+        uint32_t lastBusyUs() const {
+            return lastBusy;
+        }
+
+        // Contadores desde el reporte anterior
+        uint32_t iterationCount() const {
+            return iterations;
+        }
+
+        uint32_t overrunCount() const {
+            return overruns;
+        }
+
+        uint32_t lateCount() const {
+            return late;
+        }
+
+        // Imprime el uso desde el reporte anterior y reinicia los contadores
+        void report(Print& out, const char* name) {
+            uint32_t elapsed = micros() - windowStart;
+            uint32_t percent = elapsed ? (uint32_t)((uint64_t)busyUs * 1000 / elapsed) : 0;
+            out.printf("%s: cpu=%u.%u%% vueltas=%u peor=%uus excedidas=%u tarde=%u\n",
+                name,
+                (unsigned)(percent / 10),
+                (unsigned)(percent % 10),
+                (unsigned)iterations,
+                (unsigned)worstUs,
+                (unsigned)overruns,
+                (unsigned)late);
+            windowStart = micros();
+            busyUs = 0;
+            iterations = 0;
+            worstUs = 0;
+            overruns = 0;
+            late = 0;
+        }
+
+    private:
+        uint32_t periodUs;
+        bool started = false;
+        uint32_t windowStart = 0;
+        uint32_t lastBegin = 0;
+        uint32_t lastBusy = 0;
+        uint32_t busyUs = 0;
+        uint32_t iterations = 0;
+        uint32_t worstUs = 0;
+        uint32_t overruns = 0;
+        uint32_t late = 0;
+};
+
+#endif
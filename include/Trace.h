@@ -0,0 +1,145 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Registro binario de eventos con marca de ciclos de CPU.
+// Cualquier tarea o ISR puede escribir sin bloqueo: reserva una posición con un
+// incremento atómico y la marca como completa al final. Una tarea de baja
+// prioridad vacía el buffer por serial en registros de 20 bytes precedidos por
+// 0xA5 0x5A; tools/trace_to_perfetto.py los convierte en una línea de tiempo.
+// Se activa con -DSUPERCARRO_TRACE; sin la bandera TRACE() no genera código.
+
+enum TraceEvent : uint16_t {
+    TRACE_LOOP_START = 1,
+    TRACE_LOOP_END,
+    TRACE_DISTANCE,          // arg0: distancia en cm
+    TRACE_COMMAND_RECEIVED,  // arg0: seq, arg1: largo del mensaje
+    TRACE_COMMAND_APPLIED,   // arg0: latencia en us
+    TRACE_WALL_STOP,         // arg0: distancia en cm
+    TRACE_OVERRUN            // arg0: registros perdidos
+};
+
+// Los campos son atómicos relajados (en el ESP32 son cargas y guardados
+// comunes): el lector puede copiarlos mientras un escritor que dio la vuelta los
+// pisa, y lo descubre después al releer commit
+struct TraceRecord {
+    std::atomic<uint32_t> commit;  // índice + 1 cuando el registro está completo
+    std::atomic<uint32_t> cycles;
+    std::atomic<uint16_t> event;
+    std::atomic<uint16_t> core;
+    std::atomic<uint32_t> arg0;
+    std::atomic<uint32_t> arg1;
+};
+
+class TraceBuffer {
+    public:
+        // Debe ser potencia de dos
+        static const uint32_t CAPACITY = 512;
+
+        void IRAM_ATTR write(uint16_t event, uint32_t arg0 = 0, uint32_t arg1 = 0) {
+            uint32_t index = head.fetch_add(1, std::memory_order_relaxed);
+            TraceRecord& record = records[index & (CAPACITY - 1)];
+            record.commit.store(0, std::memory_order_relaxed);
+            // Que nadie vea los campos nuevos con el commit viejo
+            std::atomic_thread_fence(std::memory_order_release);
+            record.cycles.store(ESP.getCycleCount(), std::memory_order_relaxed);
+            record.event.store(event, std::memory_order_relaxed);
+            record.core.store(xPortGetCoreID(), std::memory_order_relaxed);
+            record.arg0.store(arg0, std::memory_order_relaxed);
+            record.arg1.store(arg1, std::memory_order_relaxed);
+            record.commit.store(index + 1, std::memory_order_release);
+        }
+
+        // Copia hasta maxRecords registros completos a la salida; devuelve cuántos
+        size_t drain(Print& out, size_t maxRecords = CAPACITY) {
+            size_t written = 0;
+            while (written < maxRecords) {
+                uint32_t end = head.load(std::memory_order_acquire);
+                if (tail == end) {
+                    break;
+                }
+                // El escritor dio la vuelta: se perdieron los más viejos
+                if (end - tail > CAPACITY) {
+                    uint32_t lost = end - tail - CAPACITY;
+                    tail = end - CAPACITY;
+                    emit(out, TRACE_OVERRUN, ESP.getCycleCount(), xPortGetCoreID(), lost, 0);
+                    written++;
+                    continue;
+                }
+                TraceRecord& record = records[tail & (CAPACITY - 1)];
+                if (record.commit.load(std::memory_order_acquire) != tail + 1) {
+                    // Todavía se está escribiendo
+                    break;
+                }
+                uint32_t cycles = record.cycles.load(std::memory_order_relaxed);
+                uint16_t event = record.event.load(std::memory_order_relaxed);
+                uint16_t core = record.core.load(std::memory_order_relaxed);
+                uint32_t arg0 = record.arg0.load(std::memory_order_relaxed);
+                uint32_t arg1 = record.arg1.load(std::memory_order_relaxed);
+                // Una carga acquire no impide que las copias de arriba se corran
+                // después de ella; la barrera sí
+                std::atomic_thread_fence(std::memory_order_acquire);
+                // Si lo sobrescribieron mientras se copiaba, se reintenta
+                if (record.commit.load(std::memory_order_relaxed) != tail + 1) {
+                    continue;
+                }
+                emit(out, event, cycles, core, arg0, arg1);
+                tail++;
+                written++;
+            }
+            return written;
+        }
+
+        static TraceBuffer& instance() {
+            static TraceBuffer buffer;
+            return buffer;
+        }
+
+    private:
+        std::atomic<uint32_t> head{0};
+        uint32_t tail = 0;
+        TraceRecord records[CAPACITY];
+
+        static void emit(Print& out, uint16_t event, uint32_t cycles, uint16_t core, uint32_t arg0, uint32_t arg1) {
+            uint8_t frame[2 + 16];
+            frame[0] = 0xA5;
+            frame[1] = 0x5A;
+            memcpy(frame + 2, &cycles, 4);
+            memcpy(frame + 6, &event, 2);
+            memcpy(frame + 8, &core, 2);
+            memcpy(frame + 10, &arg0, 4);
+            memcpy(frame + 14, &arg1, 4);
+            out.write(frame, sizeof(frame));
+        }
+};
+
+#ifdef SUPERCARRO_TRACE
+
+#define TRACE(event, ...) TraceBuffer::instance().write(event, ##__VA_ARGS__)
+
+// Tarea de baja prioridad que vacía el buffer por serial
+static void traceDrainTask(void* parameters) {
+    Print* out = (Print*)parameters;
+    for (;;) {
+        TraceBuffer::instance().drain(*out, 64);
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+}
+
+static inline void traceBegin(Print& out) {
+    xTaskCreatePinnedToCore(traceDrainTask, "trace", 2048, &out, 1, NULL, 0);
+}
+
+#else
+
+#define TRACE(event, ...) do {} while (0)
+
+static inline void traceBegin(Print& out) {
+    (void)out;
+}
+
+#endif
+
+#endif
@@ -5,12 +5,114 @@
 #include <ArduinoJson.h>
 #include <Arduino.h>
 #include <WiFi.h>
+#include <WiFiUdp.h>
 #include <string>
+#include "AllocTracker.h"
+#include "Trace.h"
+#include "Logger.h"
+#include "CommandSequence.h"
+#include "SpscQueue.h"
+#include "LinkWatchdog.h"
+#include "CommandParser.h"
+#include "LzCodec.h"
+#include "StateEncoder.h"
 
 using namespace websockets;
 
+// Tamaño del mensaje con el perfil del barrido
+#define SCAN_JSON_MAX_POINTS 37
+#define SCAN_JSON_BUFFER 256
+// Mayor mensaje binario que se puede encolar
+#define TELEMETRY_MAX_BYTES 512
+// Telemetría comprimida (si el servidor la pidió con {"compress":true}): solo
+// se comprimen las tramas de al menos este largo, y solo se mandan
+// comprimidas si se ahorran al menos TELEMETRY_COMPRESS_MIN_SAVING bytes
+#define TELEMETRY_COMPRESS_MIN_BYTES 32
+#define TELEMETRY_COMPRESS_MIN_SAVING 8
+// Puerto UDP donde se escuchan comandos (0 = sin canal UDP). Por UDP llegan
+// los mismos JSON que por el WebSocket, con "seq" obligatorio; un comando
+// perdido no se retransmite y uno que llega después de otro más nuevo se
+// descarta, así un paquete perdido no frena a los siguientes como en TCP.
+// Por eso el servidor tiene que repetir el comando vigente con seq nuevo
+// (también STOP); si deja de llegar todo, el watchdog para los motores.
+// El WebSocket sigue para la configuración y la telemetría.
+#ifndef UDP_COMMAND_PORT
+#define UDP_COMMAND_PORT 5001
+#endif
+#define UDP_COMMAND_MAX_BYTES 256
+// Cabecera de la trama comprimida: 'Z', 'T' (texto) o 'B' (binario) y el
+// largo original en 16 bits little endian; después el bloque de LzCodec.
+// En minúscula ('t'/'b') el servidor tiene que vaciar la historia antes de
+// descomprimir; desde ahí agrega cada trama de telemetría, comprimida o no
+#define TELEMETRY_COMPRESS_HEADER 4
+// Cada cuánto se reintenta la conexión con el servidor si se cayó
+#ifndef WS_RECONNECT_INTERVAL_MS
+#define WS_RECONNECT_INTERVAL_MS 3000
+#endif
+
+enum CommandMode : uint8_t {
+    COMMAND_STATE,  // {"state":"FORWARD"}: movimiento todo o nada
+    COMMAND_ARCADE, // {"throttle":80,"steering":-20}: -100..100
+    COMMAND_TANK    // {"left":60,"right":90}: -100..100 por rueda
+};
+
+// Estados del modo COMMAND_STATE, ya reconocidos en la tarea de red
+enum CommandAction : uint8_t {
+    ACTION_NONE,
+    ACTION_FORWARD,
+    ACTION_BACKWARD,
+    ACTION_STOP,
+    ACTION_LEFT,
+    ACTION_RIGHT,
+    ACTION_LIGHT_ON,
+    ACTION_LIGHT_OFF,
+    ACTION_DRIVE, // Lo usa la tarea de control mientras maneja en modo continuo
+    ACTION_COUNT
+};
+
+static const char* const ACTION_NAMES[ACTION_COUNT] = {
+    "", "FORWARD", "BACKWARD", "STOP", "LEFT", "RIGHT", "LIGHT_ON", "LIGHT_OFF", "DRIVE"
+};
+
+// Comando recibido del servidor, de la tarea de red a la de control
+struct Command {
+    CommandMode mode;
+    CommandAction action;
+    int8_t throttle;
+    int8_t steering;
+    int8_t left;
+    int8_t right;
+    uint32_t seq;
+    uint32_t receivedAt; // micros() al llegar
+};
+
+enum TelemetryKind : uint8_t {
+    TELEMETRY_STATE,
+    TELEMETRY_SCAN,
+    TELEMETRY_BINARY,
+    TELEMETRY_TEXT
+};
+
+// Mensaje de telemetría, de la tarea de control a la de red
+struct TelemetryMessage {
+    TelemetryKind kind;
+    uint16_t length;
+    union {
+        StateSnapshot state;
+        struct {
+            uint8_t start;
+            uint8_t step;
+            uint8_t count;
+            uint16_t cm[SCAN_JSON_MAX_POINTS];
+        } scan;
+        uint8_t bytes[TELEMETRY_MAX_BYTES];
+    };
+};
+
 WebsocketsClient client;
 
+// La conexión la atiende la tarea de red (begin() y loop()); la tarea de
+// control solo toma comandos y encola telemetría, sin tocar el socket.
 class WebSocketController {
 public:
     // Constructor de la clase
@@ -27,65 +129,159 @@ public:
 
     // Método para iniciar la conexión WiFi y WebSocket
     void begin() {
+        // Ejecuta un callback cuando se reciben mensajes. La librería le pasa
+        // el mensaje por valor, así que en el ESP32 el contenido se copia una
+        // vez al llamarlo (en el host el shim lo mueve); de ahí en adelante
+        // handleFrame() lo lee en su lugar, sin más copias
+        client.onMessage([&](const WebsocketsMessage& message){
+            handleFrame(message.c_str(), message.length(), false);
+        });
+
         WiFi.begin(SSID, PASSWORD);
 
         // Intento de conexión a WiFi con reintentos
         for (int i = 0; i < 10 && WiFi.status() != WL_CONNECTED; i++) {
-            Serial.print(".");
+            LOG_DEBUG("Esperando WiFi (%d)", i);
             delay(1000);
         }
 
         // Comprobación de conexión WiFi
         if (WiFi.status() == WL_CONNECTED) {
-            Serial.print("Se estableció la conexión a: ");
-            Serial.println(SSID);
+            LOG_INFO("Se estableció la conexión a: %s", SSID);
         } else {
-            Serial.print("No se pudo conectar a: ");
-            Serial.println(SSID);
+            LOG_ERROR("No se pudo conectar a: %s", SSID);
             return;
         }
 
-        // Intentar conectarse al servidor de Websockets
-        bool connected = client.connect(WebSocketServerHost, WebSocketServerPort, "/ws");
-        if (connected) {
-            Serial.println("¡Conectado al servidor WebSocket!");
+#if UDP_COMMAND_PORT
+        // Canal UDP de comandos: solo se aceptan paquetes del servidor
+        serverAddress.fromString(WebSocketServerHost);
+        if (udp.begin(UDP_COMMAND_PORT)) {
+            LOG_INFO("Comandos por UDP en el puerto %u", (unsigned)UDP_COMMAND_PORT);
         } else {
-            Serial.println("¡No se pudo conectar al servidor WebSocket!");
-        }
-
-        // Ejecuta un callback cuando se reciben mensajes
-        // Dentro de la configuración del callback onMessage
-        client.onMessage([&](WebsocketsMessage message){
-            // Crear un objeto JSON en memoria
-            StaticJsonDocument<200> jsonDoc;
-            // Analizar el mensaje JSON
-            DeserializationError error = deserializeJson(jsonDoc, message.data());
-            // Verificar si hubo un error al analizar el JSON
-            if (error) {
-                Serial.print("Error al analizar JSON: ");
-                Serial.println(error.c_str());
-                return;
-            }
-            // Extraer el valor de "state" del JSON
-            state = jsonDoc["state"];
-            if (state) {
-                Serial.print("Estado recibido: ");
-                Serial.println(state);
-            } else {
-                Serial.println("El campo 'state' no está presente en el JSON.");
-            }
-        });
+            LOG_ERROR("No se pudo abrir el puerto UDP %u", (unsigned)UDP_COMMAND_PORT);
+        }
+#endif
+
+        // Intentar conectarse al servidor de Websockets; si falla, loop() reintenta
+        connectServer();
     };
 
+    // Avisa al watchdog de cada comando o latido ({"heartbeat":...}) recibido
+    // y le pasa el plazo que pida el servidor ({"watchdog_ms":N}); cada
+    // conexión nueva lo desarma hasta la primera trama
+    void watch(LinkWatchdog& linkWatchdog) {
+        watchdog = &linkWatchdog;
+    }
+
+    // Lo llama la tarea de red: recibe comandos y envía la telemetría encolada
     void loop() {
+        ALLOC_SCOPE(ALLOC_NETWORK);
+#if UDP_COMMAND_PORT
+        // Primero los comandos por UDP: no esperan a que TCP retransmita nada
+        pollUdp();
+#endif
         // Permite al cliente de Websockets comprobar mensajes entrantes
         if(client.available()) {
             client.poll();
+        } else if (WiFi.status() == WL_CONNECTED && millis() - lastConnectAttempt >= WS_RECONNECT_INTERVAL_MS) {
+            connectServer();
+        }
+        if (watchdog && client.available() && !watchdog->isArmed()) {
+            LOG_EVERY(LOG_LEVEL_WARN, 5000, "Watchdog del enlace desarmado: si se corta, los motores siguen con lo último");
+        }
+        while (const TelemetryMessage* message = telemetry.front()) {
+            if (client.available()) {
+                sendTelemetry(*message);
+            }
+            telemetry.pop();
         }
     };
 
-    const char* get_state(){
-        return state;
+    // Las funciones send_* encolan la telemetría para la tarea de red y no
+    // esperan; si la cola está llena el mensaje se descarta y se cuenta
+
+    // Perfil polar del último barrido del sensor:
+    // {"type":"scan","start":30,"step":10,"cm":[...]}
+    void send_scan(uint8_t startAngle, uint8_t stepAngle, const uint16_t* ranges, uint8_t count) {
+        TelemetryMessage* message = reserveTelemetry(TELEMETRY_SCAN);
+        if (!message) {
+            return;
+        }
+        message->scan.start = startAngle;
+        message->scan.step = stepAngle;
+        message->scan.count = count < SCAN_JSON_MAX_POINTS ? count : SCAN_JSON_MAX_POINTS;
+        memcpy(message->scan.cm, ranges, message->scan.count * sizeof(uint16_t));
+        telemetry.commit();
+    }
+
+    // Estado del carro; la tarea de red lo manda como diferencias (StateEncoder)
+    void send_state(const StateSnapshot& snapshot) {
+        TelemetryMessage* message = reserveTelemetry(TELEMETRY_STATE);
+        if (!message) {
+            return;
+        }
+        message->state = snapshot;
+        telemetry.commit();
+    }
+
+    // Mensaje binario (mapa de ocupación)
+    void send_binary(const uint8_t* data, size_t length) {
+        if (length > TELEMETRY_MAX_BYTES) {
+            return;
+        }
+        TelemetryMessage* message = reserveTelemetry(TELEMETRY_BINARY);
+        if (!message) {
+            return;
+        }
+        message->length = length;
+        memcpy(message->bytes, data, length);
+        telemetry.commit();
+    }
+
+    // Mensaje de texto ya armado (reporte del heap)
+    void send_text(const char* data, size_t length) {
+        if (length > TELEMETRY_MAX_BYTES) {
+            return;
+        }
+        TelemetryMessage* message = reserveTelemetry(TELEMETRY_TEXT);
+        if (!message) {
+            return;
+        }
+        message->length = length;
+        memcpy(message->bytes, data, length);
+        telemetry.commit();
+    }
+
+    // Tarea de control: saca el siguiente comando recibido; false si no hay
+    bool take_command(Command& command) {
+        return commands.pop(command);
+    }
+
+    // Devuelve y reinicia el contador de comandos perdidos
+    uint32_t take_dropped_commands() {
+        return droppedCommands.exchange(0);
+    }
+
+    // Tarea de red: bytes de telemetría antes y después de comprimir desde
+    // el reporte anterior, y el tiempo que llevó comprimir
+    void report_telemetry(Print& out) {
+        out.printf("Telemetría: %u B -> %u B, comprimidas=%u sin comprimir=%u, %uus comprimiendo\n",
+            (unsigned)telemetryBytes,
+            (unsigned)sentBytes,
+            (unsigned)compressedFrames,
+            (unsigned)plainFrames,
+            (unsigned)compressUs);
+        telemetryBytes = 0;
+        sentBytes = 0;
+        compressedFrames = 0;
+        plainFrames = 0;
+        compressUs = 0;
+    }
+
+    // Telemetría descartada por cola llena desde el inicio
+    uint32_t dropped_telemetry() const {
+        return droppedTelemetry;
     }
 
     private:
@@ -93,7 +289,248 @@ public:
         const char* PASSWORD;
         const char* WebSocketServerHost;
         const uint16_t WebSocketServerPort;
-        const char* state;
+        CommandSequence tcpSequence{false};
+        CommandSequence udpSequence{true};
+        WiFiUDP udp;
+        IPAddress serverAddress;
+        LinkWatchdog* watchdog = nullptr;
+        std::atomic<uint32_t> droppedCommands{0};
+        std::atomic<uint32_t> droppedTelemetry{0};
+        SpscQueue<Command, 8> commands;
+        SpscQueue<TelemetryMessage, 4> telemetry;
+        // Solo los usa la tarea de red
+        LzCodec codec;
+        StateEncoder stateEncoder;
+        bool compressTelemetry = false;
+        bool historyReset = false; // La próxima trama comprimida reinicia la historia
+        uint32_t telemetryBytes = 0;
+        uint32_t sentBytes = 0;
+        uint32_t compressedFrames = 0;
+        uint32_t plainFrames = 0;
+        uint32_t compressUs = 0;
+        unsigned long lastConnectAttempt = 0;
+
+        // Conecta con el servidor. Del otro lado puede haber un servidor
+        // nuevo: la historia de la compresión, las diferencias de estado y
+        // las secuencias de comandos vuelven a empezar
+        bool connectServer() {
+            lastConnectAttempt = millis();
+            if (!client.connect(WebSocketServerHost, WebSocketServerPort, "/ws")) {
+                LOG_EVERY(LOG_LEVEL_ERROR, 60000, "¡No se pudo conectar al servidor WebSocket!");
+                return false;
+            }
+            LOG_INFO("¡Conectado al servidor WebSocket!");
+            codec.reset();
+            compressTelemetry = false;
+            historyReset = false;
+            stateEncoder.reset();
+            tcpSequence.reset();
+            udpSequence.reset();
+            // El plazo lo vuelve a dar la primera trama del servidor nuevo
+            if (watchdog) {
+                watchdog->disarm();
+            }
+            return true;
+        }
+
+        // Procesa una trama de texto. data solo vale durante la llamada: el
+        // comando se saca directamente de ahí y se escribe en su lugar de la
+        // cola hacia la tarea de control, sin copias intermedias
+        void handleFrame(const char* data, size_t length, bool fromUdp) {
+            ALLOC_SCOPE(ALLOC_JSON);
+            // Una sola pasada sobre el texto, sin documento JSON: solo se
+            // sacan las claves que usa el carro
+            CommandFields fields;
+            if (!CommandParser::parse(data, length, fields)) {
+                LOG_EVERY(LOG_LEVEL_WARN, 1000, "Error al analizar JSON (%u bytes)", (unsigned)length);
+                return;
+            }
+            // Cualquier mensaje válido muestra que el enlace sigue vivo y arma
+            // el watchdog: con el plazo de comandos, el de latidos o el que
+            // fije el servidor
+            if (watchdog) {
+                if (fields.has(FIELD_WATCHDOG)) {
+                    watchdog->setTimeout(fields.watchdogMs, micros());
+                    if (fields.watchdogMs) {
+                        LOG_INFO("Watchdog del enlace: %u ms", (unsigned)fields.watchdogMs);
+                    } else {
+                        LOG_WARN("El servidor desarmó el watchdog del enlace hasta la próxima conexión");
+                    }
+                }
+                if (fields.has(FIELD_HEARTBEAT)) {
+                    watchdog->heartbeat(micros());
+                } else {
+                    watchdog->feed(micros());
+                }
+            }
+            if (fields.has(FIELD_COMPRESS) && fields.compress != compressTelemetry) {
+                compressTelemetry = fields.compress;
+                codec.reset();
+                historyReset = true;
+                // El servidor empieza a decodificar de cero: el próximo estado va completo
+                stateEncoder.reset();
+                LOG_INFO("Telemetría comprimida: %s", compressTelemetry ? "sí" : "no");
+            }
+            if (fields.has(FIELD_ACK)) {
+                stateEncoder.acknowledge(fields.ack);
+            }
+            if (fields.has(FIELD_HEARTBEAT)) {
+                return;
+            }
+            CommandAction action = ACTION_NONE;
+            if (fields.has(FIELD_STATE)) {
+                action = actionOf(fields.state, fields.stateLength);
+                if (action == ACTION_NONE) {
+                    LOG_EVERY(LOG_LEVEL_WARN, 1000, "Estado desconocido: %.*s", (int)fields.stateLength, fields.state);
+                    return;
+                }
+            } else if (!fields.has(FIELD_THROTTLE) && !fields.has(FIELD_LEFT)) {
+                if (fields.has(FIELD_COMPRESS) || fields.has(FIELD_ACK) || fields.has(FIELD_WATCHDOG)) {
+                    return;
+                }
+                LOG_EVERY(LOG_LEVEL_WARN, 1000, "El JSON no trae 'state' ni valores de manejo.");
+                return;
+            }
+
+            uint32_t seq = fields.seq;
+            CommandSequence& sequence = fromUdp ? udpSequence : tcpSequence;
+            uint32_t lost = 0;
+            // Un comando más viejo que el último ya no vale (UDP puede desordenar)
+            if (!sequence.accept(seq, lost)) {
+                LOG_EVERY(LOG_LEVEL_DEBUG, 1000, "%s: comando %u fuera de orden (último %u)",
+                    fromUdp ? "UDP" : "TCP", (unsigned)seq, (unsigned)sequence.last());
+                return;
+            }
+            // Huecos en la secuencia del servidor: comandos perdidos en el camino
+            droppedCommands += lost;
+            // Si la tarea de control no alcanza a vaciar la cola el comando se pierde
+            Command* command = commands.reserve();
+            if (!command) {
+                droppedCommands++;
+                return;
+            }
+            *command = {};
+            // El estado, o los valores del modo continuo
+            if (action != ACTION_NONE) {
+                command->mode = COMMAND_STATE;
+                command->action = action;
+            } else if (fields.has(FIELD_THROTTLE)) {
+                command->mode = COMMAND_ARCADE;
+                command->throttle = constrain(fields.throttle, -100, 100);
+                command->steering = constrain(fields.steering, -100, 100);
+            } else {
+                command->mode = COMMAND_TANK;
+                command->left = constrain(fields.left, -100, 100);
+                command->right = constrain(fields.right, -100, 100);
+            }
+            command->seq = seq;
+            command->receivedAt = micros();
+            TRACE(TRACE_COMMAND_RECEIVED, seq, length);
+            LOG_DEBUG("Comando recibido: %s %d %d", ACTION_NAMES[command->action],
+                command->mode == COMMAND_TANK ? command->left : command->throttle,
+                command->mode == COMMAND_TANK ? command->right : command->steering);
+            commands.commit();
+        }
+
+        void pollUdp() {
+            while (int size = udp.parsePacket()) {
+                if (udp.remoteIP() != serverAddress || size > UDP_COMMAND_MAX_BYTES) {
+                    continue;
+                }
+                char buffer[UDP_COMMAND_MAX_BYTES];
+                int length = udp.read(buffer, sizeof(buffer));
+                if (length <= 0) {
+                    continue;
+                }
+                handleFrame(buffer, length, true);
+            }
+        }
+
+        static CommandAction actionOf(const char* state, size_t length) {
+            for (uint8_t action = ACTION_FORWARD; action < ACTION_DRIVE; action++) {
+                const char* name = ACTION_NAMES[action];
+                if (strlen(name) == length && memcmp(name, state, length) == 0) {
+                    return (CommandAction)action;
+                }
+            }
+            return ACTION_NONE;
+        }
+
+        TelemetryMessage* reserveTelemetry(TelemetryKind kind) {
+            TelemetryMessage* message = telemetry.reserve();
+            if (!message) {
+                droppedTelemetry++;
+                return nullptr;
+            }
+            message->kind = kind;
+            message->length = 0;
+            return message;
+        }
+
+        void sendTelemetry(const TelemetryMessage& message) {
+            ALLOC_SCOPE(ALLOC_TELEMETRY);
+            if (message.kind == TELEMETRY_SCAN) {
+                StaticJsonDocument<JSON_OBJECT_SIZE(4) + JSON_ARRAY_SIZE(SCAN_JSON_MAX_POINTS)> jsonDoc;
+                jsonDoc["type"] = "scan";
+                jsonDoc["start"] = message.scan.start;
+                jsonDoc["step"] = message.scan.step;
+                JsonArray cm = jsonDoc.createNestedArray("cm");
+                for (uint8_t i = 0; i < message.scan.count; i++) {
+                    cm.add(message.scan.cm[i]);
+                }
+                char buffer[SCAN_JSON_BUFFER];
+                size_t length = serializeJson(jsonDoc, buffer, sizeof(buffer));
+                sendFrame((const uint8_t*)buffer, length, true);
+            } else if (message.kind == TELEMETRY_STATE) {
+                uint8_t buffer[STATE_FRAME_MAX_BYTES];
+                size_t length = stateEncoder.encode(message.state, buffer);
+                sendFrame(buffer, length, false);
+            } else {
+                sendFrame(message.bytes, message.length, message.kind == TELEMETRY_TEXT);
+            }
+        }
+
+        // Manda una trama de telemetría, comprimida si el servidor lo pidió
+        // y si en esta trama conviene
+        void sendFrame(const uint8_t* data, size_t length, bool text) {
+            telemetryBytes += length;
+            if (compressTelemetry && length >= TELEMETRY_COMPRESS_MIN_BYTES) {
+                static_assert(TELEMETRY_MAX_BYTES <= LZ_MAX_INPUT, "LZ_MAX_INPUT chico para la telemetría");
+                uint8_t packed[TELEMETRY_COMPRESS_HEADER + TELEMETRY_MAX_BYTES];
+                size_t capacity = length - TELEMETRY_COMPRESS_MIN_SAVING - TELEMETRY_COMPRESS_HEADER;
+                if (capacity > TELEMETRY_MAX_BYTES) {
+                    capacity = TELEMETRY_MAX_BYTES;
+                }
+                uint32_t start = micros();
+                size_t packedLength = codec.compress(data, length, packed + TELEMETRY_COMPRESS_HEADER, capacity);
+                compressUs += micros() - start;
+                if (packedLength) {
+                    packed[0] = 'Z';
+                    packed[1] = historyReset ? (text ? 't' : 'b') : (text ? 'T' : 'B');
+                    packed[2] = length & 0xFF;
+                    packed[3] = (length >> 8) & 0xFF;
+                    packedLength += TELEMETRY_COMPRESS_HEADER;
+                    client.sendBinary((const char*)packed, packedLength);
+                    codec.append(data, length);
+                    historyReset = false;
+                    sentBytes += packedLength;
+                    compressedFrames++;
+                    return;
+                }
+            }
+            // El servidor solo empieza a guardar historia con la primera
+            // trama comprimida
+            if (compressTelemetry && !historyReset) {
+                codec.append(data, length);
+            }
+            if (text) {
+                client.send((const char*)data, length);
+            } else {
+                client.sendBinary((const char*)data, length);
+            }
+            sentBytes += length;
+            plainFrames++;
+        }
 };
 
 #endif
@@ -0,0 +1,155 @@
+#include "AllocTracker.h"
+
+#ifdef SUPERCARRO_ALLOC_TRACKING
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Los operadores globales se reemplazan una sola vez para todo el programa:
+// por eso viven aquí y no en la cabecera
+
+namespace {
+
+    const char* const CATEGORY_NAMES[ALLOC_CATEGORY_COUNT] = {
+        "otros", "loop", "red", "json", "telemetria"
+    };
+
+    // Cabecera delante de cada bloque: tamaño y categoría para poder descontarlo
+    struct AllocHeader {
+        uint32_t size;
+        uint8_t category;
+        uint8_t padding[sizeof(max_align_t) - sizeof(uint32_t) - sizeof(uint8_t)];
+    };
+
+    void* trackedAlloc(size_t size) {
+        AllocHeader* header = (AllocHeader*)malloc(sizeof(AllocHeader) + size);
+        if (!header) {
+            return nullptr;
+        }
+        header->size = size;
+        header->category = AllocTracker::current();
+        AllocTracker::recordAlloc((AllocCategory)header->category, size);
+        return header + 1;
+    }
+
+    void trackedFree(void* ptr) {
+        if (!ptr) {
+            return;
+        }
+        AllocHeader* header = (AllocHeader*)ptr - 1;
+        AllocTracker::recordFree((AllocCategory)header->category, header->size);
+        free(header);
+    }
+
+    uint32_t fragmentation(uint32_t freeHeap, uint32_t largest) {
+        return freeHeap ? 100 - (uint64_t)largest * 100 / freeHeap : 0;
+    }
+
+    AllocTracker::Snapshot testStart;
+
+}
+
+void AllocTracker::report(Print& out) {
+    for (int i = 0; i < ALLOC_CATEGORY_COUNT; i++) {
+        CategoryStats& s = stats((AllocCategory)i);
+        out.printf("heap[%s]: reservas=%u vivos=%uB pico=%uB total=%uB\n",
+            CATEGORY_NAMES[i],
+            (unsigned)s.allocations.load(),
+            (unsigned)s.liveBytes.load(),
+            (unsigned)s.peakBytes.load(),
+            (unsigned)s.totalBytes.load());
+    }
+    uint32_t freeHeap = ESP.getFreeHeap();
+    uint32_t largest = ESP.getMaxAllocHeap();
+    out.printf("heap: libre=%uB bloque_max=%uB fragmentacion=%u%% minimo=%uB\n",
+        (unsigned)freeHeap,
+        (unsigned)largest,
+        (unsigned)fragmentation(freeHeap, largest),
+        (unsigned)ESP.getMinFreeHeap());
+}
+
+size_t AllocTracker::toJson(char* out, size_t capacity) {
+    uint32_t freeHeap = ESP.getFreeHeap();
+    uint32_t largest = ESP.getMaxAllocHeap();
+    int length = snprintf(out, capacity, "{\"type\":\"heap\",\"free\":%u,\"largest\":%u,\"fragmentation\":%u,\"min\":%u",
+        (unsigned)freeHeap,
+        (unsigned)largest,
+        (unsigned)fragmentation(freeHeap, largest),
+        (unsigned)ESP.getMinFreeHeap());
+    for (int i = 0; i < ALLOC_CATEGORY_COUNT && length > 0 && (size_t)length < capacity; i++) {
+        CategoryStats& s = stats((AllocCategory)i);
+        length += snprintf(out + length, capacity - length, ",\"%s\":[%u,%u,%u,%u]",
+            CATEGORY_NAMES[i],
+            (unsigned)s.allocations.load(),
+            (unsigned)s.liveBytes.load(),
+            (unsigned)s.peakBytes.load(),
+            (unsigned)s.totalBytes.load());
+    }
+    if (length <= 0 || (size_t)length + 1 >= capacity) {
+        return 0;
+    }
+    out[length++] = '}';
+    out[length] = '\0';
+    return length;
+}
+
+AllocTracker::Snapshot AllocTracker::snapshot() {
+    Snapshot snapshot;
+    for (int i = 0; i < ALLOC_CATEGORY_COUNT; i++) {
+        CategoryStats& s = stats((AllocCategory)i);
+        snapshot.allocations[i] = s.allocations.load();
+        snapshot.liveBytes[i] = s.liveBytes.load();
+        snapshot.totalBytes[i] = s.totalBytes.load();
+    }
+    return snapshot;
+}
+
+void AllocTracker::reportSince(Print& out, const char* label, const Snapshot& since) {
+    Snapshot now = snapshot();
+    uint32_t allocations = 0;
+    uint32_t totalBytes = 0;
+    int32_t liveBytes = 0;
+    for (int i = 0; i < ALLOC_CATEGORY_COUNT; i++) {
+        allocations += now.allocations[i] - since.allocations[i];
+        totalBytes += now.totalBytes[i] - since.totalBytes[i];
+        liveBytes += (int32_t)(now.liveBytes[i] - since.liveBytes[i]);
+    }
+    out.printf("heap %s: reservas=%u total=%uB sin_liberar=%dB\n",
+        label, (unsigned)allocations, (unsigned)totalBytes, (int)liveBytes);
+    for (int i = 0; i < ALLOC_CATEGORY_COUNT; i++) {
+        uint32_t count = now.allocations[i] - since.allocations[i];
+        if (!count) {
+            continue;
+        }
+        out.printf("heap %s[%s]: reservas=%u total=%uB sin_liberar=%dB\n",
+            label, CATEGORY_NAMES[i], (unsigned)count,
+            (unsigned)(now.totalBytes[i] - since.totalBytes[i]),
+            (int)(int32_t)(now.liveBytes[i] - since.liveBytes[i]));
+    }
+}
+
+void AllocTracker::beginTest() {
+    testStart = snapshot();
+}
+
+void AllocTracker::endTest(Print& out, const char* name) {
+    reportSince(out, name ? name : "test", testStart);
+}
+
+void* operator new(size_t size) {
+    void* ptr = trackedAlloc(size);
+    if (!ptr) {
+        abort();
+    }
+    return ptr;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return trackedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return trackedAlloc(size); }
+void operator delete(void* ptr) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { trackedFree(ptr); }
+
+#endif
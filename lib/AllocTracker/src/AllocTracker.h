@@ -0,0 +1,117 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Seguimiento de memoria dinámica por categoría de código.
+// Se activa compilando con -DSUPERCARRO_ALLOC_TRACKING: AllocTracker.cpp
+// reemplaza los operadores new/delete globales y anota cada reserva en la
+// categoría activa (ALLOC_SCOPE). Sin la bandera no queda nada de esto en el
+// firmware.
+
+enum AllocCategory : uint8_t {
+    ALLOC_OTHER = 0,
+    ALLOC_LOOP,
+    ALLOC_NETWORK,
+    ALLOC_JSON,
+    ALLOC_TELEMETRY,
+    ALLOC_CATEGORY_COUNT
+};
+
+// Mayor reporte JSON de AllocTracker::toJson
+#define ALLOC_JSON_MAX_BYTES 384
+
+#ifdef SUPERCARRO_ALLOC_TRACKING
+
+class AllocTracker {
+    public:
+        struct CategoryStats {
+            std::atomic<uint32_t> allocations;
+            std::atomic<uint32_t> liveBytes;
+            std::atomic<uint32_t> peakBytes;
+            std::atomic<uint32_t> totalBytes;
+        };
+
+        // Contadores copiados en un momento dado, para ver lo que reservó un tramo
+        struct Snapshot {
+            uint32_t allocations[ALLOC_CATEGORY_COUNT];
+            uint32_t liveBytes[ALLOC_CATEGORY_COUNT];
+            uint32_t totalBytes[ALLOC_CATEGORY_COUNT];
+        };
+
+        static CategoryStats& stats(AllocCategory category) {
+            static CategoryStats all[ALLOC_CATEGORY_COUNT];
+            return all[category];
+        }
+
+        static AllocCategory& current() {
+            static thread_local AllocCategory category = ALLOC_OTHER;
+            return category;
+        }
+
+        static void recordAlloc(AllocCategory category, uint32_t size) {
+            CategoryStats& s = stats(category);
+            s.allocations++;
+            s.totalBytes += size;
+            uint32_t live = s.liveBytes += size;
+            uint32_t peak = s.peakBytes.load();
+            while (live > peak && !s.peakBytes.compare_exchange_weak(peak, live)) {
+            }
+        }
+
+        static void recordFree(AllocCategory category, uint32_t size) {
+            stats(category).liveBytes -= size;
+        }
+
+        // Tabla por categoría más el estado del heap: la fragmentación es la
+        // parte de la memoria libre que no está en el bloque contiguo más grande
+        static void report(Print& out);
+
+        // El mismo reporte para la telemetría:
+        // {"type":"heap","free":..,"largest":..,"fragmentation":..,"min":..,
+        //  "loop":[reservas,vivos,pico,total],...}
+        // Devuelve el largo escrito, 0 si no entra en capacity
+        static size_t toJson(char* out, size_t capacity);
+
+        static Snapshot snapshot();
+
+        // Reservas, bytes y bytes sin liberar desde since, por categoría con actividad
+        static void reportSince(Print& out, const char* label, const Snapshot& since);
+
+        // Reporte por test en el host (ALLOC_TEST_BEGIN/ALLOC_TEST_END)
+        static void beginTest();
+        static void endTest(Print& out, const char* name);
+};
+
+// Cambia la categoría activa mientras dure el bloque
+class AllocScope {
+    public:
+        explicit AllocScope(AllocCategory category) : previous(AllocTracker::current()) {
+            AllocTracker::current() = category;
+        }
+        ~AllocScope() {
+            AllocTracker::current() = previous;
+        }
+    private:
+        AllocCategory previous;
+};
+
+#define ALLOC_SCOPE_CONCAT(a, b) a##b
+#define ALLOC_SCOPE_NAME(line) ALLOC_SCOPE_CONCAT(allocScope, line)
+#define ALLOC_SCOPE(category) AllocScope ALLOC_SCOPE_NAME(__LINE__)(category)
+
+// En los tests: setUp() llama ALLOC_TEST_BEGIN() y tearDown()
+// ALLOC_TEST_END(Unity.CurrentTestName) para imprimir lo que reservó cada test
+#define ALLOC_TEST_BEGIN() AllocTracker::beginTest()
+#define ALLOC_TEST_END(name) AllocTracker::endTest(Serial, name)
+
+#else
+
+#define ALLOC_SCOPE(category)
+#define ALLOC_TEST_BEGIN()
+#define ALLOC_TEST_END(name)
+
+#endif
+
+#endif
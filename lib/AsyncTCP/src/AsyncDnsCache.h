@@ -0,0 +1,166 @@
+/*
+  Asynchronous TCP library for Espressif MCUs
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+*/
+
+#ifndef ASYNCDNSCACHE_H_
+#define ASYNCDNSCACHE_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifndef CONFIG_ASYNC_TCP_DNS_CACHE_SIZE
+#define CONFIG_ASYNC_TCP_DNS_CACHE_SIZE 4
+#endif
+#ifndef CONFIG_ASYNC_TCP_DNS_CACHE_TTL
+#define CONFIG_ASYNC_TCP_DNS_CACHE_TTL 300000 //ms
+#endif
+#ifndef CONFIG_ASYNC_TCP_DNS_NEGATIVE_TTL
+#define CONFIG_ASYNC_TCP_DNS_NEGATIVE_TTL 10000 //ms
+#endif
+#ifndef CONFIG_ASYNC_TCP_DNS_PENDING_TIMEOUT
+#define CONFIG_ASYNC_TCP_DNS_PENDING_TIMEOUT 30000 //ms, longer than all of lwIP's own retries
+#endif
+
+/*
+ * DNS Cache
+ *
+ * Shared by all clients so reconnect loops do not pay a lookup per attempt.
+ * lwIP does not hand the record TTL to the found callback, so answers are
+ * kept for a fixed time and failed lookups for a shorter one. Clients asking
+ * for a name that is already being resolved are queued on the same entry
+ * instead of starting another query.
+ *
+ * A query whose answer never comes back (its event could not be queued) is
+ * given up after CONFIG_ASYNC_TCP_DNS_PENDING_TIMEOUT: the next connect()
+ * queries again and the clients already queued get that answer. Entries with
+ * a query in flight are never evicted, so a late answer cannot land on an
+ * entry that was reused for another name.
+ *
+ * This class only holds the table and decides; AsyncTCP.cpp does the locking
+ * and notifies the waiters.
+ * */
+
+class AsyncClient;
+
+class AsyncDnsCache {
+    public:
+        typedef enum { DNS_CACHE_HIT, DNS_CACHE_JOIN, DNS_CACHE_QUERY, DNS_CACHE_FULL } lookup_t;
+
+        typedef struct {
+            char * name;
+            uint32_t addr;          //0 for a failed lookup
+            uint32_t expires;       //while pending: when the query is given up
+            bool pending;
+            AsyncClient * waiters;  //linked through AsyncClient::_dns_next
+            AsyncClient * notifying; //waiter whose found callback is running
+            TaskHandle_t notifier;  //task running it
+        } entry_t;
+
+        AsyncDnsCache()
+        : hits(0)
+        , misses(0)
+        , joined(0)
+        {
+            memset(_entries, 0, sizeof(_entries));
+        }
+
+        ~AsyncDnsCache(){
+            for (int i = 0; i < CONFIG_ASYNC_TCP_DNS_CACHE_SIZE; ++ i) {
+                ::free(_entries[i].name);
+            }
+        }
+
+        //what connect(host) has to do with *entry: use its addr (HIT), queue on it (JOIN),
+        //or queue on it and start the query (QUERY)
+        lookup_t lookup(const char * host, uint32_t now, entry_t ** entry){
+            entry_t * e = _find(host);
+            if (e && (int32_t)(e->expires - now) > 0) {
+                *entry = e;
+                if (e->pending) {
+                    ++ joined;
+                    return DNS_CACHE_JOIN;
+                }
+                ++ hits;
+                return DNS_CACHE_HIT;
+            }
+            if (!e) {
+                e = _alloc(host);
+                if (!e) {
+                    return DNS_CACHE_FULL;
+                }
+            }
+            ++ misses;
+            e->pending = true;
+            e->expires = now + CONFIG_ASYNC_TCP_DNS_PENDING_TIMEOUT;
+            *entry = e;
+            return DNS_CACHE_QUERY;
+        }
+
+        //ttl 0 settles the entry without caching the answer
+        void store(entry_t * entry, uint32_t addr, uint32_t now, uint32_t ttl){
+            entry->addr = addr;
+            entry->expires = now + ttl;
+            entry->pending = false;
+        }
+
+        entry_t * entry(int i){
+            return &_entries[i];
+        }
+
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t joined;
+
+    private:
+        entry_t _entries[CONFIG_ASYNC_TCP_DNS_CACHE_SIZE];
+
+        entry_t * _find(const char * host){
+            for (int i = 0; i < CONFIG_ASYNC_TCP_DNS_CACHE_SIZE; ++ i) {
+                if (_entries[i].name && !strcmp(_entries[i].name, host)) {
+                    return &_entries[i];
+                }
+            }
+            return NULL;
+        }
+
+        //NULL if every entry has a lookup in flight or is notifying its waiters
+        entry_t * _alloc(const char * host){
+            entry_t * victim = NULL;
+            for (int i = 0; i < CONFIG_ASYNC_TCP_DNS_CACHE_SIZE; ++ i) {
+                entry_t * e = &_entries[i];
+                if (e->pending || e->waiters || e->notifying) {
+                    continue;
+                }
+                if (!e->name) {
+                    victim = e;
+                    break;
+                }
+                if (!victim || (int32_t)(e->expires - victim->expires) < 0) {
+                    victim = e;
+                }
+            }
+            if (!victim) {
+                return NULL;
+            }
+            ::free(victim->name);
+            victim->name = strdup(host);
+            if (!victim->name) {
+                return NULL;
+            }
+            victim->addr = 0;
+            victim->expires = 0;
+            victim->pending = false;
+            victim->waiters = NULL;
+            return victim;
+        }
+};
+
+#endif /* ASYNCDNSCACHE_H_ */
@@ -0,0 +1,125 @@
+/*
+  Asynchronous TCP library for Espressif MCUs
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+*/
+
+#ifndef ASYNCEVENTCOALESCER_H_
+#define ASYNCEVENTCOALESCER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+
+/*
+ * SENT/POLL coalescing
+ *
+ * lwIP calls _tcp_sent once per received ACK and _tcp_poll every poll
+ * interval, so bulk transfers flood the queue with tiny events that all end
+ * up in the same handler. For every client we remember the newest event it
+ * has waiting in the queue. A new SENT or POLL is folded into it (summing the
+ * acked length) only when that newest event is of the same kind for the same
+ * pcb; any other event for the client replaces or drops the reference. Since
+ * folding only ever extends the client's last queued event, the handler sees
+ * the same per-connection sequence of events, with consecutive SENTs summed
+ * and consecutive POLLs collapsed.
+ *
+ * Producer side (lwIP thread): fold() first; if it fails, allocate the packet,
+ * track() it before queueing and forget() the client if queueing fails. Every
+ * other event for the client calls forget() before it is queued.
+ * Consumer side (async task): handled() before reading the packet, so nothing
+ * is folded into it while or after it is processed.
+ * */
+
+class AsyncEventCoalescer {
+    public:
+        AsyncEventCoalescer(){
+            for (size_t i = 0; i < MAX_CLIENTS; ++ i) {
+                _slots[i].arg = NULL;
+            }
+        }
+
+        //returns true if the event was folded into the client's newest queued packet
+        bool fold(void * arg, int event, void * pcb, uint16_t len){
+            bool merged = false;
+            portENTER_CRITICAL(&_mux);
+            slot_t * s = _find(arg);
+            if (s && s->event == event && s->pcb == pcb && (!s->len || (uint32_t)*s->len + len <= 0xFFFF)) {
+                if (s->len) {
+                    *s->len += len;
+                }
+                merged = true;
+            }
+            portEXIT_CRITICAL(&_mux);
+            return merged;
+        }
+
+        //packet becomes the client's newest queued event; folded lengths are added to *len (NULL for POLL)
+        void track(void * arg, int event, void * pcb, void * packet, uint16_t * len){
+            portENTER_CRITICAL(&_mux);
+            slot_t * s = _find(arg);
+            if (!s) {
+                s = _find(NULL);
+            }
+            if (s) {
+                s->arg = arg;
+                s->event = event;
+                s->pcb = pcb;
+                s->packet = packet;
+                s->len = len;
+            }
+            portEXIT_CRITICAL(&_mux);
+        }
+
+        void forget(void * arg){
+            portENTER_CRITICAL(&_mux);
+            slot_t * s = _find(arg);
+            if (s) {
+                s->arg = NULL;
+            }
+            portEXIT_CRITICAL(&_mux);
+        }
+
+        void handled(void * packet){
+            portENTER_CRITICAL(&_mux);
+            for (size_t i = 0; i < MAX_CLIENTS; ++ i) {
+                if (_slots[i].arg && _slots[i].packet == packet) {
+                    _slots[i].arg = NULL;
+                }
+            }
+            portEXIT_CRITICAL(&_mux);
+        }
+
+    private:
+#ifdef CONFIG_LWIP_MAX_ACTIVE_TCP
+        static const size_t MAX_CLIENTS = CONFIG_LWIP_MAX_ACTIVE_TCP;
+#else
+        static const size_t MAX_CLIENTS = 16;
+#endif
+
+        typedef struct {
+            void * arg;
+            void * pcb;
+            void * packet;
+            uint16_t * len;
+            int event;
+        } slot_t;
+
+        portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+        slot_t _slots[MAX_CLIENTS];
+
+        //must be called with _mux held; arg NULL finds a free slot
+        slot_t * _find(void * arg){
+            for (size_t i = 0; i < MAX_CLIENTS; ++ i) {
+                if (_slots[i].arg == arg) {
+                    return &_slots[i];
+                }
+            }
+            return NULL;
+        }
+};
+
+#endif /* ASYNCEVENTCOALESCER_H_ */
@@ -0,0 +1,138 @@
+/*
+  Asynchronous TCP library for Espressif MCUs
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+*/
+
+#ifndef ASYNCRXWINDOW_H_
+#define ASYNCRXWINDOW_H_
+
+#include <stdint.h>
+#include <atomic>
+
+//default for setRxWatermarks(): ack at least two full segments at a time, like a delayed ACK
+#ifndef ASYNC_RX_ACK_BATCH
+#define ASYNC_RX_ACK_BATCH (2 * 1460)
+#endif
+
+/*
+ * Receive window accounting (AsyncClient::setRxWatermarks)
+ *
+ * Bytes handed to onData count as buffered by the application until it
+ * reports them with consumed(). They are acked to lwIP (reopening the peer's
+ * window) once at least "batch" of them are waiting. When "high" bytes are
+ * buffered the window is throttled: nothing more is acked, so the peer stops,
+ * until the application drains the buffer down to "low". The poll callback
+ * flushes a partial batch, so the tail of a transfer is not left unacked.
+ *
+ * Async task: received(), apply(), flush(), release() and configure() return
+ * the number of bytes to pass to tcp_recved right away.
+ * Any task: consumed() only records the count; it returns true for the first
+ * report since the last apply(), when the async task has to be woken up.
+ * */
+
+class AsyncRxWindow {
+    public:
+        AsyncRxWindow()
+        : _buffered(0)
+        , _pending(0)
+        , _held(0)
+        , _throttled(false)
+        , _low(0)
+        , _high(0)
+        , _batch(0)
+        {}
+
+        //high == 0 disables it; disabling releases everything held back
+        uint32_t configure(uint32_t low, uint32_t high, uint32_t batch){
+            if (low > high) {
+                low = high;
+            }
+            _low = low;
+            _high = high;
+            _batch = batch;
+            if (!_high) {
+                _buffered = 0;
+                _throttled = false;
+                return release();
+            }
+            return 0;
+        }
+
+        bool enabled() const {
+            return _high != 0;
+        }
+
+        //len bytes were just handed to onData
+        uint32_t received(uint32_t len){
+            _buffered += len;
+            _held += len;
+            if (_throttled) {
+                return 0;
+            }
+            if (_buffered >= _high) {
+                _throttled = true;
+                return 0;
+            }
+            if (_held >= _batch) {
+                return release();
+            }
+            return 0;
+        }
+
+        bool consumed(uint32_t len){
+            return !_pending.fetch_add(len);
+        }
+
+        bool pending() const {
+            return _pending != 0;
+        }
+
+        //applies the consumed() reports
+        uint32_t apply(){
+            uint32_t len = _pending.exchange(0);
+            uint32_t buffered = _buffered;
+            if (len > buffered) {
+                len = buffered;
+            }
+            _buffered = buffered - len;
+            if (_throttled && _buffered <= _low) {
+                _throttled = false;
+                return release();
+            }
+            return 0;
+        }
+
+        //poll: apply() and ack a partial batch unless throttled
+        uint32_t flush(){
+            uint32_t len = apply();
+            if (!_throttled) {
+                len += release();
+            }
+            return len;
+        }
+
+        uint32_t release(){
+            uint32_t len = _held;
+            _held = 0;
+            return len;
+        }
+
+        uint32_t buffered() const {
+            return _buffered;
+        }
+
+    private:
+        std::atomic<uint32_t> _buffered; //written by the async task only, read from any
+        std::atomic<uint32_t> _pending;  //reported by consumed(), applied on the async task
+        uint32_t _held;                  //received but not acked yet
+        bool _throttled;                 //reached "high", holding acks until "low"
+        uint32_t _low;
+        uint32_t _high;
+        uint32_t _batch;
+};
+
+#endif /* ASYNCRXWINDOW_H_ */
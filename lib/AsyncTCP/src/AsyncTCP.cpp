@@ -30,13 +30,16 @@ extern "C"{
 #include "lwip/err.h"
 }
 #include "esp_task_wdt.h"
+#include "AsyncEventCoalescer.h"
+#include "AsyncDnsCache.h"
+#include <atomic>
 
 /*
  * TCP/IP Event Task
  * */
 
 typedef enum {
-    LWIP_TCP_SENT, LWIP_TCP_RECV, LWIP_TCP_FIN, LWIP_TCP_ERROR, LWIP_TCP_POLL, LWIP_TCP_CLEAR, LWIP_TCP_ACCEPT, LWIP_TCP_CONNECTED, LWIP_TCP_DNS
+    LWIP_TCP_SENT, LWIP_TCP_RECV, LWIP_TCP_FIN, LWIP_TCP_ERROR, LWIP_TCP_POLL, LWIP_TCP_CLEAR, LWIP_TCP_ACCEPT, LWIP_TCP_CONNECTED, LWIP_TCP_DNS, LWIP_TCP_CONSUMED
 } lwip_event_t;
 
 typedef struct {
@@ -93,6 +96,46 @@ static int _closed_index = []() {
 }();
 
 
+#ifndef CONFIG_ASYNC_TCP_COALESCE_EVENTS
+#define CONFIG_ASYNC_TCP_COALESCE_EVENTS 1
+#endif
+
+//written by the lwIP thread and the async task, read by anyone
+static std::atomic<uint32_t> _async_events_queued(0);
+static std::atomic<uint32_t> _async_events_coalesced(0);
+static std::atomic<uint32_t> _async_events_handled(0);
+
+#if CONFIG_ASYNC_TCP_COALESCE_EVENTS
+static AsyncEventCoalescer _coalescer;
+
+static inline void _coalesce_forget_arg(void * arg){
+    _coalescer.forget(arg);
+}
+
+//returns true if the event was folded into the client's newest queued packet
+static inline bool _coalesce_event(lwip_event_t event, void * arg, tcp_pcb * pcb, uint16_t len){
+    if (_coalescer.fold(arg, event, pcb, len)) {
+        ++ _async_events_coalesced;
+        return true;
+    }
+    return false;
+}
+#else
+static inline void _coalesce_forget_arg(void * arg){}
+#endif
+
+void asyncTcpGetEventStats(uint32_t * queued, uint32_t * coalesced, uint32_t * handled){
+    if (queued) {
+        *queued = _async_events_queued;
+    }
+    if (coalesced) {
+        *coalesced = _async_events_coalesced;
+    }
+    if (handled) {
+        *handled = _async_events_handled;
+    }
+}
+
 static inline bool _init_async_event_queue(){
     if(!_async_queue){
         _async_queue = xQueueCreate(32, sizeof(lwip_event_packet_t *));
@@ -104,11 +147,19 @@ static inline bool _init_async_event_queue(){
 }
 
 static inline bool _send_async_event(lwip_event_packet_t ** e){
-    return _async_queue && xQueueSend(_async_queue, e, portMAX_DELAY) == pdPASS;
+    if (!_async_queue || xQueueSend(_async_queue, e, portMAX_DELAY) != pdPASS) {
+        return false;
+    }
+    ++ _async_events_queued;
+    return true;
 }
 
 static inline bool _prepend_async_event(lwip_event_packet_t ** e){
-    return _async_queue && xQueueSendToFront(_async_queue, e, portMAX_DELAY) == pdPASS;
+    if (!_async_queue || xQueueSendToFront(_async_queue, e, portMAX_DELAY) != pdPASS) {
+        return false;
+    }
+    ++ _async_events_queued;
+    return true;
 }
 
 static inline bool _get_async_event(lwip_event_packet_t ** e){
@@ -129,6 +180,7 @@ static bool _remove_events_with_arg(void * arg){
         }
         //discard packet if matching
         if((int)first_packet->arg == (int)arg){
+            _coalesce_forget_arg(arg);
             free(first_packet);
             first_packet = NULL;
         //return first packet to the back of the queue
@@ -142,6 +194,7 @@ static bool _remove_events_with_arg(void * arg){
             return false;
         }
         if((int)packet->arg == (int)arg){
+            _coalesce_forget_arg(arg);
             free(packet);
             packet = NULL;
         } else if(xQueueSend(_async_queue, &packet, portMAX_DELAY) != pdPASS){
@@ -151,7 +204,17 @@ static bool _remove_events_with_arg(void * arg){
     return true;
 }
 
+static void _dns_cache_resolved(void * arg, ip_addr_t * addr, uint32_t ttl);
+static void _dns_cache_lost(void * arg);
+
 static void _handle_async_event(lwip_event_packet_t * e){
+    ++ _async_events_handled;
+#if CONFIG_ASYNC_TCP_COALESCE_EVENTS
+    if(e->event == LWIP_TCP_SENT || e->event == LWIP_TCP_POLL){
+        //stop merging into this packet before reading it
+        _coalescer.handled(e);
+    }
+#endif
     if(e->event == LWIP_TCP_CLEAR){
         _remove_events_with_arg(e->arg);
     } else if(e->event == LWIP_TCP_RECV){
@@ -177,7 +240,10 @@ static void _handle_async_event(lwip_event_packet_t * e){
         AsyncServer::_s_accepted(e->arg, e->accept.client);
     } else if(e->event == LWIP_TCP_DNS){
         //ets_printf("D: 0x%08x %s = %s\n", e->arg, e->dns.name, ipaddr_ntoa(&e->dns.addr));
-        AsyncClient::_s_dns_found(e->dns.name, &e->dns.addr, e->arg);
+        //a failed lookup (no address) is lwIP's negative answer
+        _dns_cache_resolved(e->arg, &e->dns.addr, e->dns.addr.u_addr.ip4.addr ? CONFIG_ASYNC_TCP_DNS_CACHE_TTL : CONFIG_ASYNC_TCP_DNS_NEGATIVE_TTL);
+    } else if(e->event == LWIP_TCP_CONSUMED){
+        AsyncClient::_s_consumed(e->arg);
     }
     free((void*)(e));
 }
@@ -228,6 +294,7 @@ static bool _start_async_task(){
  * */
 
 static int8_t _tcp_clear_events(void * arg) {
+    _coalesce_forget_arg(arg);
     lwip_event_packet_t * e = (lwip_event_packet_t *)malloc(sizeof(lwip_event_packet_t));
     e->event = LWIP_TCP_CLEAR;
     e->arg = arg;
@@ -239,6 +306,7 @@ static int8_t _tcp_clear_events(void * arg) {
 
 static int8_t _tcp_connected(void * arg, tcp_pcb * pcb, int8_t err) {
     //ets_printf("+C: 0x%08x\n", pcb);
+    _coalesce_forget_arg(arg);
     lwip_event_packet_t * e = (lwip_event_packet_t *)malloc(sizeof(lwip_event_packet_t));
     e->event = LWIP_TCP_CONNECTED;
     e->arg = arg;
@@ -252,17 +320,27 @@ static int8_t _tcp_connected(void * arg, tcp_pcb * pcb, int8_t err) {
 
 static int8_t _tcp_poll(void * arg, struct tcp_pcb * pcb) {
     //ets_printf("+P: 0x%08x\n", pcb);
+#if CONFIG_ASYNC_TCP_COALESCE_EVENTS
+    if (_coalesce_event(LWIP_TCP_POLL, arg, pcb, 0)) {
+        return ERR_OK;
+    }
+#endif
     lwip_event_packet_t * e = (lwip_event_packet_t *)malloc(sizeof(lwip_event_packet_t));
     e->event = LWIP_TCP_POLL;
     e->arg = arg;
     e->poll.pcb = pcb;
+#if CONFIG_ASYNC_TCP_COALESCE_EVENTS
+    _coalescer.track(arg, LWIP_TCP_POLL, pcb, e, NULL);
+#endif
     if (!_send_async_event(&e)) {
+        _coalesce_forget_arg(arg);
         free((void*)(e));
     }
     return ERR_OK;
 }
 
 static int8_t _tcp_recv(void * arg, struct tcp_pcb * pcb, struct pbuf *pb, int8_t err) {
+    _coalesce_forget_arg(arg);
     lwip_event_packet_t * e = (lwip_event_packet_t *)malloc(sizeof(lwip_event_packet_t));
     e->arg = arg;
     if(pb){
@@ -287,12 +365,21 @@ static int8_t _tcp_recv(void * arg, struct tcp_pcb * pcb, struct pbuf *pb, int8_
 
 static int8_t _tcp_sent(void * arg, struct tcp_pcb * pcb, uint16_t len) {
     //ets_printf("+S: 0x%08x\n", pcb);
+#if CONFIG_ASYNC_TCP_COALESCE_EVENTS
+    if (_coalesce_event(LWIP_TCP_SENT, arg, pcb, len)) {
+        return ERR_OK;
+    }
+#endif
     lwip_event_packet_t * e = (lwip_event_packet_t *)malloc(sizeof(lwip_event_packet_t));
     e->event = LWIP_TCP_SENT;
     e->arg = arg;
     e->sent.pcb = pcb;
     e->sent.len = len;
+#if CONFIG_ASYNC_TCP_COALESCE_EVENTS
+    _coalescer.track(arg, LWIP_TCP_SENT, pcb, e, &e->sent.len);
+#endif
     if (!_send_async_event(&e)) {
+        _coalesce_forget_arg(arg);
         free((void*)(e));
     }
     return ERR_OK;
@@ -300,6 +387,7 @@ static int8_t _tcp_sent(void * arg, struct tcp_pcb * pcb, uint16_t len) {
 
 static void _tcp_error(void * arg, int8_t err) {
     //ets_printf("+E: 0x%08x\n", arg);
+    _coalesce_forget_arg(arg);
     lwip_event_packet_t * e = (lwip_event_packet_t *)malloc(sizeof(lwip_event_packet_t));
     e->event = LWIP_TCP_ERROR;
     e->arg = arg;
@@ -312,6 +400,10 @@ static void _tcp_error(void * arg, int8_t err) {
 static void _tcp_dns_found(const char * name, struct ip_addr * ipaddr, void * arg) {
     lwip_event_packet_t * e = (lwip_event_packet_t *)malloc(sizeof(lwip_event_packet_t));
     //ets_printf("+DNS: name=%s ipaddr=0x%08x arg=%x\n", name, ipaddr, arg);
+    if (!e) {
+        _dns_cache_lost(arg);
+        return;
+    }
     e->event = LWIP_TCP_DNS;
     e->arg = arg;
     e->dns.name = name;
@@ -320,6 +412,17 @@ static void _tcp_dns_found(const char * name, struct ip_addr * ipaddr, void * ar
     } else {
         memset(&e->dns.addr, 0, sizeof(e->dns.addr));
     }
+    if (!_send_async_event(&e)) {
+        free((void*)(e));
+        _dns_cache_lost(arg);
+    }
+}
+
+//consumed() from an application task: the accounting is done on the async task
+static void _tcp_consumed(void * arg) {
+    lwip_event_packet_t * e = (lwip_event_packet_t *)malloc(sizeof(lwip_event_packet_t));
+    e->event = LWIP_TCP_CONSUMED;
+    e->arg = arg;
     if (!_send_async_event(&e)) {
         free((void*)(e));
     }
@@ -337,6 +440,91 @@ static int8_t _tcp_accept(void * arg, AsyncClient * client) {
     return ERR_OK;
 }
 
+/*
+ * DNS Cache (AsyncDnsCache.h)
+ * */
+
+static AsyncDnsCache _dns_cache;
+
+static SemaphoreHandle_t _dns_cache_lock = []() {
+    SemaphoreHandle_t lock = xSemaphoreCreateBinary();
+    xSemaphoreGive(lock);
+    return lock;
+}();
+
+void asyncTcpGetDnsStats(uint32_t * hits, uint32_t * misses, uint32_t * joined){
+    if (hits) {
+        *hits = _dns_cache.hits;
+    }
+    if (misses) {
+        *misses = _dns_cache.misses;
+    }
+    if (joined) {
+        *joined = _dns_cache.joined;
+    }
+}
+
+//In LwIP Thread, when the answer could not be queued for the async task: settle the entry without
+//caching anything so the next connect() queries again; clients already queued get that answer
+static void _dns_cache_lost(void * arg){
+    AsyncDnsCache::entry_t * entry = (AsyncDnsCache::entry_t *)arg;
+    xSemaphoreTake(_dns_cache_lock, portMAX_DELAY);
+    _dns_cache.store(entry, 0, millis(), 0);
+    xSemaphoreGive(_dns_cache_lock);
+}
+
+//In Async Thread, or in connect() when lwIP answered synchronously; ttl 0 does not cache the answer
+static void _dns_cache_resolved(void * arg, ip_addr_t * addr, uint32_t ttl){
+    AsyncDnsCache::entry_t * entry = (AsyncDnsCache::entry_t *)arg;
+    ip_addr_t answer = *addr;
+    xSemaphoreTake(_dns_cache_lock, portMAX_DELAY);
+    _dns_cache.store(entry, answer.u_addr.ip4.addr, millis(), ttl);
+    //callbacks may call connect() again or delete their client, so they run unlocked:
+    //waiters are taken one at a time and the one being notified stays pinned
+    //(_dns_cache_cancel waits for it) until its callback returns.
+    //Stops if a callback started a new lookup for the same name
+    while (entry->waiters && !entry->pending) {
+        AsyncClient * c = entry->waiters;
+        entry->waiters = c->_dns_next;
+        c->_dns_next = NULL;
+        entry->notifying = c;
+        entry->notifier = xTaskGetCurrentTaskHandle();
+        xSemaphoreGive(_dns_cache_lock);
+        AsyncClient::_s_dns_found(NULL, &answer, c);
+        xSemaphoreTake(_dns_cache_lock, portMAX_DELAY);
+        entry->notifying = NULL;
+    }
+    xSemaphoreGive(_dns_cache_lock);
+}
+
+static void _dns_cache_cancel(AsyncClient * client){
+    for (;;) {
+        bool notifying = false;
+        xSemaphoreTake(_dns_cache_lock, portMAX_DELAY);
+        for (int i = 0; i < CONFIG_ASYNC_TCP_DNS_CACHE_SIZE; ++ i) {
+            AsyncDnsCache::entry_t * entry = _dns_cache.entry(i);
+            AsyncClient ** link = &entry->waiters;
+            while (*link) {
+                if (*link == client) {
+                    *link = client->_dns_next;
+                    client->_dns_next = NULL;
+                    break;
+                }
+                link = &(*link)->_dns_next;
+            }
+            //called from its own found callback is fine, from another task it has to wait
+            if (entry->notifying == client && entry->notifier != xTaskGetCurrentTaskHandle()) {
+                notifying = true;
+            }
+        }
+        xSemaphoreGive(_dns_cache_lock);
+        if (!notifying) {
+            return;
+        }
+        vTaskDelay(1);
+    }
+}
+
 /*
  * TCP/IP API Calls
  * */
@@ -555,10 +743,12 @@ AsyncClient::AsyncClient(tcp_pcb* pcb)
 , _pcb_busy(false)
 , _pcb_sent_at(0)
 , _ack_pcb(true)
+, _rx_ack_len(0)
 , _rx_last_packet(0)
 , _rx_since_timeout(0)
 , _ack_timeout(ASYNC_MAX_ACK_TIME)
 , _connect_port(0)
+, _dns_next(NULL)
 , prev(NULL)
 , next(NULL)
 {
@@ -586,8 +776,12 @@ AsyncClient::AsyncClient(tcp_pcb* pcb)
 }
 
 AsyncClient::~AsyncClient(){
+    _dns_cache_cancel(this);
     if(_pcb) {
         _close();
+    } else if(_rx_window.pending()) {
+        //drop a consumed() report still queued for this client
+        _tcp_clear_events(this);
     }
 }
 
@@ -719,12 +913,47 @@ bool AsyncClient::connect(const char* host, uint16_t port){
       return false;
     }
     
-    err_t err = dns_gethostbyname(host, &addr, (dns_found_callback)&_tcp_dns_found, this);
+    _dns_cache_cancel(this);
+
+    xSemaphoreTake(_dns_cache_lock, portMAX_DELAY);
+    AsyncDnsCache::entry_t * entry = NULL;
+    AsyncDnsCache::lookup_t lookup = _dns_cache.lookup(host, millis(), &entry);
+    if(lookup == AsyncDnsCache::DNS_CACHE_HIT) {
+        uint32_t cached = entry->addr;
+        xSemaphoreGive(_dns_cache_lock);
+        if(!cached) {
+            log_e("error: cached lookup failure for %s", host);
+            return false;
+        }
+        return connect(IPAddress(cached), port);
+    }
+    if(lookup == AsyncDnsCache::DNS_CACHE_FULL) {
+        xSemaphoreGive(_dns_cache_lock);
+        log_e("error: no free DNS cache entry");
+        return false;
+    }
+    //DNS_CACHE_JOIN: somebody is already resolving this name, wait for the same answer
+    _connect_port = port;
+    _dns_next = entry->waiters;
+    entry->waiters = this;
+    xSemaphoreGive(_dns_cache_lock);
+    if(lookup == AsyncDnsCache::DNS_CACHE_JOIN) {
+        return true;
+    }
+
+    err_t err = dns_gethostbyname(host, &addr, (dns_found_callback)&_tcp_dns_found, entry);
+    if(err == ERR_INPROGRESS) {
+        return true;
+    }
+    //answered (or refused) without a query, settle the entry for anyone who joined meanwhile.
+    //A refusal (ERR_ARG, ERR_MEM...) is not an answer about the name, so it is not cached
+    if(err != ERR_OK) {
+        memset(&addr, 0, sizeof(addr));
+    }
+    _dns_cache_cancel(this);
+    _dns_cache_resolved(entry, &addr, err == ERR_OK ? CONFIG_ASYNC_TCP_DNS_CACHE_TTL : 0);
     if(err == ERR_OK) {
         return connect(IPAddress(addr.u_addr.ip4.addr), port);
-    } else if(err == ERR_INPROGRESS) {
-        _connect_port = port;
-        return true;
     }
     log_e("error: %d", err);
     return false;
@@ -732,7 +961,7 @@ bool AsyncClient::connect(const char* host, uint16_t port){
 
 void AsyncClient::close(bool now){
     if(_pcb){
-        _tcp_recved(_pcb, _closed_slot, _rx_ack_len);
+        _tcp_recved(_pcb, _closed_slot, _rx_ack_len + _rx_window.release());
     }
     _close();
 }
@@ -790,6 +1019,35 @@ size_t AsyncClient::ack(size_t len){
     return len;
 }
 
+void AsyncClient::setRxWatermarks(size_t low, size_t high, size_t ackBatch){
+    //disabling goes back to per-packet acks and releases anything still held
+    _rx_ack(_rx_window.configure(low, high, ackBatch));
+}
+
+void AsyncClient::consumed(size_t len){
+    if(!len || !_rx_window.enabled() || !_pcb) {
+        return;
+    }
+    //the window accounting belongs to the async task, hand the count over to it
+    bool first = _rx_window.consumed(len);
+    if(xTaskGetCurrentTaskHandle() == _async_service_task_handle) {
+        _consumed();
+    } else if(first) {
+        //first report since the async task last applied them
+        _tcp_consumed(this);
+    }
+}
+
+void AsyncClient::_consumed(){
+    _rx_ack(_rx_window.apply());
+}
+
+void AsyncClient::_rx_ack(uint32_t len){
+    if(len && _pcb){
+        _tcp_recved(_pcb, _closed_slot, len);
+    }
+}
+
 void AsyncClient::ackPacket(struct pbuf * pb){
   if(!pb){
     return;
@@ -914,7 +1172,10 @@ int8_t AsyncClient::_recv(tcp_pcb* pcb, pbuf* pb, int8_t err) {
             if(_recv_cb) {
                 _recv_cb(_recv_cb_arg, this, b->payload, b->len);
             }
-            if(!_ack_pcb) {
+            if(_rx_window.enabled()) {
+                //window is reopened in batches, and only while the application keeps up
+                _rx_ack(_rx_window.received(b->len));
+            } else if(!_ack_pcb) {
                 _rx_ack_len += b->len;
             } else if(_pcb) {
                 _tcp_recved(_pcb, _closed_slot, b->len);
@@ -951,6 +1212,11 @@ int8_t AsyncClient::_poll(tcp_pcb* pcb){
         _close();
         return ERR_OK;
     }
+    // Release batched acks the application has already made room for
+    // (also picks up a consumed() report whose event was dropped)
+    if(_rx_window.enabled() || _rx_window.pending()) {
+        _rx_ack(_rx_window.flush());
+    }
     // Everything is fine
     if(_poll_cb) {
         _poll_cb(_poll_cb_arg, this);
@@ -1179,6 +1445,10 @@ const char * AsyncClient::stateToString(){
  * Static Callbacks (LwIP C2C++ interconnect)
  * */
 
+void AsyncClient::_s_consumed(void * arg){
+    reinterpret_cast<AsyncClient*>(arg)->_consumed();
+}
+
 void AsyncClient::_s_dns_found(const char * name, struct ip_addr * ipaddr, void * arg){
     reinterpret_cast<AsyncClient*>(arg)->_dns_found(ipaddr);
 }
@@ -25,6 +25,8 @@
 #include "IPAddress.h"
 #include "sdkconfig.h"
 #include <functional>
+#include <atomic>
+#include "AsyncRxWindow.h"
 extern "C" {
     #include "freertos/semphr.h"
     #include "lwip/pbuf.h"
@@ -52,6 +54,11 @@ typedef std::function<void(void*, AsyncClient*, uint32_t time)> AcTimeoutHandler
 struct tcp_pcb;
 struct ip_addr;
 
+//event queue counters: packets queued, lwIP callbacks folded into a queued SENT/POLL packet, packets handled
+void asyncTcpGetEventStats(uint32_t * queued, uint32_t * coalesced, uint32_t * handled);
+//shared DNS cache counters for connect(host, port): answered from cache, new queries, joined an in-flight query
+void asyncTcpGetDnsStats(uint32_t * hits, uint32_t * misses, uint32_t * joined);
+
 class AsyncClient {
   public:
     AsyncClient(tcp_pcb* pcb = 0);
@@ -123,6 +130,12 @@ class AsyncClient {
     size_t ack(size_t len); //ack data that you have not acked using the method below
     void ackLater(){ _ack_pcb = false; } //will not ack the current packet. Call from onData
 
+    //receive window management: data from onData is acked once ackBatch bytes are waiting; once "high" bytes are
+    //buffered by the application acks are held back (throttling the peer) until consumed() brings it down to "low"
+    void setRxWatermarks(size_t low, size_t high, size_t ackBatch = ASYNC_RX_ACK_BATCH); //high == 0 disables (default). Call before connecting or from a callback
+    void consumed(size_t len); //application has processed len bytes received through onData. Any task
+    size_t rxBuffered(){ return _rx_window.buffered(); }
+
     const char * errorToString(int8_t error);
     const char * stateToString();
 
@@ -135,6 +148,7 @@ class AsyncClient {
     static int8_t _s_sent(void *arg, struct tcp_pcb *tpcb, uint16_t len);
     static int8_t _s_connected(void* arg, void* tpcb, int8_t err);
     static void _s_dns_found(const char *name, struct ip_addr *ipaddr, void *arg);
+    static void _s_consumed(void *arg);
 
     int8_t _recv(tcp_pcb* pcb, pbuf* pb, int8_t err);
     tcp_pcb * pcb(){ return _pcb; }
@@ -164,6 +178,7 @@ class AsyncClient {
     uint32_t _pcb_sent_at;
     bool _ack_pcb;
     uint32_t _rx_ack_len;
+    AsyncRxWindow _rx_window;
     uint32_t _rx_last_packet;
     uint32_t _rx_since_timeout;
     uint32_t _ack_timeout;
@@ -177,8 +192,11 @@ class AsyncClient {
     int8_t _fin(tcp_pcb* pcb, int8_t err);
     int8_t _lwip_fin(tcp_pcb* pcb, int8_t err);
     void _dns_found(struct ip_addr *ipaddr);
+    void _rx_ack(uint32_t len);
+    void _consumed();
 
   public:
+    AsyncClient* _dns_next; //Do not use! waiting list of the DNS cache
     AsyncClient* prev;
     AsyncClient* next;
 };
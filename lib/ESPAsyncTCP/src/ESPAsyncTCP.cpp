@@ -173,6 +173,7 @@ AsyncClient::AsyncClient(tcp_pcb* pcb):
 #if ASYNC_TCP_SSL_ENABLED
   , _pcb_secure(false)
   , _handshake_done(true)
+  , _pin_fingerprint(false)
 #endif
   , _pcb_sent_at(0)
   , _close_pcb(false)
@@ -763,12 +764,19 @@ err_t AsyncClient::_s_connected(void* arg, void* tpcb, err_t err){
 #if ASYNC_TCP_SSL_ENABLED
 void AsyncClient::_s_data(void *arg, struct tcp_pcb *tcp, uint8_t * data, size_t len){
   AsyncClient *c = reinterpret_cast<AsyncClient*>(arg);
-  if(c->_recv_cb)
+  // nothing from a server that failed the fingerprint check
+  if(c->_handshake_done && c->_recv_cb)
     c->_recv_cb(c->_recv_cb_arg, c, data, len);
 }
 
 void AsyncClient::_s_handshake(void *arg, struct tcp_pcb *tcp, SSL *ssl){
   AsyncClient *c = reinterpret_cast<AsyncClient*>(arg);
+  if(c->_pin_fingerprint && tcp_ssl_match_fingerprint(ssl, c->_fingerprint) != 0){
+    // still inside tcp_ssl_read(), so the close is left to the next _poll()
+    c->_ssl_error(ERR_TCP_SSL_FINGERPRINT);
+    c->_close_pcb = true;
+    return;
+  }
   c->_handshake_done = true;
   if(c->_connect_cb)
     c->_connect_cb(c->_connect_cb_arg, c);
@@ -878,6 +886,13 @@ SSL * AsyncClient::getSSL(){
   }
   return NULL;
 }
+
+void AsyncClient::setFingerprint(const uint8_t * fingerprint){
+  static_assert(sizeof(_fingerprint) == TCP_SSL_FINGERPRINT_SIZE, "fingerprint is a SHA1");
+  _pin_fingerprint = fingerprint != NULL;
+  if(_pin_fingerprint)
+    memcpy(_fingerprint, fingerprint, sizeof(_fingerprint));
+}
 #endif
 
 uint8_t AsyncClient::state() {
@@ -130,6 +130,8 @@ class AsyncClient {
 #if ASYNC_TCP_SSL_ENABLED
     bool _pcb_secure;
     bool _handshake_done;
+    bool _pin_fingerprint;
+    uint8_t _fingerprint[20]; //SHA1 of the server certificate
 #endif
     uint32_t _pcb_sent_at;
     bool _close_pcb;
@@ -219,6 +221,11 @@ class AsyncClient {
 #endif
 #if ASYNC_TCP_SSL_ENABLED
     SSL *getSSL();
+    // Checked when the TLS handshake completes, before onConnect is called; on a
+    // mismatch onError is called (ERR_TCP_SSL_FINGERPRINT) and the connection closed.
+    // Pinned connections are resumed on reconnect (see tcp_ssl_sessions.h), which
+    // checking ssl_match_fingerprint() from onConnect does not allow. NULL stops checking.
+    void setFingerprint(const uint8_t * fingerprint);
 #endif
 
     size_t write(const char* data);
@@ -20,6 +20,7 @@
 */
 #include "Arduino.h"
 #include "SyncClient.h"
+#include "SyncClientPool.h"
 #include "ESPAsyncTCP.h"
 #include "cbuf.h"
 #include <interrupts.h>
@@ -46,6 +47,7 @@ SyncClient::SyncClient(size_t txBufLen)
   , _tx_buffer_size(txBufLen)
   , _rx_buffer(NULL)
   , _ref(NULL)
+  , _pool(NULL)
 {
   ref();
 }
@@ -56,6 +58,7 @@ SyncClient::SyncClient(AsyncClient *client, size_t txBufLen)
   , _tx_buffer_size(txBufLen)
   , _rx_buffer(NULL)
   , _ref(NULL)
+  , _pool(NULL)
 {
   if(ref() > 0 && _client != NULL)
     _attachCallbacks();
@@ -116,6 +119,12 @@ int SyncClient::_connect(const IPAddress& ip, uint16_t port){
 #endif
   if(connected())
     return 0;
+#if ASYNC_TCP_SSL_ENABLED
+  if(_pool != NULL && _adopt(_pool->acquire(ip, port, secure)))
+#else
+  if(_pool != NULL && _adopt(_pool->acquire(ip, port)))
+#endif
+    return 1;
   if(_client != NULL)
     delete _client;
 
@@ -246,11 +255,31 @@ uint8_t SyncClient::connected(){
 
 bool SyncClient::stop(unsigned int maxWaitMs){
   (void)maxWaitMs;
+  // A connection with nothing left in flight can be handed to the pool
+  // instead of being closed.
+  if(_pool != NULL && connected() && _rx_buffer == NULL
+      && (_tx_buffer == NULL || _tx_buffer->available() == 0)){
+    AsyncClient *c = _client;
+    c->onData(NULL, NULL);
+    _onDisconnect();
+    _pool->release(c);
+    return true;
+  }
   if(_client != NULL)
     _client->close(true);
   return true;
 }
 
+bool SyncClient::_adopt(AsyncClient *client){
+  if(client == NULL)
+    return false;
+  if(_client != NULL)
+    delete _client;
+  _onConnect(client);
+  _attachCallbacks_Disconnect();
+  return true;
+}
+
 size_t SyncClient::_sendBuffer(){
   if(_client == NULL || _tx_buffer == NULL)
     return 0;
@@ -31,6 +31,7 @@
 #endif
 #include <async_config.h>
 class cbuf;
+#include "SyncClientPool.h"
 class AsyncClient;
 
 class SyncClient: public Client {
@@ -40,6 +41,7 @@ class SyncClient: public Client {
     size_t _tx_buffer_size;
     cbuf *_rx_buffer;
     int *_ref;
+    SyncClientPool *_pool;
 
     size_t _sendBuffer();
     void _onData(void *data, size_t len);
@@ -49,6 +51,7 @@ class SyncClient: public Client {
     void _attachCallbacks_Disconnect();
     void _attachCallbacks_AfterConnected();
     void _release();
+    bool _adopt(AsyncClient *client);
 
   public:
     SyncClient(size_t txBufLen = TCP_MSS);
@@ -89,6 +92,7 @@ class SyncClient: public Client {
     int connect(const char *host, uint16_t port);
 #endif
     void setTimeout(uint32_t seconds);
+    void setPool(SyncClientPool *pool){ _pool = pool; } //reuse idle connections on connect(ip), park them on stop()
 
     uint8_t status();
     uint8_t connected();
@@ -0,0 +1,208 @@
+/*
+  Asynchronous TCP library for Espressif MCUs
+
+  Copyright (c) 2016 Hristo Gochkov. All rights reserved.
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef SYNCCLIENTPOOL_H_
+#define SYNCCLIENTPOOL_H_
+
+#include "Arduino.h"
+#include "IPAddress.h"
+#include <async_config.h>
+#include <new>
+
+#ifndef SYNC_CLIENT_POOL_IDLE_TIMEOUT
+#define SYNC_CLIENT_POOL_IDLE_TIMEOUT 30000 //ms an idle connection is kept open
+#endif
+
+/*
+  Keeps connected AsyncClients parked after SyncClient::stop() so the next
+  connect() to the same ip:port can reuse them instead of doing a new TCP
+  (and SSL) handshake. Parked connections are dropped when the peer closes
+  them, when they receive unexpected data or after the idle timeout.
+
+  Written against any client type with AsyncClient's connection and callback
+  API, so the host tests can run it over plain sockets; SyncClient uses
+  SyncClientPool, the AsyncClient one.
+*/
+template<typename Client>
+class BasicSyncClientPool {
+  private:
+    struct Entry {
+      Client *client;
+      uint32_t parkedAt;
+      bool closing; //close requested from one of its callbacks, deleted on disconnect
+    };
+    Entry *_entries;
+    size_t _size;
+    uint32_t _idleTimeout;
+    uint32_t _hits;
+    uint32_t _misses;
+
+    int _find(Client *c){
+      for(size_t i = 0; i < _size; i++){
+        if(_entries[i].client == c)
+          return i;
+      }
+      return -1;
+    }
+
+    bool _expired(const Entry &e, uint32_t now){
+      return _idleTimeout && (now - e.parkedAt) >= _idleTimeout;
+    }
+
+    // Not from the client's own callbacks: close(true) deletes it right away
+    void _evict(size_t i){
+      Client *c = _entries[i].client;
+      _entries[i].client = NULL;
+      // The idle disconnect handler is still attached and deletes the client.
+      if(c != NULL)
+        c->close(true);
+    }
+
+    // From the client's own poll/data callbacks. Deleting it there would destroy
+    // the std::function being run, so the close is left to the next _poll(), which
+    // calls the disconnect handler outside of any user callback. Until then the
+    // entry stays taken but is never handed out.
+    void _evictLater(Client *c){
+      int i = _find(c);
+      if(i >= 0)
+        _entries[i].closing = true;
+      c->close(false);
+    }
+
+    void _onIdleDisconnect(Client *c){
+      int i = _find(c);
+      if(i >= 0)
+        _entries[i].client = NULL;
+      delete c;
+    }
+
+    void _onIdlePoll(Client *c){
+      int i = _find(c);
+      if(i >= 0 && !_entries[i].closing && _expired(_entries[i], millis()))
+        _evictLater(c);
+    }
+
+  public:
+    BasicSyncClientPool(size_t maxIdle = 4, uint32_t idleTimeoutMs = SYNC_CLIENT_POOL_IDLE_TIMEOUT)
+      : _entries(new (std::nothrow) Entry[maxIdle])
+      , _size(0)
+      , _idleTimeout(idleTimeoutMs)
+      , _hits(0)
+      , _misses(0)
+    {
+      if(_entries != NULL){
+        _size = maxIdle;
+        for(size_t i = 0; i < _size; i++){
+          _entries[i].client = NULL;
+          _entries[i].closing = false;
+        }
+      }
+    }
+
+    ~BasicSyncClientPool(){
+      clear();
+      delete[] _entries;
+    }
+
+#if ASYNC_TCP_SSL_ENABLED
+    Client *acquire(const IPAddress& ip, uint16_t port, bool secure = false){
+#else
+    Client *acquire(const IPAddress& ip, uint16_t port){
+#endif
+      uint32_t now = millis();
+      for(size_t i = 0; i < _size; i++){
+        Client *c = _entries[i].client;
+        if(c == NULL || _entries[i].closing || c->remoteIP() != ip || c->remotePort() != port)
+          continue;
+#if ASYNC_TCP_SSL_ENABLED
+        if((c->getSSL() != NULL) != secure)
+          continue;
+#endif
+        // Health check, only hand out connections that are still usable
+        if(!c->connected() || _expired(_entries[i], now)){
+          _evict(i);
+          continue;
+        }
+        _entries[i].client = NULL;
+        c->onDisconnect(NULL, NULL);
+        c->onData(NULL, NULL);
+        c->onPoll(NULL, NULL);
+        _hits++;
+        return c;
+      }
+      _misses++;
+      return NULL;
+    }
+
+    //park a connected client, false if it had to be closed
+    bool release(Client *client){
+      if(client == NULL)
+        return false;
+      client->onAck(NULL, NULL);
+      client->onTimeout(NULL, NULL);
+      client->onDisconnect([](void *obj, Client* c){ ((BasicSyncClientPool*)(obj))->_onIdleDisconnect(c); }, this);
+      if(!client->connected() || _size == 0){
+        client->close(true);
+        return false;
+      }
+      // Reuse a free slot or make room by closing the connection parked longest
+      size_t slot = 0;
+      for(size_t i = 0; i < _size; i++){
+        if(_entries[i].client == NULL){
+          slot = i;
+          break;
+        }
+        if((int32_t)(_entries[i].parkedAt - _entries[slot].parkedAt) < 0)
+          slot = i;
+      }
+      if(_entries[slot].client != NULL)
+        _evict(slot);
+      _entries[slot].client = client;
+      _entries[slot].parkedAt = millis();
+      _entries[slot].closing = false;
+      // Nothing is expected while parked, data means the peer is out of sync with us
+      client->onData([](void *obj, Client* c, void *data, size_t len){ (void)data; (void)len; ((BasicSyncClientPool*)(obj))->_evictLater(c); }, this);
+      client->onPoll([](void *obj, Client* c){ ((BasicSyncClientPool*)(obj))->_onIdlePoll(c); }, this);
+      return true;
+    }
+
+    void clear(){
+      for(size_t i = 0; i < _size; i++)
+        _evict(i);
+    }
+
+    size_t idle(){
+      size_t count = 0;
+      for(size_t i = 0; i < _size; i++){
+        if(_entries[i].client != NULL && !_entries[i].closing)
+          count++;
+      }
+      return count;
+    }
+
+    uint32_t hits(){ return _hits; }
+    uint32_t misses(){ return _misses; }
+};
+
+class AsyncClient;
+typedef BasicSyncClientPool<AsyncClient> SyncClientPool;
+
+#endif /* SYNCCLIENTPOOL_H_ */
@@ -32,6 +32,7 @@
 #include <stdint.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <string.h>
 #include <tcp_axtls.h>
 
 uint8_t * default_private_key = NULL;
@@ -91,6 +92,8 @@ struct tcp_ssl_pcb {
   int last_wr;
   struct pbuf *tcp_pbuf;
   int pbuf_offset;
+  int session;
+  bool resumed;
   struct tcp_ssl_pcb * next;
 };
 
@@ -99,6 +102,49 @@ typedef struct tcp_ssl_pcb tcp_ssl_t;
 static tcp_ssl_t * tcp_ssl_array = NULL;
 static int tcp_ssl_next_fd = 0;
 
+static SSL_CTX * tcp_ssl_client_ctx = NULL;
+static struct tcp_ssl_session_cache tcp_ssl_sessions;
+
+static void tcp_ssl_session_handshake(tcp_ssl_t * tcp_ssl){
+  tcp_ssl->session = tcp_ssl_session_store(&tcp_ssl_sessions, tcp_ssl->session,
+      tcp_ssl->tcp->remote_ip.addr, tcp_ssl->tcp->remote_port,
+      ssl_get_session_id(tcp_ssl->ssl), ssl_get_session_id_size(tcp_ssl->ssl), &tcp_ssl->resumed);
+}
+
+static tcp_ssl_t * tcp_ssl_get_by_ssl(SSL *ssl){
+  tcp_ssl_t * item = tcp_ssl_array;
+  while(item && item->ssl != ssl){
+    item = item->next;
+  }
+  return item;
+}
+
+int tcp_ssl_match_fingerprint(SSL *ssl, const uint8_t *fp){
+  tcp_ssl_t * item = tcp_ssl_get_by_ssl(ssl);
+
+  if(ssl == NULL || fp == NULL)
+    return -1;
+  if(item && item->resumed){
+    //no certificate on a resumed session: compare with the one checked when it was created
+    if(tcp_ssl_session_pinned_to(&tcp_ssl_sessions, item->session, fp))
+      return 0;
+    TCP_SSL_DEBUG("tcp_ssl_match_fingerprint: resumed session was not pinned to this fingerprint\n");
+    return -1;
+  }
+  if(ssl_match_fingerprint(ssl, fp) != 0)
+    return -1;
+  if(item && item->session >= 0)
+    tcp_ssl_session_pin(&tcp_ssl_sessions, item->session, fp);
+  return 0;
+}
+
+void tcp_ssl_session_stats(uint32_t *full, uint32_t *resumed){
+  if(full)
+    *full = tcp_ssl_sessions.full_handshakes;
+  if(resumed)
+    *resumed = tcp_ssl_sessions.resumed_handshakes;
+}
+
 uint8_t tcp_ssl_has_client(){
   return _tcp_ssl_has_client;
 }
@@ -123,6 +169,8 @@ tcp_ssl_t * tcp_ssl_new(struct tcp_pcb *tcp) {
   new_item->on_error = NULL;
   new_item->tcp_pbuf = NULL;
   new_item->pbuf_offset = 0;
+  new_item->session = -1;
+  new_item->resumed = false;
   new_item->next = NULL;
   new_item->ssl_ctx = NULL;
   new_item->ssl = NULL;
@@ -166,21 +214,29 @@ int tcp_ssl_new_client(struct tcp_pcb *tcp){
     return -1;
   }
 
-  ssl_ctx = ssl_ctx_new(SSL_CONNECT_IN_PARTS | SSL_SERVER_VERIFY_LATER, 1);
-  if(ssl_ctx == NULL){
-    TCP_SSL_DEBUG("tcp_ssl_new_client: failed to allocate ssl context\n");
-    return -1;
+  if(tcp_ssl_client_ctx == NULL){
+    tcp_ssl_client_ctx = ssl_ctx_new(SSL_CONNECT_IN_PARTS | SSL_SERVER_VERIFY_LATER, TCP_SSL_CLIENT_SESSIONS);
+    if(tcp_ssl_client_ctx == NULL){
+      TCP_SSL_DEBUG("tcp_ssl_new_client: failed to allocate ssl context\n");
+      return -1;
+    }
   }
+  ssl_ctx = tcp_ssl_client_ctx;
 
   tcp_ssl = tcp_ssl_new(tcp);
   if(tcp_ssl == NULL){
-    ssl_ctx_free(ssl_ctx);
     return -1;
   }
 
   tcp_ssl->ssl_ctx = ssl_ctx;
-
-  tcp_ssl->ssl = ssl_client_new(ssl_ctx, tcp_ssl->fd, NULL, 0, NULL);
+  tcp_ssl->session = tcp_ssl_session_offer(&tcp_ssl_sessions, tcp->remote_ip.addr, tcp->remote_port);
+  if(tcp_ssl->session >= 0){
+    struct tcp_ssl_session * cached = &tcp_ssl_sessions.slots[tcp_ssl->session];
+    TCP_SSL_DEBUG("tcp_ssl_new_client: offering session %d\n", tcp_ssl->session);
+    tcp_ssl->ssl = ssl_client_new(ssl_ctx, tcp_ssl->fd, cached->id, cached->id_len, NULL);
+  } else {
+    tcp_ssl->ssl = ssl_client_new(ssl_ctx, tcp_ssl->fd, NULL, 0, NULL);
+  }
   if(tcp_ssl->ssl == NULL){
     TCP_SSL_DEBUG("tcp_ssl_new_client: failed to allocate ssl\n");
     tcp_ssl_free(tcp);
@@ -241,7 +297,7 @@ int tcp_ssl_free(struct tcp_pcb *tcp) {
     TCP_SSL_DEBUG("tcp_ssl_free: %d\n", item->fd);
     if(item->ssl)
       ssl_free(item->ssl);
-    if(item->type == TCP_SSL_TYPE_CLIENT && item->ssl_ctx)
+    if(item->type == TCP_SSL_TYPE_CLIENT && item->ssl_ctx && item->ssl_ctx != tcp_ssl_client_ctx)
       ssl_ctx_free(item->ssl_ctx);
     if(item->type == TCP_SSL_TYPE_SERVER)
       _tcp_ssl_has_client = 0;
@@ -264,7 +320,7 @@ int tcp_ssl_free(struct tcp_pcb *tcp) {
   TCP_SSL_DEBUG("tcp_ssl_free: %d\n", i->fd);
   if(i->ssl)
     ssl_free(i->ssl);
-  if(i->type == TCP_SSL_TYPE_CLIENT && i->ssl_ctx)
+  if(i->type == TCP_SSL_TYPE_CLIENT && i->ssl_ctx && i->ssl_ctx != tcp_ssl_client_ctx)
     ssl_ctx_free(i->ssl_ctx);
   if(i->type == TCP_SSL_TYPE_SERVER)
     _tcp_ssl_has_client = 0;
@@ -394,6 +450,8 @@ int tcp_ssl_read(struct tcp_pcb *tcp, struct pbuf *p) {
         fd_data->handshake = ssl_handshake_status(fd_data->ssl);
         if(fd_data->handshake == SSL_OK){
           //TCP_SSL_DEBUG("tcp_ssl_read: handshake OK\n");
+          if(fd_data->type == TCP_SSL_TYPE_CLIENT)
+            tcp_ssl_session_handshake(fd_data);
           if(fd_data->on_handshake)
             fd_data->on_handshake(fd_data->arg, fd_data->tcp, fd_data->ssl);
         } else if(fd_data->handshake != SSL_NOT_OK){
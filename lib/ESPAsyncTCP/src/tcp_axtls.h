@@ -42,12 +42,14 @@ extern "C" {
 
 #include <stdbool.h>
 #include "include/ssl.h"
+#include "tcp_ssl_sessions.h"
 
 #define ERR_TCP_SSL_INVALID_SSL           -101
 #define ERR_TCP_SSL_INVALID_TCP           -102
 #define ERR_TCP_SSL_INVALID_CLIENTFD      -103
 #define ERR_TCP_SSL_INVALID_CLIENTFD_DATA -104
 #define ERR_TCP_SSL_INVALID_DATA          -105
+#define ERR_TCP_SSL_FINGERPRINT           -106
 
 #define TCP_SSL_TYPE_CLIENT 0
 #define TCP_SSL_TYPE_SERVER 1
@@ -63,6 +65,11 @@ typedef int (* tcp_ssl_file_cb_t)(void *arg, const char *filename, uint8_t **buf
 uint8_t tcp_ssl_has_client();
 
 int tcp_ssl_new_client(struct tcp_pcb *tcp);
+void tcp_ssl_session_stats(uint32_t *full, uint32_t *resumed);
+//What AsyncClient::setFingerprint() checks. Use it instead of ssl_match_fingerprint() on
+//client connections: resumed sessions carry no certificate and are checked against the
+//fingerprint pinned on their full handshake. Sessions never pinned are not resumed.
+int tcp_ssl_match_fingerprint(SSL *ssl, const uint8_t *fp);
 
 SSL_CTX * tcp_ssl_new_server_ctx(const char *cert, const char *private_key_file, const char *password);
 int tcp_ssl_new_server(struct tcp_pcb *tcp, SSL_CTX* ssl_ctx);
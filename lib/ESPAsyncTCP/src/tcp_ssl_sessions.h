@@ -0,0 +1,125 @@
+/*
+  Asynchronous TCP library for Espressif MCUs
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+*/
+
+#ifndef TCP_SSL_SESSIONS_H
+#define TCP_SSL_SESSIONS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Client session resumption
+ * All client connections share one context whose session cache holds the
+ * master secrets, and the last session ID seen per server is offered again
+ * on the next connect, so reconnects skip the certificate and key exchange.
+ * A resumed connection has no server certificate to check, so the fingerprint
+ * verified on the full handshake (AsyncClient::setFingerprint() or
+ * tcp_ssl_match_fingerprint()) is kept with the session and compared instead.
+ * Only sessions whose certificate was pinned that way are offered again,
+ * unless TCP_SSL_RESUME_UNPINNED is set.
+ *
+ * This table knows nothing about lwIP or axTLS, so the host tests can run it
+ * over another TLS stack; tcp_axtls.c owns the one used on the device.
+ */
+#ifndef TCP_SSL_CLIENT_SESSIONS
+#define TCP_SSL_CLIENT_SESSIONS 4
+#endif
+#ifndef TCP_SSL_RESUME_UNPINNED
+#define TCP_SSL_RESUME_UNPINNED 0
+#endif
+
+#define TCP_SSL_FINGERPRINT_SIZE 20 //SHA1
+#define TCP_SSL_SESSION_ID_MAX 32 //SSL_SESSION_ID_SIZE
+
+struct tcp_ssl_session {
+  uint32_t addr;
+  uint16_t port;
+  uint8_t id_len;
+  uint8_t id[TCP_SSL_SESSION_ID_MAX];
+  uint32_t used;
+  bool pinned;
+  uint8_t fingerprint[TCP_SSL_FINGERPRINT_SIZE];
+};
+
+struct tcp_ssl_session_cache {
+  struct tcp_ssl_session slots[TCP_SSL_CLIENT_SESSIONS];
+  uint32_t clock;
+  uint32_t full_handshakes;
+  uint32_t resumed_handshakes;
+};
+
+static inline int tcp_ssl_session_find(struct tcp_ssl_session_cache *cache, uint32_t addr, uint16_t port){
+  int i;
+  for(i = 0; i < TCP_SSL_CLIENT_SESSIONS; i++){
+    if(cache->slots[i].id_len && cache->slots[i].addr == addr && cache->slots[i].port == port)
+      return i;
+  }
+  return -1;
+}
+
+//session to offer on a new connection to addr:port, -1 for a full handshake
+static inline int tcp_ssl_session_offer(struct tcp_ssl_session_cache *cache, uint32_t addr, uint16_t port){
+  int i = tcp_ssl_session_find(cache, addr, port);
+  if(i < 0 || (!cache->slots[i].pinned && !TCP_SSL_RESUME_UNPINNED))
+    return -1;
+  cache->slots[i].used = ++cache->clock;
+  return i;
+}
+
+//handshake done with the session id the server chose. offered is what
+//tcp_ssl_session_offer() returned; returns the session now backing the
+//connection (-1 if the id could not be kept) and whether it was resumed
+static inline int tcp_ssl_session_store(struct tcp_ssl_session_cache *cache, int offered, uint32_t addr, uint16_t port, const uint8_t *id, uint8_t id_len, bool *resumed){
+  struct tcp_ssl_session * slot;
+  int i = tcp_ssl_session_find(cache, addr, port);
+
+  if(i >= 0 && i == offered && cache->slots[i].id_len == id_len && !memcmp(cache->slots[i].id, id, id_len)){
+    cache->resumed_handshakes++;
+    cache->slots[i].used = ++cache->clock;
+    *resumed = true;
+    return i;
+  }
+  cache->full_handshakes++;
+  *resumed = false;
+  if(id == NULL || id_len == 0 || id_len > TCP_SSL_SESSION_ID_MAX)
+    return -1;
+
+  if(i < 0){
+    //least recently used
+    int j;
+    i = 0;
+    for(j = 1; j < TCP_SSL_CLIENT_SESSIONS; j++){
+      if((int32_t)(cache->slots[j].used - cache->slots[i].used) < 0)
+        i = j;
+    }
+  }
+  slot = &cache->slots[i];
+  slot->addr = addr;
+  slot->port = port;
+  slot->id_len = id_len;
+  memcpy(slot->id, id, id_len);
+  slot->used = ++cache->clock;
+  //new certificate, not checked yet
+  slot->pinned = false;
+  return i;
+}
+
+//the certificate of session i's full handshake matched fp
+static inline void tcp_ssl_session_pin(struct tcp_ssl_session_cache *cache, int i, const uint8_t *fp){
+  memcpy(cache->slots[i].fingerprint, fp, TCP_SSL_FINGERPRINT_SIZE);
+  cache->slots[i].pinned = true;
+}
+
+//check of a resumed session i, which carries no certificate
+static inline bool tcp_ssl_session_pinned_to(struct tcp_ssl_session_cache *cache, int i, const uint8_t *fp){
+  return i >= 0 && cache->slots[i].pinned && !memcmp(cache->slots[i].fingerprint, fp, TCP_SSL_FINGERPRINT_SIZE);
+}
+
+#endif /* TCP_SSL_SESSIONS_H */
@@ -0,0 +1,239 @@
+#include "Arduino.h"
+#include "NativeShim.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+namespace {
+    const int PIN_COUNT = 40;
+
+    std::atomic<uint64_t> virtualMicros(0);
+    std::atomic<bool> realtimeClock(false);
+    std::mutex clockMutex;
+    std::condition_variable clockChanged;
+
+    // Planificador del reloj virtual: el tiempo solo avanza cuando todas las
+    // tareas están dormidas (o bloqueadas sin plazo), y entonces salta a la
+    // hora más próxima entre sus despertares y los esp_timer pendientes
+    struct Sleeper {
+        uint64_t target;
+        bool awake;
+    };
+    std::vector<Sleeper*> sleepers;
+    int runningTasks = 0;
+    bool stepping = false;
+    thread_local bool participant = false;
+
+    // Con clockMutex tomado
+    void join() {
+        if (!participant) {
+            participant = true;
+            runningTasks++;
+        }
+    }
+
+    // Con clockMutex tomado y ninguna tarea en marcha: un paso del reloj
+    void step(std::unique_lock<std::mutex>& lock) {
+        uint64_t wake = UINT64_MAX;
+        for (Sleeper* sleeper : sleepers) {
+            if (!sleeper->awake && sleeper->target < wake) {
+                wake = sleeper->target;
+            }
+        }
+        uint64_t due = native::next_timer_due();
+        if (wake == UINT64_MAX && due == UINT64_MAX) {
+            return;
+        }
+        stepping = true;
+        if (due <= wake) {
+            // Los esp_timer que vencen antes se disparan a su hora exacta
+            if (due > virtualMicros) {
+                virtualMicros = due;
+            }
+            lock.unlock();
+            native::fire_timers(due);
+            lock.lock();
+        } else {
+            virtualMicros = wake;
+            for (Sleeper* sleeper : sleepers) {
+                if (!sleeper->awake && sleeper->target <= wake) {
+                    sleeper->awake = true;
+                    runningTasks++;
+                }
+            }
+            clockChanged.notify_all();
+        }
+        stepping = false;
+    }
+    const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+
+    std::mutex pinsMutex;
+    int pins[PIN_COUNT];
+    std::function<void(uint8_t, uint8_t)> digitalWriteHook;
+    // Sin obstáculo el HC-SR04 devuelve un eco de ~23 ms (unos 400 cm)
+    std::function<unsigned long(uint8_t, uint8_t)> pulseInHook = [](uint8_t, uint8_t) { return 23200UL; };
+
+    bool serialEnabled = true;
+    uint64_t runLimitMs = 0;
+}
+
+namespace native {
+
+    uint64_t now_us() {
+        if (realtimeClock) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - bootTime).count();
+        }
+        return virtualMicros;
+    }
+
+    void advance_us(uint64_t us) {
+        if (realtimeClock) {
+            std::this_thread::sleep_for(std::chrono::microseconds(us));
+            return;
+        }
+        std::unique_lock<std::mutex> lock(clockMutex);
+        join();
+        Sleeper self{virtualMicros + us, false};
+        sleepers.push_back(&self);
+        runningTasks--;
+        while (!self.awake) {
+            // La última tarea en dormirse es la que mueve el reloj
+            if (runningTasks == 0 && !stepping) {
+                step(lock);
+            } else {
+                clockChanged.wait(lock);
+            }
+        }
+        sleepers.erase(std::find(sleepers.begin(), sleepers.end(), &self));
+    }
+
+    void claim_clock() {
+        std::lock_guard<std::mutex> lock(clockMutex);
+        join();
+    }
+
+    void task_spawned() {
+        std::lock_guard<std::mutex> lock(clockMutex);
+        runningTasks++;
+    }
+
+    void task_attached() {
+        participant = true;
+    }
+
+    void task_blocked() {
+        std::lock_guard<std::mutex> lock(clockMutex);
+        if (participant) {
+            runningTasks--;
+            clockChanged.notify_all();
+        }
+    }
+
+    void task_unblocked() {
+        std::lock_guard<std::mutex> lock(clockMutex);
+        if (participant) {
+            runningTasks++;
+        }
+    }
+
+    void set_realtime(bool realtime) { realtimeClock = realtime; }
+    bool realtime() { return realtimeClock; }
+
+    int pin_state(uint8_t pin) {
+        std::lock_guard<std::mutex> lock(pinsMutex);
+        return pin < PIN_COUNT ? pins[pin] : LOW;
+    }
+
+    void on_digital_write(std::function<void(uint8_t, uint8_t)> hook) { digitalWriteHook = hook; }
+    void on_pulse_in(std::function<unsigned long(uint8_t, uint8_t)> hook) { pulseInHook = hook; }
+    void set_serial_enabled(bool enabled) { serialEnabled = enabled; }
+    void set_run_limit_ms(uint64_t ms) { runLimitMs = ms; }
+
+    bool running() {
+        return runLimitMs == 0 || now_us() < runLimitMs * 1000;
+    }
+
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    {
+        std::lock_guard<std::mutex> lock(pinsMutex);
+        if (pin < PIN_COUNT) {
+            pins[pin] = val;
+        }
+    }
+    if (digitalWriteHook) {
+        digitalWriteHook(pin, val);
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    return native::pin_state(pin);
+}
+
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout) {
+    unsigned long duration = pulseInHook ? pulseInHook(pin, state) : 0;
+    if (duration == 0 || duration > timeout) {
+        native::advance_us(timeout);
+        return 0;
+    }
+    native::advance_us(duration);
+    return duration;
+}
+
+unsigned long millis() { return native::now_us() / 1000; }
+unsigned long micros() { return native::now_us(); }
+void delay(uint32_t ms) { native::advance_us((uint64_t)ms * 1000); }
+void delayMicroseconds(uint32_t us) { native::advance_us(us); }
+void yield() { std::this_thread::yield(); }
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+long random(long max) { return max > 0 ? std::rand() % max : 0; }
+long random(long min, long max) { return min + random(max - min); }
+
+String::String(double value, unsigned int decimals) {
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, value);
+    s = buffer;
+}
+
+// Ciclos a 240 MHz contados con el reloj monotónico del host (no el virtual),
+// para medir cuánto tarda el código de verdad
+uint32_t EspClass::getCycleCount() {
+    return (uint32_t)(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - bootTime).count() * 240 / 1000);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (serialEnabled) {
+        fwrite(buffer, 1, size, stdout);
+    }
+    return size;
+}
+
+void HardwareSerial::flush() {
+    fflush(stdout);
+}
@@ -0,0 +1,82 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Arduino.h para el entorno "native": mismas funciones que usa el firmware,
+// respaldadas por un reloj virtual y pines simulados (ver NativeShim.h).
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "WString.h"
+#include "Print.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT  0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#define PI 3.1415926535897932384626433832795
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define radians(deg) ((deg) * DEG_TO_RAD)
+#define degrees(rad) ((rad) * RAD_TO_DEG)
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout = 1000000L);
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+long random(long max);
+long random(long min, long max);
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void end() {}
+    int available() { return 0; }
+    int read() { return -1; }
+    void flush();
+    operator bool() const { return true; }
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+// Datos del chip: en el host no hay un heap limitado que medir
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 320 * 1024; }
+    uint32_t getMinFreeHeap() { return 320 * 1024; }
+    uint32_t getMaxAllocHeap() { return 320 * 1024; }
+    uint32_t getCycleCount();
+    uint32_t getCpuFreqMHz() { return 240; }
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,240 @@
+#include "ArduinoWebsockets.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace websockets {
+
+    namespace {
+        const uint8_t OPCODE_TEXT = 0x1;
+        const uint8_t OPCODE_BINARY = 0x2;
+        const uint8_t OPCODE_CLOSE = 0x8;
+        const uint8_t OPCODE_PING = 0x9;
+        const uint8_t OPCODE_PONG = 0xA;
+
+        bool sendAll(int fd, const char* data, size_t length) {
+            while (length > 0) {
+                ssize_t sent = ::send(fd, data, length, MSG_NOSIGNAL);
+                if (sent < 0) {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                data += sent;
+                length -= sent;
+            }
+            return true;
+        }
+    }
+
+    WebsocketsClient::~WebsocketsClient() {
+        close();
+    }
+
+    bool WebsocketsClient::connect(const char* host, int port, const char* path) {
+        close();
+
+        // Permite apuntar el firmware a un servidor local sin tocar su configuración
+        if (const char* hostOverride = std::getenv("SUPERCARRO_WS_HOST")) {
+            host = hostOverride;
+        }
+        if (const char* portOverride = std::getenv("SUPERCARRO_WS_PORT")) {
+            port = std::atoi(portOverride);
+        }
+
+        addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        std::string service = std::to_string(port);
+        if (getaddrinfo(host, service.c_str(), &hints, &result) != 0) {
+            return false;
+        }
+        socketFd = ::socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+        if (socketFd < 0 || ::connect(socketFd, result->ai_addr, result->ai_addrlen) != 0) {
+            freeaddrinfo(result);
+            close();
+            return false;
+        }
+        freeaddrinfo(result);
+
+        int noDelay = 1;
+        setsockopt(socketFd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        std::string request =
+            std::string("GET ") + path + " HTTP/1.1\r\n" +
+            "Host: " + host + ":" + service + "\r\n" +
+            "Upgrade: websocket\r\n" +
+            "Connection: Upgrade\r\n" +
+            "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n" +
+            "Sec-WebSocket-Version: 13\r\n\r\n";
+        if (!sendAll(socketFd, request.data(), request.size())) {
+            close();
+            return false;
+        }
+
+        // Leer la respuesta del handshake; lo que venga después ya son tramas
+        std::string response;
+        char buffer[512];
+        size_t headerEnd;
+        while ((headerEnd = response.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t received = ::recv(socketFd, buffer, sizeof(buffer), 0);
+            if (received <= 0) {
+                close();
+                return false;
+            }
+            response.append(buffer, received);
+        }
+        if (response.compare(0, 12, "HTTP/1.1 101") != 0) {
+            close();
+            return false;
+        }
+        rxBuffer = response.substr(headerEnd + 4);
+
+        fcntl(socketFd, F_SETFL, fcntl(socketFd, F_GETFL, 0) | O_NONBLOCK);
+        return true;
+    }
+
+    void WebsocketsClient::close() {
+        if (socketFd >= 0) {
+            ::close(socketFd);
+            socketFd = -1;
+        }
+        rxBuffer.clear();
+    }
+
+    bool WebsocketsClient::available() {
+        return socketFd >= 0;
+    }
+
+    bool WebsocketsClient::poll() {
+        if (socketFd < 0) {
+            return false;
+        }
+
+        char buffer[1024];
+        while (true) {
+            ssize_t received = ::recv(socketFd, buffer, sizeof(buffer), 0);
+            if (received > 0) {
+                rxBuffer.append(buffer, received);
+                continue;
+            }
+            if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                close();
+                return false;
+            }
+            break;
+        }
+
+        bool handled = false;
+        while (rxBuffer.size() >= 2) {
+            const uint8_t* header = (const uint8_t*)rxBuffer.data();
+            uint8_t opcode = header[0] & 0x0F;
+            bool masked = header[1] & 0x80;
+            uint64_t length = header[1] & 0x7F;
+            size_t offset = 2;
+            if (length == 126) {
+                if (rxBuffer.size() < 4) break;
+                length = ((uint64_t)header[2] << 8) | header[3];
+                offset = 4;
+            } else if (length == 127) {
+                if (rxBuffer.size() < 10) break;
+                length = 0;
+                for (int i = 0; i < 8; i++) {
+                    length = (length << 8) | header[2 + i];
+                }
+                offset = 10;
+            }
+            uint8_t mask[4] = {0, 0, 0, 0};
+            if (masked) {
+                if (rxBuffer.size() < offset + 4) break;
+                memcpy(mask, header + offset, 4);
+                offset += 4;
+            }
+            if (rxBuffer.size() < offset + length) {
+                break;
+            }
+            std::string payload = rxBuffer.substr(offset, length);
+            if (masked) {
+                for (size_t i = 0; i < payload.size(); i++) {
+                    payload[i] ^= mask[i % 4];
+                }
+            }
+            rxBuffer.erase(0, offset + length);
+            handled = true;
+            if (!handleFrame(opcode, std::move(payload))) {
+                return false;
+            }
+        }
+        return handled;
+    }
+
+    bool WebsocketsClient::handleFrame(uint8_t opcode, std::string&& payload) {
+        switch (opcode) {
+            case OPCODE_TEXT:
+            case OPCODE_BINARY:
+                if (messageCallback) {
+                    messageCallback(WebsocketsMessage(
+                        opcode == OPCODE_TEXT ? MessageType::Text : MessageType::Binary, std::move(payload)));
+                }
+                return true;
+            case OPCODE_PING:
+                return sendFrame(OPCODE_PONG, payload.data(), payload.size());
+            case OPCODE_CLOSE:
+                sendFrame(OPCODE_CLOSE, nullptr, 0);
+                close();
+                return false;
+            default:
+                return true;
+        }
+    }
+
+    bool WebsocketsClient::send(const char* data, size_t length) {
+        return sendFrame(OPCODE_TEXT, data, length);
+    }
+
+    bool WebsocketsClient::sendBinary(const char* data, size_t length) {
+        return sendFrame(OPCODE_BINARY, data, length);
+    }
+
+    bool WebsocketsClient::ping() {
+        return sendFrame(OPCODE_PING, nullptr, 0);
+    }
+
+    bool WebsocketsClient::sendFrame(uint8_t opcode, const char* data, size_t length) {
+        if (socketFd < 0) {
+            return false;
+        }
+        // Las tramas del cliente van enmascaradas; la máscara fija basta en el host
+        const uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+        std::string frame;
+        frame.reserve(length + 14);
+        frame += (char)(0x80 | opcode);
+        if (length < 126) {
+            frame += (char)(0x80 | length);
+        } else if (length <= 0xFFFF) {
+            frame += (char)(0x80 | 126);
+            frame += (char)(length >> 8);
+            frame += (char)(length & 0xFF);
+        } else {
+            frame += (char)(0x80 | 127);
+            for (int i = 7; i >= 0; i--) {
+                frame += (char)(((uint64_t)length >> (8 * i)) & 0xFF);
+            }
+        }
+        frame.append((const char*)mask, 4);
+        for (size_t i = 0; i < length; i++) {
+            frame += (char)(data[i] ^ mask[i % 4]);
+        }
+        return sendAll(socketFd, frame.data(), frame.size());
+    }
+
+}
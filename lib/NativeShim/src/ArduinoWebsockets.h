@@ -0,0 +1,63 @@
+#ifndef NATIVE_ARDUINO_WEBSOCKETS_H
+#define NATIVE_ARDUINO_WEBSOCKETS_H
+
+#include "Arduino.h"
+#include <functional>
+#include <string>
+#include <utility>
+
+// Cliente WebSocket (RFC 6455) mínimo sobre sockets POSIX, con la misma
+// interfaz que usa el firmware de la librería ArduinoWebsockets.
+namespace websockets {
+
+    enum class MessageType { Empty, Text, Binary };
+
+    class WebsocketsMessage {
+    public:
+        WebsocketsMessage(MessageType type, std::string&& data) : messageType(type), payload(std::move(data)) {}
+
+        // Como en la librería: data() devuelve una copia del contenido,
+        // rawData() y c_str() lo prestan sin copiar
+        std::string data() const { return payload; }
+        const std::string& rawData() const { return payload; }
+        const char* c_str() const { return payload.c_str(); }
+        size_t length() const { return payload.size(); }
+        bool isText() const { return messageType == MessageType::Text; }
+        bool isBinary() const { return messageType == MessageType::Binary; }
+
+    private:
+        MessageType messageType;
+        std::string payload;
+    };
+
+    // Por valor como en la librería; el shim mueve el mensaje al llamarlo
+    typedef std::function<void(WebsocketsMessage)> MessageCallback;
+
+    class WebsocketsClient {
+    public:
+        ~WebsocketsClient();
+
+        bool connect(const char* host, int port, const char* path);
+        void close();
+        bool available();
+        bool poll();
+
+        bool send(const char* data, size_t length);
+        bool send(const std::string& data) { return send(data.c_str(), data.size()); }
+        bool sendBinary(const char* data, size_t length);
+        bool ping();
+
+        void onMessage(MessageCallback callback) { messageCallback = callback; }
+
+    private:
+        int socketFd = -1;
+        std::string rxBuffer;
+        MessageCallback messageCallback;
+
+        bool sendFrame(uint8_t opcode, const char* data, size_t length);
+        bool handleFrame(uint8_t opcode, std::string&& payload);
+    };
+
+}
+
+#endif
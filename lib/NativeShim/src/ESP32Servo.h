@@ -0,0 +1,59 @@
+#ifndef NATIVE_ESP32SERVO_H
+#define NATIVE_ESP32SERVO_H
+
+#include "Arduino.h"
+
+// Servo simulado: guarda el ángulo pedido y el pin
+class Servo {
+public:
+    int attach(int pin) { return attach(pin, 544, 2400); }
+    int attach(int pin, int minUs, int maxUs) {
+        attachedPin = pin;
+        this->minUs = minUs;
+        this->maxUs = maxUs;
+        return 1;
+    }
+    void detach() { attachedPin = -1; }
+    bool attached() const { return attachedPin >= 0; }
+    void write(int angle) { currentAngle = std::max(0, std::min(180, angle)); }
+    void writeMicroseconds(int us) { write(map(us, minUs, maxUs, 0, 180)); }
+    int read() const { return currentAngle; }
+    void setPeriodHertz(int hertz) { (void)hertz; }
+
+private:
+    int attachedPin = -1;
+    int minUs = 544;
+    int maxUs = 2400;
+    int currentAngle = 90;
+};
+
+// Canal PWM simulado: guarda el pin, la frecuencia y el ciclo útil
+class ESP32PWM {
+public:
+    static void allocateTimer(int timer) { (void)timer; }
+
+    void attachPin(uint8_t pin, double frequency, uint8_t resolutionBits = 10) {
+        attachedPin = pin;
+        this->frequency = frequency;
+        this->resolutionBits = resolutionBits;
+        duty = 0;
+    }
+    void detachPin(int pin) {
+        if (pin == attachedPin) {
+            attachedPin = -1;
+        }
+    }
+    bool attached() const { return attachedPin >= 0; }
+    int getPin() const { return attachedPin; }
+    void write(uint32_t value) { duty = value; }
+    uint32_t read() const { return duty; }
+    double getDutyScaled() const { return (double)duty / ((1UL << resolutionBits) - 1); }
+
+private:
+    int attachedPin = -1;
+    double frequency = 0;
+    uint8_t resolutionBits = 10;
+    uint32_t duty = 0;
+};
+
+#endif
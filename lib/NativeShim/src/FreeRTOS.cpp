@@ -0,0 +1,211 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "NativeShim.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct NativeTask {
+    std::thread thread;
+    const char* name;
+    UBaseType_t priority;
+    BaseType_t core;
+};
+
+struct NativeQueue {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> items;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+};
+
+namespace {
+    thread_local NativeTask* currentTask = nullptr;
+    std::recursive_mutex criticalMutex;
+
+    // Espera con el reloj del host: las colas comunican hilos reales. Sin plazo
+    // la tarea no cuenta como en marcha, para no parar el reloj virtual
+    template <typename Predicate>
+    bool waitFor(NativeQueue* queue, std::unique_lock<std::mutex>& lock, TickType_t ticks, Predicate ready) {
+        if (ticks == portMAX_DELAY) {
+            while (!ready()) {
+                lock.unlock();
+                native::task_blocked();
+                lock.lock();
+                queue->changed.wait(lock, ready);
+                lock.unlock();
+                native::task_unblocked();
+                lock.lock();
+            }
+            return true;
+        }
+        return queue->changed.wait_for(lock, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), ready);
+    }
+
+    BaseType_t push(QueueHandle_t queue, const void* item, TickType_t ticks, bool front) {
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        if (!waitFor(queue, lock, ticks, [queue] { return queue->items.size() < queue->length; })) {
+            return errQUEUE_FULL;
+        }
+        std::vector<uint8_t> copy((const uint8_t*)item, (const uint8_t*)item + queue->itemSize);
+        if (front) {
+            queue->items.push_front(std::move(copy));
+        } else {
+            queue->items.push_back(std::move(copy));
+        }
+        queue->changed.notify_all();
+        return pdPASS;
+    }
+}
+
+void vPortEnterCritical(portMUX_TYPE* mux) {
+    (void)mux;
+    criticalMutex.lock();
+}
+
+void vPortExitCritical(portMUX_TYPE* mux) {
+    (void)mux;
+    criticalMutex.unlock();
+}
+
+BaseType_t xTaskCreatePinnedToCore(
+    TaskFunction_t task,
+    const char* name,
+    uint32_t stackDepth,
+    void* parameters,
+    UBaseType_t priority,
+    TaskHandle_t* createdTask,
+    BaseType_t coreId
+) {
+    (void)stackDepth;
+    NativeTask* handle = new NativeTask();
+    handle->name = name;
+    handle->priority = priority;
+    handle->core = coreId;
+    native::task_spawned();
+    handle->thread = std::thread([handle, task, parameters] {
+        currentTask = handle;
+        native::task_attached();
+        task(parameters);
+        native::task_blocked();
+    });
+    handle->thread.detach();
+    if (createdTask) {
+        *createdTask = handle;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(
+    TaskFunction_t task,
+    const char* name,
+    uint32_t stackDepth,
+    void* parameters,
+    UBaseType_t priority,
+    TaskHandle_t* createdTask
+) {
+    return xTaskCreatePinnedToCore(task, name, stackDepth, parameters, priority, createdTask, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    // Un hilo del host no se puede matar desde fuera; solo termina el propio
+    if (task == nullptr || task == currentTask) {
+        native::task_blocked();
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::hours(1));
+        }
+    }
+}
+
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority) {
+    if (task == nullptr) {
+        task = currentTask;
+    }
+    if (task) {
+        task->priority = priority;
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    native::advance_us((uint64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+void vTaskDelayUntil(TickType_t* previousWakeTime, TickType_t increment) {
+    TickType_t wake = *previousWakeTime + increment;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(wake - now) > 0) {
+        vTaskDelay(wake - now);
+    }
+    *previousWakeTime = wake;
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)(native::now_us() / (1000 * portTICK_PERIOD_MS));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return currentTask;
+}
+
+BaseType_t xPortGetCoreID() {
+    return currentTask && currentTask->core != tskNO_AFFINITY ? currentTask->core : 1;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    NativeQueue* queue = new NativeQueue();
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticksToWait) {
+    return push(queue, item, ticksToWait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticksToWait) {
+    return push(queue, item, ticksToWait, true);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void* item) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->items.clear();
+    queue->items.emplace_back((const uint8_t*)item, (const uint8_t*)item + queue->itemSize);
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* buffer, TickType_t ticksToWait) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!waitFor(queue, lock, ticksToWait, [queue] { return !queue->items.empty(); })) {
+        return pdFALSE;
+    }
+    memcpy(buffer, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void* buffer, TickType_t ticksToWait) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!waitFor(queue, lock, ticksToWait, [queue] { return !queue->items.empty(); })) {
+        return pdFALSE;
+    }
+    memcpy(buffer, queue->items.front().data(), queue->itemSize);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->items.size();
+}
@@ -0,0 +1,39 @@
+#ifndef NATIVE_IPADDRESS_H
+#define NATIVE_IPADDRESS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Dirección IPv4 como en el core de Arduino (lo que usa el firmware)
+class IPAddress {
+public:
+    IPAddress() {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+        bytes[0] = a;
+        bytes[1] = b;
+        bytes[2] = c;
+        bytes[3] = d;
+    }
+
+    bool fromString(const char* address) {
+        unsigned a, b, c, d;
+        char extra;
+        if (sscanf(address, "%u.%u.%u.%u%c", &a, &b, &c, &d, &extra) != 4 || a > 255 || b > 255 || c > 255 || d > 255) {
+            return false;
+        }
+        *this = IPAddress(a, b, c, d);
+        return true;
+    }
+
+    uint8_t operator[](int index) const { return bytes[index]; }
+    bool operator==(const IPAddress& other) const {
+        return bytes[0] == other.bytes[0] && bytes[1] == other.bytes[1]
+            && bytes[2] == other.bytes[2] && bytes[3] == other.bytes[3];
+    }
+    bool operator!=(const IPAddress& other) const { return !(*this == other); }
+
+private:
+    uint8_t bytes[4] = {0, 0, 0, 0};
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef NATIVE_SHIM_H
+#define NATIVE_SHIM_H
+
+#include <cstdint>
+#include <functional>
+
+// Controles del host sobre el entorno simulado: reloj, pines y duración de la
+// ejecución. El firmware no incluye este archivo; lo usan los programas que lo
+// manejan desde fuera (benchmarks, simulaciones).
+namespace native {
+
+    // Reloj virtual en microsegundos. delay()/delayMicroseconds()/pulseIn() y
+    // vTaskDelay() duermen la tarea hasta su plazo en tiempo simulado, así que
+    // el resultado no depende del host. El reloj solo avanza cuando todas las
+    // tareas duermen y salta al plazo o esp_timer más próximo: cada tarea corre
+    // tantas veces como le tocaría en el ESP32.
+    // Con realtime el reloj sigue al reloj monotónico del host y delay() duerme.
+    uint64_t now_us();
+    void advance_us(uint64_t us);
+    void set_realtime(bool realtime);
+    // Cuenta el hilo que llama como una tarea más del reloj virtual (lo hace
+    // main() con el hilo de setup()/loop(); las tareas de FreeRTOS ya cuentan).
+    // Un hilo que no lo ha hecho se une en su primer advance_us().
+    void claim_clock();
+    bool realtime();
+
+    // Estado de los pines y ganchos para observar/inyectar señales
+    int pin_state(uint8_t pin);
+    void on_digital_write(std::function<void(uint8_t pin, uint8_t val)> hook);
+    // Devuelve la duración del pulso en us; 0 simula que no hubo eco
+    void on_pulse_in(std::function<unsigned long(uint8_t pin, uint8_t state)> hook);
+
+    // Silencia Serial (por defecto va a stdout)
+    void set_serial_enabled(bool enabled);
+
+    // Límite de la ejecución en tiempo simulado, 0 = sin límite.
+    // Se toma también de la variable de entorno SUPERCARRO_RUN_MS.
+    void set_run_limit_ms(uint64_t ms);
+    bool running();
+
+    // Uso interno: hora del próximo esp_timer (UINT64_MAX si no hay) y
+    // disparo de los que vencieron
+    uint64_t next_timer_due();
+    void fire_timers(uint64_t nowUs);
+
+    // Uso interno del shim de FreeRTOS: una tarea cuenta como en marcha desde
+    // que se crea (task_spawned, en el hilo creador) y su hilo se identifica
+    // con task_attached. Las esperas sin plazo y el final de la tarea no
+    // frenan el reloj (task_blocked/task_unblocked).
+    void task_spawned();
+    void task_attached();
+    void task_blocked();
+    void task_unblocked();
+
+}
+
+#endif
@@ -0,0 +1,46 @@
+#include "Print.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::write(const char* str) {
+    if (!str) {
+        return 0;
+    }
+    return write((const uint8_t*)str, strlen(str));
+}
+
+size_t Print::printNumber(long long value) {
+    char buffer[24];
+    int len = snprintf(buffer, sizeof(buffer), "%lld", value);
+    return write((const uint8_t*)buffer, len);
+}
+
+size_t Print::print(double value, int digits) {
+    char buffer[48];
+    int len = snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    return write((const uint8_t*)buffer, len);
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (len < 0) {
+        return 0;
+    }
+    if (len >= (int)sizeof(buffer)) {
+        len = sizeof(buffer) - 1;
+    }
+    return write((const uint8_t*)buffer, len);
+}
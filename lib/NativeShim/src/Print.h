@@ -0,0 +1,36 @@
+#ifndef NATIVE_PRINT_H
+#define NATIVE_PRINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include "WString.h"
+
+// Igual que en el core de Arduino: toda la salida de texto pasa por write()
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str);
+
+    size_t print(const char* str) { return write(str); }
+    size_t print(const String& str) { return write(str.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int value) { return printNumber(value); }
+    size_t print(unsigned int value) { return printNumber(value); }
+    size_t print(long value) { return printNumber(value); }
+    size_t print(unsigned long value) { return printNumber(value); }
+    size_t print(double value, int digits = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    size_t println(double value, int digits) { size_t n = print(value, digits); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+    size_t printNumber(long long value);
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef NATIVE_WSTRING_H
+#define NATIVE_WSTRING_H
+
+#include <string>
+#include <cstdlib>
+
+// Sustituto de la clase String de Arduino con lo que usa el firmware
+class String {
+public:
+    String(const char* s = "") : s(s ? s : "") {}
+    String(const std::string& s) : s(s) {}
+    String(char c) : s(1, c) {}
+    String(int value) : s(std::to_string(value)) {}
+    String(unsigned int value) : s(std::to_string(value)) {}
+    String(long value) : s(std::to_string(value)) {}
+    String(unsigned long value) : s(std::to_string(value)) {}
+    String(double value, unsigned int decimals = 2);
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned int length() const { return s.length(); }
+    bool isEmpty() const { return s.empty(); }
+    void reserve(unsigned int size) { s.reserve(size); }
+
+    char operator[](unsigned int index) const { return index < s.size() ? s[index] : 0; }
+    bool equals(const String& other) const { return s == other.s; }
+    bool operator==(const String& other) const { return s == other.s; }
+    bool operator==(const char* other) const { return s == (other ? other : ""); }
+    bool operator!=(const String& other) const { return !(*this == other); }
+    bool operator!=(const char* other) const { return !(*this == other); }
+
+    String& operator+=(const String& other) { s += other.s; return *this; }
+    String& operator+=(const char* other) { if (other) s += other; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    bool concat(const String& other) { s += other.s; return true; }
+
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t pos = s.find(c, from);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > s.size()) return String();
+        return String(s.substr(from, to > from ? to - from : 0));
+    }
+    String substring(unsigned int from) const { return substring(from, s.size()); }
+    long toInt() const { return std::strtol(s.c_str(), nullptr, 10); }
+    float toFloat() const { return std::strtof(s.c_str(), nullptr); }
+
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const String& a, const char* b) { return String(a.s + (b ? b : "")); }
+
+private:
+    std::string s;
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+#include "Arduino.h"
+
+// En el host la red ya existe: begin() conecta de inmediato
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+class WiFiClass {
+public:
+    wl_status_t begin(const char* ssid, const char* passphrase = nullptr) {
+        (void)ssid;
+        (void)passphrase;
+        currentStatus = WL_CONNECTED;
+        return currentStatus;
+    }
+    bool disconnect() { currentStatus = WL_DISCONNECTED; return true; }
+    wl_status_t status() { return currentStatus; }
+    int8_t RSSI() { return -50; }
+
+private:
+    wl_status_t currentStatus = WL_IDLE_STATUS;
+};
+
+extern WiFiClass WiFi;
+
+#endif
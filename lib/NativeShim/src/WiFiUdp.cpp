@@ -0,0 +1,66 @@
+#include "WiFiUdp.h"
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+WiFiUDP::~WiFiUDP() {
+    stop();
+}
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+    stop();
+    socketFd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (socketFd < 0) {
+        return 0;
+    }
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (::bind(socketFd, (sockaddr*)&address, sizeof(address)) != 0) {
+        stop();
+        return 0;
+    }
+    fcntl(socketFd, F_SETFL, fcntl(socketFd, F_GETFL, 0) | O_NONBLOCK);
+    return 1;
+}
+
+void WiFiUDP::stop() {
+    if (socketFd >= 0) {
+        ::close(socketFd);
+        socketFd = -1;
+    }
+    packetLength = 0;
+    packetRead = 0;
+}
+
+int WiFiUDP::parsePacket() {
+    packetLength = 0;
+    packetRead = 0;
+    if (socketFd < 0) {
+        return 0;
+    }
+    sockaddr_in from = {};
+    socklen_t fromLength = sizeof(from);
+    ssize_t received = ::recvfrom(socketFd, packet, sizeof(packet), 0, (sockaddr*)&from, &fromLength);
+    if (received <= 0) {
+        return 0;
+    }
+    uint32_t ip = ntohl(from.sin_addr.s_addr);
+    remoteAddress = IPAddress(ip >> 24, ip >> 16, ip >> 8, ip);
+    remotePortNumber = ntohs(from.sin_port);
+    packetLength = received;
+    return packetLength;
+}
+
+int WiFiUDP::read(uint8_t* buffer, size_t length) {
+    int count = packetLength - packetRead;
+    if ((size_t)count > length) {
+        count = length;
+    }
+    memcpy(buffer, packet + packetRead, count);
+    packetRead += count;
+    return count;
+}
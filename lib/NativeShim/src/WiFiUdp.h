@@ -0,0 +1,33 @@
+#ifndef NATIVE_WIFI_UDP_H
+#define NATIVE_WIFI_UDP_H
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+// WiFiUDP del core de ESP32 sobre un socket UDP del host, sin bloquear.
+// Solo recepción, que es lo que usa el firmware.
+class WiFiUDP {
+public:
+    ~WiFiUDP();
+
+    uint8_t begin(uint16_t port);
+    void stop();
+
+    // Recibe el siguiente datagrama; devuelve su largo o 0 si no hay
+    int parsePacket();
+    int read(uint8_t* buffer, size_t length);
+    int read(char* buffer, size_t length) { return read((uint8_t*)buffer, length); }
+    int available() { return packetLength - packetRead; }
+    IPAddress remoteIP() const { return remoteAddress; }
+    uint16_t remotePort() const { return remotePortNumber; }
+
+private:
+    int socketFd = -1;
+    uint8_t packet[1500];
+    int packetLength = 0;
+    int packetRead = 0;
+    IPAddress remoteAddress;
+    uint16_t remotePortNumber = 0;
+};
+
+#endif
@@ -0,0 +1,139 @@
+#include "esp_timer.h"
+#include "NativeShim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    uint64_t period;
+    uint64_t next;
+    bool active;
+    // Cambia al parar o reiniciar: el hilo del modo real que no coincide termina
+    uint32_t generation;
+};
+
+namespace {
+    std::mutex timersMutex;
+    std::vector<esp_timer*> timers;
+
+    esp_err_t start(esp_timer_handle_t timer, uint64_t timeout, uint64_t period) {
+        if (!timer) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        uint32_t generation;
+        {
+            std::lock_guard<std::mutex> lock(timersMutex);
+            if (timer->active) {
+                return ESP_ERR_INVALID_STATE;
+            }
+            timer->period = period;
+            timer->next = native::now_us() + timeout;
+            timer->active = true;
+            generation = ++timer->generation;
+        }
+        if (native::realtime()) {
+            std::thread([timer, generation] {
+                for (;;) {
+                    uint64_t next;
+                    {
+                        std::lock_guard<std::mutex> lock(timersMutex);
+                        if (!timer->active || timer->generation != generation) {
+                            return;
+                        }
+                        next = timer->next;
+                    }
+                    uint64_t now = native::now_us();
+                    if (next > now) {
+                        std::this_thread::sleep_for(std::chrono::microseconds(next - now));
+                    }
+                    native::fire_timers(native::now_us());
+                }
+            }).detach();
+        }
+        return ESP_OK;
+    }
+}
+
+namespace native {
+
+    uint64_t next_timer_due() {
+        std::lock_guard<std::mutex> lock(timersMutex);
+        uint64_t due = UINT64_MAX;
+        for (esp_timer* timer : timers) {
+            if (timer->active) {
+                due = std::min(due, timer->next);
+            }
+        }
+        return due;
+    }
+
+    void fire_timers(uint64_t nowUs) {
+        std::vector<esp_timer*> due;
+        {
+            std::lock_guard<std::mutex> lock(timersMutex);
+            for (esp_timer* timer : timers) {
+                if (timer->active && timer->next <= nowUs) {
+                    due.push_back(timer);
+                    if (timer->period) {
+                        timer->next += timer->period;
+                    } else {
+                        timer->active = false;
+                    }
+                }
+            }
+        }
+        // Sin el candado: el callback puede parar o reiniciar timers
+        for (esp_timer* timer : due) {
+            timer->callback(timer->arg);
+        }
+    }
+
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle) {
+    if (!args || !args->callback || !handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_timer* timer = new esp_timer{args->callback, args->arg, 0, 0, false, 0};
+    std::lock_guard<std::mutex> lock(timersMutex);
+    timers.push_back(timer);
+    *handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+    return period ? start(timer, period, period) : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout) {
+    return start(timer, timeout, 0);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    std::lock_guard<std::mutex> lock(timersMutex);
+    if (!timer || !timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = false;
+    timer->generation++;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    std::lock_guard<std::mutex> lock(timersMutex);
+    if (!timer || timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // No se libera: el hilo de un timer del modo real puede seguir mirándolo
+    timers.erase(std::remove(timers.begin(), timers.end(), timer), timers.end());
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time() {
+    return (int64_t)native::now_us();
+}
@@ -0,0 +1,38 @@
+#ifndef NATIVE_ESP_TIMER_H
+#define NATIVE_ESP_TIMER_H
+
+// esp_timer para el entorno native. Con el reloj virtual los timers se
+// disparan a su hora exacta dentro del hilo dueño del reloj, mientras este lo
+// adelanta (delay(), pulseIn(), vTaskDelayUntil()...); con el reloj real cada
+// timer tiene su hilo.
+
+#include <cstdint>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_STATE 0x103
+
+typedef struct esp_timer* esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void* arg);
+
+typedef enum {
+    ESP_TIMER_TASK,
+} esp_timer_dispatch_t;
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void* arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char* name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle);
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period);
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout);
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+esp_err_t esp_timer_delete(esp_timer_handle_t timer);
+int64_t esp_timer_get_time();
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef NATIVE_FREERTOS_QUEUE_H
+#define NATIVE_FREERTOS_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct NativeQueue* QueueHandle_t;
+typedef QueueHandle_t xQueueHandle;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticksToWait);
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticksToWait);
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void* item);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* buffer, TickType_t ticksToWait);
+BaseType_t xQueuePeek(QueueHandle_t queue, void* buffer, TickType_t ticksToWait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+#define xQueueSendToBack xQueueSend
+#define xQueueSendFromISR(q, item, woken) xQueueSend(q, item, 0)
+#define xQueueReceiveFromISR(q, buffer, woken) xQueueReceive(q, buffer, 0)
+
+#endif
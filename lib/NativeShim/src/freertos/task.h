@@ -0,0 +1,35 @@
+#ifndef NATIVE_FREERTOS_TASK_H
+#define NATIVE_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+typedef struct NativeTask* TaskHandle_t;
+
+// Las prioridades y el núcleo se guardan pero el planificador es el del host
+BaseType_t xTaskCreatePinnedToCore(
+    TaskFunction_t task,
+    const char* name,
+    uint32_t stackDepth,
+    void* parameters,
+    UBaseType_t priority,
+    TaskHandle_t* createdTask,
+    BaseType_t coreId
+);
+BaseType_t xTaskCreate(
+    TaskFunction_t task,
+    const char* name,
+    uint32_t stackDepth,
+    void* parameters,
+    UBaseType_t priority,
+    TaskHandle_t* createdTask
+);
+void vTaskDelete(TaskHandle_t task);
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* previousWakeTime, TickType_t increment);
+TickType_t xTaskGetTickCount();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t xPortGetCoreID();
+
+#endif
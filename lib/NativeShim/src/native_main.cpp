@@ -0,0 +1,39 @@
+// Los tests de `pio test -e native` traen su propio main()
+#ifndef PIO_UNIT_TESTING
+
+#include "Arduino.h"
+#include "NativeShim.h"
+
+#include <cstdlib>
+
+// Punto de entrada del entorno native: el mismo ciclo setup()/loop() del core
+// de Arduino, hasta agotar SUPERCARRO_RUN_MS de tiempo simulado.
+void setup();
+void loop();
+
+// Tiempo simulado que se deja correr al terminar para que las tareas de
+// vaciado del log y de la traza (cada 20 ms, la traza a 64 registros por
+// pasada) saquen lo que queda en sus buffers antes de salir
+#define SHUTDOWN_DRAIN_MS 200
+
+int main() {
+    if (const char* runMs = std::getenv("SUPERCARRO_RUN_MS")) {
+        native::set_run_limit_ms(std::strtoull(runMs, nullptr, 10));
+    }
+    if (const char* realtime = std::getenv("SUPERCARRO_REALTIME")) {
+        native::set_realtime(std::atoi(realtime) != 0);
+    }
+
+    native::claim_clock();
+    setup();
+    while (native::running()) {
+        loop();
+    }
+    native::advance_us((uint64_t)SHUTDOWN_DRAIN_MS * 1000);
+    Serial.flush();
+    // Las tareas de FreeRTOS no terminan nunca; salir sin destruir los objetos
+    // globales que todavía pueden estar usando
+    std::_Exit(0);
+}
+
+#endif
@@ -1,6 +1,20 @@
 #include <Arduino.h>
 #include "HardwareController.h"
 #include "WebServerController.h"
+#include "LatencyStats.h"
+#include "AllocTracker.h"
+#include "Trace.h"
+#include "Logger.h"
+#include "RangeTracker.h"
+#include "DistanceFilter.h"
+#include "RangeScanner.h"
+#include "OccupancyGrid.h"
+#include "Odometry.h"
+#include "TaskLoad.h"
+#include "MotorTicker.h"
+#include "CommandConditioner.h"
+#include "DriveMixer.h"
+#include "LinkWatchdog.h"
 #include <ESP32Servo.h>
 
 // Pines definidos
@@ -20,8 +34,57 @@ const char *PASSWORD = "12345678";
 const char* WebSocketServerHost = "192.168.60.59";
 const uint16_t WebSocketServerPort = 5000;
 
-String state; // Estado actual
-String previousState; // Estado anterior
+// Control (loop) en el núcleo 1 con prioridad alta; red en el núcleo 0.
+// El WiFi del ESP32 corre en el núcleo 0 con prioridad 23. El periodo de
+// control cubre el peor disparo del ultrasónico (pulseIn espera hasta 25 ms).
+#define CONTROL_PERIOD_MS 30
+#define CONTROL_TASK_PRIORITY 10
+#define NETWORK_PERIOD_MS 5
+#define NETWORK_TASK_PRIORITY 2
+#define NETWORK_TASK_CORE 0
+
+// Cada cuánto se reporta la latencia comando->GPIO y el uso de CPU por serial
+#define LATENCY_REPORT_INTERVAL_MS 5000
+// Cada cuánto se reporta el uso del heap por serial y por telemetría (solo
+// con SUPERCARRO_ALLOC_TRACKING)
+#define ALLOC_REPORT_INTERVAL_MS 10000
+// Al reducir la velocidad los motores se encienden y apagan en ciclos de este largo
+#define SLOW_PULSE_MS 100
+// En modo continuo, al reducir la velocidad lo pedido se baja a este % antes de mezclar
+#define SLOW_DUTY_PERCENT 50
+// Cada cuánto se envían al servidor las celdas del mapa que cambiaron
+#define MAP_EXPORT_INTERVAL_MS 1000
+#define MAP_EXPORT_BUFFER 512
+// Cada cuánto se envía el estado del carro (posición, motores, distancia...)
+#define STATE_REPORT_INTERVAL_MS 100
+
+CommandAction state = ACTION_NONE; // Estado actual
+CommandAction previousState = ACTION_NONE; // Estado anterior
+
+TaskLoad controlLoad(CONTROL_PERIOD_MS * 1000UL); // Uso de CPU de loop()
+TaskLoad networkLoad(NETWORK_PERIOD_MS * 1000UL); // Uso de CPU de la tarea de red
+
+LatencyStats commandLatency; // Latencia desde que llega el comando hasta que se aplica
+unsigned long lastLatencyReport = 0;
+uint32_t commandsReceived = 0; // Comandos sacados de la cola desde el inicio
+unsigned long lastAllocReport = 0;
+
+DistanceFilter distanceFilter; // Descarta lecturas sueltas del ultrasónico
+RangeScanner scanner; // Barrido del sensor con el servo
+OccupancyGrid occupancyGrid; // Mapa local alrededor del carro
+unsigned long lastMapExport = 0;
+Odometry odometry; // Posición estimada a partir de lo que se manda a los motores
+unsigned long lastStateReport = 0;
+RangeTracker rangeTracker; // Distancia y velocidad de acercamiento al obstáculo
+CommandConditioner conditioner; // Junta ráfagas y frena antes de invertir
+DriveMixer mixer; // Acelerador/dirección a ciclo útil de cada rueda
+bool driveMode = false; // El último comando fue continuo (arcade o tanque)
+Command driveCommand = {}; // Último comando continuo; se vuelve a mezclar en cada vuelta
+DriveMixer::Wheels wheels = {0, 0}; // Ciclo útil pedido en modo continuo, sin reducir
+Motion motion = MOTION_STOP; // Movimiento acondicionado que se manda a los motores
+bool wallStopped = false;  // Se frenó por un obstáculo; sigue así hasta otro comando
+LinkWatchdog linkWatchdog; // Para los motores si el servidor deja de mandar
+bool linkLost = false;     // Se paró por el watchdog; sigue así hasta otro comando
 
 // Instancia del controlador de hardware
 HardwareController hardwareController(
@@ -32,6 +95,9 @@ HardwareController hardwareController(
     PIN_LIGHT
 );
 
+// Aplica a los motores, a frecuencia fija, el movimiento que decide loop()
+MotorTicker motorTicker(hardwareController);
+
 // Instancia del controlador del servidor web
 WebSocketController webSocketController(
     SSID, 
@@ -40,8 +106,8 @@ WebSocketController webSocketController(
     WebSocketServerPort
 );
 
-// Función para medir la distancia usando el sensor ultrasónico
-long measureDistance() {
+// Dispara el sensor ultrasónico y devuelve la duración del eco en µs
+unsigned long ping() {
     digitalWrite(PIN_TRIGGER, LOW); // Asegurarse de que el trigger esté en LOW
     delayMicroseconds(2);
     
@@ -49,55 +115,255 @@ long measureDistance() {
     delayMicroseconds(10);
     digitalWrite(PIN_TRIGGER, LOW); // Terminar el pulso
 
-    long duration = pulseIn(PIN_ECHO, HIGH); // Medir la duración del eco
-    return duration * 0.034 / 2; // Convertir a distancia en cm
+    // Medir la duración del eco; sin eco pulseIn devuelve 0 al agotar el tiempo
+    return pulseIn(PIN_ECHO, HIGH, ECHO_TIMEOUT_US);
+}
+
+// Función para medir la distancia al frente, filtrada, en cm
+long measureDistance() {
+    return distanceFilter.update(ping()) / 10;
+}
+
+// Un paso del barrido: lectura en el ángulo actual y, al completar el arco,
+// envío del perfil al servidor
+void scanStep() {
+    if (!scanner.ready(micros())) {
+        return;
+    }
+    uint16_t mm = DistanceFilter::toMillimeters(ping());
+    uint16_t cm = mm == DistanceFilter::NO_ECHO ? 0 : mm / 10;
+    occupancyGrid.addRay(scanner.angle() - SCAN_CENTER_DEG, cm);
+    if (scanner.record(cm, micros())) {
+        webSocketController.send_scan(scanner.startAngle(), scanner.stepAngle(), scanner.profile(), scanner.size());
+    }
 }
 
+// Ruedas del último comando continuo con lo pedido reducido al percent %.
+// Se reduce antes de mezclar: la zona muerta del mixer queda sobre el
+// resultado y una rueda que gira nunca baja de MOTOR_MIN_DUTY
+DriveMixer::Wheels driveWheels(int percent) {
+    if (driveCommand.mode == COMMAND_ARCADE) {
+        return mixer.mix(driveCommand.throttle * percent / 100, driveCommand.steering * percent / 100);
+    }
+    return mixer.tank(driveCommand.left * percent / 100, driveCommand.right * percent / 100);
+}
+
+// Tarea de red: recibe comandos y envía la telemetría encolada por loop(), así
+// una conexión lenta no retrasa el control
+void networkTask(void* parameters) {
+    (void)parameters;
+    unsigned long lastReport = millis();
+    for (;;) {
+        networkLoad.begin();
+        webSocketController.loop();
+        networkLoad.end();
+        if (millis() - lastReport >= LATENCY_REPORT_INTERVAL_MS) {
+            lastReport = millis();
+            networkLoad.report(Logger::instance(), "Tarea red");
+            webSocketController.report_telemetry(Logger::instance());
+        }
+        vTaskDelay(pdMS_TO_TICKS(NETWORK_PERIOD_MS));
+    }
+}
 
 void setup() {
     Serial.begin(115200);
+    Logger::instance().begin(Serial);
+    traceBegin(Serial);
 
     // Configurar pines del sensor ultrasónico
     pinMode(PIN_TRIGGER, OUTPUT);
     pinMode(PIN_ECHO, INPUT);
     pinMode(PIN_SERVO, OUTPUT);
-    //servo
+    scanner.begin(PIN_SERVO);
     // Iniciar hardware
     hardwareController.begin();
+    motorTicker.watch(linkWatchdog);
+    motorTicker.begin();
 
     // Iniciar servidor web
+    webSocketController.watch(linkWatchdog);
     webSocketController.begin();
+    xTaskCreatePinnedToCore(networkTask, "network", 8192, NULL, NETWORK_TASK_PRIORITY, NULL, NETWORK_TASK_CORE);
+
+    // loop() ya corre en el núcleo 1 (tarea loopTask); se vuelve la de control
+    vTaskPrioritySet(NULL, CONTROL_TASK_PRIORITY);
 }
 
 void loop() {
-    webSocketController.loop();
-    state = webSocketController.get_state(); // Obtener el estado actual
+    static TickType_t lastWake = xTaskGetTickCount();
+    controlLoad.begin();
+    ALLOC_SCOPE(ALLOC_LOOP);
+    TRACE(TRACE_LOOP_START);
 
-    // Medir distancia
-    long distance = measureDistance();
+    // El tick de motores ya paró por falta de comandos y latidos: se olvida
+    // el último movimiento para no retomarlo cuando vuelva el enlace
+    if (linkWatchdog.tripped()) {
+        if (!linkLost) {
+            LOG_WARN("Sin comandos ni latidos del servidor en %u ms: motores parados", (unsigned)linkWatchdog.timeoutMs());
+            linkLost = true;
+        }
+        state = ACTION_STOP;
+        driveMode = false;
+        motorTicker.set(MOTION_STOP);
+        linkWatchdog.rearm();
+    }
 
-    if ((previousState == "FORWARD") && (distance < 40)){
-        Serial.println("muro cerca");
-        hardwareController.stop();
+    // Obtener el estado actual; si llegaron varios comandos vale el último
+    Command command = {};
+    bool commandTaken = false;
+    while (webSocketController.take_command(command)) {
+        if (commandTaken) {
+            commandLatency.superseded(1);
+        }
+        commandTaken = true;
+        commandsReceived++;
+        if (linkLost) {
+            LOG_INFO("Enlace con el servidor recuperado");
+            linkLost = false;
+        }
+        if (command.mode == COMMAND_STATE) {
+            state = command.action;
+            driveMode = false;
+        } else {
+            // Los valores continuos van directo a las ruedas, sin acondicionar:
+            // el conditioner queda en STOP para retomar desde cero al volver
+            driveCommand = command;
+            wheels = driveWheels(100);
+            driveMode = true;
+            state = ACTION_DRIVE;
+            conditioner.request(MOTION_STOP);
+        }
     }
+
     if (state != previousState) {
-        if (state == "FORWARD") {
-            hardwareController.Forward();
-        } else if (state == "BACKWARD") {
-            hardwareController.Backward();
-        } else if (state == "STOP") {
-            hardwareController.stop();
-        } else if (state == "LEFT") {
-            hardwareController.turnLeft();
-        } else if (state == "RIGHT") {
-            hardwareController.turnRight();
-        } else if (state == "LIGHT_ON") {
+        if (state == ACTION_FORWARD) {
+            conditioner.request(MOTION_FORWARD);
+        } else if (state == ACTION_BACKWARD) {
+            conditioner.request(MOTION_BACKWARD);
+        } else if (state == ACTION_STOP) {
+            conditioner.request(MOTION_STOP);
+        } else if (state == ACTION_LEFT) {
+            conditioner.request(MOTION_LEFT);
+        } else if (state == ACTION_RIGHT) {
+            conditioner.request(MOTION_RIGHT);
+        } else if (state == ACTION_LIGHT_ON) {
             hardwareController.lightOn();
-        } else if (state == "LIGHT_OFF") {
+        } else if (state == ACTION_LIGHT_OFF) {
             hardwareController.lightOff();
         }
     }
+    Motion conditioned = conditioner.update(micros());
+    if (driveMode) {
+        conditioned = DriveMixer::motionOf(wheels);
+    }
+    if (conditioned != motion) {
+        motion = conditioned;
+        wallStopped = false;
+    }
+
+    // Al avanzar el sensor mira al frente para frenar; si no, barre el entorno
+    scanner.setSweeping(motion != MOTION_FORWARD, micros());
+    BrakeLevel brake = BRAKE_NONE;
+    if (scanner.isSweeping()) {
+        scanStep();
+        // Las lecturas del barrido no son del frente
+        distanceFilter.reset();
+        rangeTracker.reset();
+    } else if (scanner.ready(micros())) {
+        rangeTracker.setCarSpeed(odometry.speedCmPerSecond());
+        // Medir distancia
+        long distance = measureDistance();
+        TRACE(TRACE_DISTANCE, distance);
+        occupancyGrid.addRay(0, distance);
+        brake = rangeTracker.update(distance, micros());
+    }
+
+    // Porcentaje de la salida pedida que llega a los motores
+    int throttlePercent = 100;
+    if (motion == MOTION_FORWARD) {
+        if (!wallStopped && brake == BRAKE_STOP) {
+            TRACE(TRACE_WALL_STOP, (uint32_t)rangeTracker.distance());
+            LOG_EVERY(LOG_LEVEL_WARN, 500, "muro cerca (%d cm, %d cm/s)",
+                (int)rangeTracker.distance(), (int)rangeTracker.speed());
+            wallStopped = true;
+        }
+        if (wallStopped) {
+            throttlePercent = 0;
+        } else if (brake == BRAKE_SLOW) {
+            if (driveMode) {
+                throttlePercent = SLOW_DUTY_PERCENT;
+            } else {
+                // Los motores son todo o nada: se reduce la velocidad media a pulsos
+                throttlePercent = (millis() / SLOW_PULSE_MS) % 2 == 0 ? 100 : 0;
+            }
+        }
+    }
+    // Se publica en cada vuelta; el tick solo toca los pines si algo cambió
+    if (driveMode) {
+        DriveMixer::Wheels output = throttlePercent == 100 ? wheels : driveWheels(throttlePercent);
+        motorTicker.drive(output.left, output.right);
+    } else {
+        motorTicker.set(throttlePercent ? motion : MOTION_STOP);
+    }
+    // Registrar la latencia del comando una vez entregado al tick de motores
+    if (commandTaken) {
+        uint32_t latency = micros() - command.receivedAt;
+        commandLatency.record(latency);
+        TRACE(TRACE_COMMAND_APPLIED, latency);
+    }
+    commandLatency.dropped(webSocketController.take_dropped_commands());
+    if (millis() - lastLatencyReport >= LATENCY_REPORT_INTERVAL_MS) {
+        lastLatencyReport = millis();
+        commandLatency.report(Logger::instance(), "Latencia comando->GPIO");
+        commandLatency.reset();
+        controlLoad.report(Logger::instance(), "Tarea control");
+        motorTicker.report(Logger::instance(), "Jitter tick motores");
+        LOG_INFO("Comandos: recibidos=%u aplicados=%u",
+            (unsigned)commandsReceived, (unsigned)conditioner.appliedCount());
+    }
+    // Integrar la posición con el movimiento que quedó en los motores
+    odometry.update(motorTicker.applied(), micros());
+    occupancyGrid.setPose(odometry.xCm(), odometry.yCm(), odometry.headingDeg());
+    if (millis() - lastStateReport >= STATE_REPORT_INTERVAL_MS) {
+        lastStateReport = millis();
+        MotorOutputs outputs = motorTicker.applied();
+        StateSnapshot snapshot;
+        snapshot.values[STATE_ACTION] = state;
+        snapshot.values[STATE_MOTION] = outputs.pwm ? MOTION_COUNT : outputs.motion;
+        snapshot.values[STATE_LEFT] = outputs.pwm ? outputs.left : 0;
+        snapshot.values[STATE_RIGHT] = outputs.pwm ? outputs.right : 0;
+        snapshot.values[STATE_DISTANCE] = (int32_t)rangeTracker.distance();
+        snapshot.values[STATE_X] = odometry.xCm();
+        snapshot.values[STATE_Y] = odometry.yCm();
+        snapshot.values[STATE_HEADING] = odometry.headingDeg();
+        snapshot.values[STATE_SPEED] = odometry.speedCmPerSecond();
+        snapshot.values[STATE_LOOP_US] = controlLoad.lastBusyUs();
+        webSocketController.send_state(snapshot);
+    }
+    if (millis() - lastMapExport >= MAP_EXPORT_INTERVAL_MS) {
+        lastMapExport = millis();
+        uint8_t mapDelta[MAP_EXPORT_BUFFER];
+        size_t length = occupancyGrid.exportDelta(mapDelta, sizeof(mapDelta));
+        if (length) {
+            webSocketController.send_binary(mapDelta, length);
+        }
+    }
+#ifdef SUPERCARRO_ALLOC_TRACKING
+    if (millis() - lastAllocReport >= ALLOC_REPORT_INTERVAL_MS) {
+        lastAllocReport = millis();
+        AllocTracker::report(Logger::instance());
+        char heapJson[ALLOC_JSON_MAX_BYTES];
+        size_t length = AllocTracker::toJson(heapJson, sizeof(heapJson));
+        if (length) {
+            webSocketController.send_text(heapJson, length);
+        }
+    }
+#endif
         // Actualizar el estado anterior
     previousState = state;
-    delay(10); // Pequeño retraso para evitar bucles rápidos
+    TRACE(TRACE_LOOP_END);
+    controlLoad.end();
+    // Periodo fijo: se descuenta lo que tardó esta vuelta
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(CONTROL_PERIOD_MS));
 }
@@ -0,0 +1,189 @@
+// Caché de DNS de AsyncClient::connect(host, port) (AsyncDnsCache) contra un
+// resolvedor de mentira con latencia fija, en tiempo virtual: un carro que se
+// reconecta al mismo servidor una y otra vez, más los casos de falla (respuesta
+// perdida, rechazo síncrono de lwIP, NXDOMAIN).
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "AsyncDnsCache.h"
+
+#include <cstdio>
+
+namespace {
+
+    const uint32_t RESOLVER_MS = 40;            // lo que tarda una consulta real
+    const uint32_t SERVER_ADDR = 0x0A01A8C0;    // 192.168.1.10
+    const uint32_t RECONNECT_MS = 3000;         // WS_RECONNECT_INTERVAL_MS del carro
+
+    AsyncClient* client(int i) {
+        static char clients[8];
+        return reinterpret_cast<AsyncClient*>(&clients[i]);
+    }
+
+    // Lo que hace connect(host) en AsyncTCP.cpp con cada resultado, con el
+    // resolvedor de mentira en lugar de dns_gethostbyname
+    struct Resolver {
+        AsyncDnsCache cache;
+        uint32_t queries = 0;
+
+        // Milisegundos hasta tener la dirección de host
+        uint32_t connect(const char* host, uint32_t now) {
+            AsyncDnsCache::entry_t* entry = nullptr;
+            switch (cache.lookup(host, now, &entry)) {
+                case AsyncDnsCache::DNS_CACHE_HIT:
+                    return 0;
+                case AsyncDnsCache::DNS_CACHE_JOIN:
+                    return entry->expires - CONFIG_ASYNC_TCP_DNS_PENDING_TIMEOUT + RESOLVER_MS - now;
+                case AsyncDnsCache::DNS_CACHE_QUERY:
+                    queries++;
+                    cache.store(entry, SERVER_ADDR, now + RESOLVER_MS, CONFIG_ASYNC_TCP_DNS_CACHE_TTL);
+                    return RESOLVER_MS;
+                default:
+                    return UINT32_MAX;
+            }
+        }
+    };
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_reconnect_loop_hit_rate_and_latency() {
+    // Una hora de reconexiones cada RECONNECT_MS a un servidor por nombre
+    Resolver resolver;
+    uint64_t totalMs = 0;
+    uint32_t attempts = 0;
+    for (uint32_t now = 1000; now < 3600000; now += RECONNECT_MS) {
+        totalMs += resolver.connect("supercarro.local", now);
+        attempts++;
+    }
+    float hitRate = (float)resolver.cache.hits / attempts;
+    float meanMs = (float)totalMs / attempts;
+    char line[160];
+    snprintf(line, sizeof(line), "reconexiones=%u consultas=%u aciertos=%.1f%% espera media=%.2fms (sin caché %ums)",
+        (unsigned)attempts, (unsigned)resolver.queries, hitRate * 100, meanMs, (unsigned)RESOLVER_MS);
+    TEST_MESSAGE(line);
+    // Una consulta por TTL
+    TEST_ASSERT_EQUAL_UINT32(3600000 / CONFIG_ASYNC_TCP_DNS_CACHE_TTL, resolver.queries);
+    TEST_ASSERT_TRUE(hitRate > 0.98f);
+    TEST_ASSERT_TRUE(meanMs < RESOLVER_MS / 10.0f);
+}
+
+void test_concurrent_connects_join_one_query() {
+    AsyncDnsCache cache;
+    AsyncDnsCache::entry_t* first = nullptr;
+    AsyncDnsCache::entry_t* other = nullptr;
+    TEST_ASSERT_EQUAL(AsyncDnsCache::DNS_CACHE_QUERY, cache.lookup("server", 100, &first));
+    TEST_ASSERT_EQUAL(AsyncDnsCache::DNS_CACHE_JOIN, cache.lookup("server", 110, &other));
+    TEST_ASSERT_TRUE(first == other);
+    cache.store(first, SERVER_ADDR, 140, CONFIG_ASYNC_TCP_DNS_CACHE_TTL);
+    TEST_ASSERT_EQUAL(AsyncDnsCache::DNS_CACHE_HIT, cache.lookup("server", 150, &other));
+    TEST_ASSERT_EQUAL_UINT32(SERVER_ADDR, other->addr);
+    TEST_ASSERT_EQUAL_UINT32(1, cache.misses);
+    TEST_ASSERT_EQUAL_UINT32(1, cache.joined);
+    TEST_ASSERT_EQUAL_UINT32(1, cache.hits);
+}
+
+void test_negative_answer_is_cached_briefly() {
+    AsyncDnsCache cache;
+    AsyncDnsCache::entry_t* entry = nullptr;
+    cache.lookup("nxdomain", 0, &entry);
+    cache.store(entry, 0, 40, CONFIG_ASYNC_TCP_DNS_NEGATIVE_TTL);
+    TEST_ASSERT_EQUAL(AsyncDnsCache::DNS_CACHE_HIT, cache.lookup("nxdomain", 1000, &entry));
+    TEST_ASSERT_EQUAL_UINT32(0, entry->addr);
+    TEST_ASSERT_EQUAL(AsyncDnsCache::DNS_CACHE_QUERY,
+        cache.lookup("nxdomain", 40 + CONFIG_ASYNC_TCP_DNS_NEGATIVE_TTL, &entry));
+}
+
+void test_synchronous_refusal_is_not_cached() {
+    // connect() guarda ERR_ARG/ERR_MEM con ttl 0: la próxima vez se vuelve a consultar
+    AsyncDnsCache cache;
+    AsyncDnsCache::entry_t* entry = nullptr;
+    cache.lookup("server", 0, &entry);
+    cache.store(entry, 0, 0, 0);
+    TEST_ASSERT_FALSE(entry->pending);
+    TEST_ASSERT_EQUAL(AsyncDnsCache::DNS_CACHE_QUERY, cache.lookup("server", 0, &entry));
+}
+
+void test_lost_answer_queries_again_for_its_waiters() {
+    // La respuesta no se pudo encolar: _dns_cache_lost() asienta la entrada sin
+    // caché y los clientes que esperaban la siguen esperando en ella
+    AsyncDnsCache cache;
+    AsyncDnsCache::entry_t* entry = nullptr;
+    cache.lookup("server", 0, &entry);
+    entry->waiters = client(0);
+    cache.store(entry, 0, 50, 0);
+    AsyncDnsCache::entry_t* again = nullptr;
+    TEST_ASSERT_EQUAL(AsyncDnsCache::DNS_CACHE_QUERY, cache.lookup("server", 60, &again));
+    TEST_ASSERT_TRUE(entry == again);
+    TEST_ASSERT_TRUE(again->waiters == client(0));
+    TEST_ASSERT_TRUE(again->pending);
+}
+
+void test_query_is_given_up_after_its_deadline() {
+    AsyncDnsCache cache;
+    AsyncDnsCache::entry_t* entry = nullptr;
+    cache.lookup("server", 0, &entry);
+    entry->waiters = client(0);
+    TEST_ASSERT_EQUAL(AsyncDnsCache::DNS_CACHE_JOIN,
+        cache.lookup("server", CONFIG_ASYNC_TCP_DNS_PENDING_TIMEOUT - 1, &entry));
+    TEST_ASSERT_EQUAL(AsyncDnsCache::DNS_CACHE_QUERY,
+        cache.lookup("server", CONFIG_ASYNC_TCP_DNS_PENDING_TIMEOUT, &entry));
+    TEST_ASSERT_TRUE(entry->waiters == client(0));
+    TEST_ASSERT_EQUAL_UINT32(2, cache.misses);
+}
+
+void test_entries_in_flight_are_not_evicted() {
+    AsyncDnsCache cache;
+    AsyncDnsCache::entry_t* entry = nullptr;
+    char name[16];
+    for (int i = 0; i < CONFIG_ASYNC_TCP_DNS_CACHE_SIZE; i++) {
+        snprintf(name, sizeof(name), "host%d", i);
+        TEST_ASSERT_EQUAL(AsyncDnsCache::DNS_CACHE_QUERY, cache.lookup(name, 0, &entry));
+    }
+    TEST_ASSERT_EQUAL(AsyncDnsCache::DNS_CACHE_FULL, cache.lookup("other", 0, &entry));
+    // Ni siquiera pasado el plazo: una respuesta tardía caería en el nombre equivocado
+    TEST_ASSERT_EQUAL(AsyncDnsCache::DNS_CACHE_FULL,
+        cache.lookup("other", 2 * CONFIG_ASYNC_TCP_DNS_PENDING_TIMEOUT, &entry));
+}
+
+void test_eviction_takes_the_entry_that_expires_first() {
+    AsyncDnsCache cache;
+    AsyncDnsCache::entry_t* entry = nullptr;
+    char name[16];
+    for (int i = 0; i < CONFIG_ASYNC_TCP_DNS_CACHE_SIZE; i++) {
+        snprintf(name, sizeof(name), "host%d", i);
+        cache.lookup(name, 0, &entry);
+        // host1 es el que vence primero
+        cache.store(entry, SERVER_ADDR, i == 1 ? 10 : 100, CONFIG_ASYNC_TCP_DNS_CACHE_TTL);
+    }
+    TEST_ASSERT_EQUAL(AsyncDnsCache::DNS_CACHE_QUERY, cache.lookup("other", 200, &entry));
+    for (int i = 0; i < CONFIG_ASYNC_TCP_DNS_CACHE_SIZE; i++) {
+        if (i != 1) {
+            snprintf(name, sizeof(name), "host%d", i);
+            TEST_ASSERT_EQUAL(AsyncDnsCache::DNS_CACHE_HIT, cache.lookup(name, 200, &entry));
+        }
+    }
+    // host1 ya no está: hay que volver a consultarlo
+    TEST_ASSERT_EQUAL(AsyncDnsCache::DNS_CACHE_QUERY, cache.lookup("host1", 200, &entry));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_reconnect_loop_hit_rate_and_latency);
+    RUN_TEST(test_concurrent_connects_join_one_query);
+    RUN_TEST(test_negative_answer_is_cached_briefly);
+    RUN_TEST(test_synchronous_refusal_is_not_cached);
+    RUN_TEST(test_lost_answer_queries_again_for_its_waiters);
+    RUN_TEST(test_query_is_given_up_after_its_deadline);
+    RUN_TEST(test_entries_in_flight_are_not_evicted);
+    RUN_TEST(test_eviction_takes_the_entry_that_expires_first);
+    return UNITY_END();
+}
@@ -0,0 +1,226 @@
+// Control de flujo de recepción de AsyncClient (AsyncRxWindow) con una
+// aplicación lenta. Simulación por pasos: el par manda segmentos mientras la
+// ventana de TCP se lo permite, la tarea async los entrega a onData y la
+// aplicación consume a su ritmo; lo que AsyncRxWindow manda a tcp_recved
+// reabre la ventana. Sin watermarks se confirma cada paquete y el buffer de
+// la aplicación crece sin límite.
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "AsyncRxWindow.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+namespace {
+
+    const uint32_t MSS = 1436;
+    const uint32_t TCP_WINDOW = 4 * MSS;        // TCP_WND de lwIP en el ESP32
+    const uint32_t LOW_WATERMARK = 2 * 1024;
+    const uint32_t HIGH_WATERMARK = 8 * 1024;
+    const uint32_t CONSUMER_BYTES_PER_STEP = 300;   // el par podría mandar un MSS por paso
+    const int POLL_STEPS = 125;                     // tcp_poll cada 125 ms con pasos de 1 ms
+    const int STEPS = 20000;
+
+    struct Result {
+        uint32_t delivered = 0;     // bytes entregados a onData
+        uint32_t maxBuffered = 0;   // pico del buffer de la aplicación
+        uint32_t acks = 0;          // llamadas a tcp_recved
+        uint32_t minAck = UINT32_MAX;
+    };
+
+    Result run(bool watermarks, uint32_t batch) {
+        AsyncRxWindow window;
+        if (watermarks) {
+            window.configure(LOW_WATERMARK, HIGH_WATERMARK, batch);
+        }
+        Result result;
+        uint32_t unacked = 0;       // enviados por el par y no devueltos con tcp_recved
+        uint32_t appBuffer = 0;
+        auto recved = [&](uint32_t len) {
+            if (len) {
+                unacked -= len;
+                result.acks++;
+                result.minAck = std::min(result.minAck, len);
+            }
+        };
+        for (int step = 0; step < STEPS; step++) {
+            if (TCP_WINDOW - unacked >= MSS) {
+                unacked += MSS;
+                appBuffer += MSS;
+                result.delivered += MSS;
+                recved(watermarks ? window.received(MSS) : MSS);
+            }
+            result.maxBuffered = std::max(result.maxBuffered, appBuffer);
+            uint32_t consumed = std::min(appBuffer, CONSUMER_BYTES_PER_STEP);
+            appBuffer -= consumed;
+            // consumed() desde la tarea de la aplicación: la async lo aplica al atender el evento
+            if (watermarks && consumed && window.consumed(consumed)) {
+                recved(window.apply());
+            }
+            if (watermarks && step % POLL_STEPS == 0) {
+                recved(window.flush());
+            }
+        }
+        return result;
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_slow_consumer_keeps_memory_bounded() {
+    Result plain = run(false, 0);
+    Result limited = run(true, ASYNC_RX_ACK_BATCH);
+    char line[160];
+    snprintf(line, sizeof(line), "sin watermarks: pico=%uB; con watermarks: pico=%uB",
+        (unsigned)plain.maxBuffered, (unsigned)limited.maxBuffered);
+    TEST_MESSAGE(line);
+    // Por encima de HIGH_WATERMARK ya no se confirma nada: a lo sumo entra una ventana más
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(HIGH_WATERMARK + TCP_WINDOW, limited.maxBuffered);
+    TEST_ASSERT_GREATER_THAN_UINT32(10 * HIGH_WATERMARK, plain.maxBuffered);
+}
+
+void test_slow_consumer_keeps_its_throughput() {
+    Result limited = run(true, ASYNC_RX_ACK_BATCH);
+    uint32_t consumerBytes = STEPS * CONSUMER_BYTES_PER_STEP;
+    char line[160];
+    snprintf(line, sizeof(line), "entregados=%u de %u que la aplicación puede consumir, tcp_recved=%u",
+        (unsigned)limited.delivered, (unsigned)consumerBytes, (unsigned)limited.acks);
+    TEST_MESSAGE(line);
+    // La ventana se reabre antes de que la aplicación se quede sin datos
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(consumerBytes - HIGH_WATERMARK, limited.delivered);
+}
+
+void test_acks_are_batched_by_their_own_setting() {
+    // Con una aplicación rápida nunca se llega a HIGH_WATERMARK: solo manda el tamaño del lote
+    AsyncRxWindow window;
+    window.configure(LOW_WATERMARK, HIGH_WATERMARK, 3 * MSS);
+    uint32_t acked = 0;
+    int acks = 0;
+    for (int i = 0; i < 30; i++) {
+        uint32_t len = window.received(MSS);
+        if (len) {
+            TEST_ASSERT_EQUAL_UINT32(3 * MSS, len);
+            acks++;
+            acked += len;
+        }
+        window.consumed(MSS);
+        window.apply();
+    }
+    TEST_ASSERT_EQUAL(10, acks);
+    TEST_ASSERT_EQUAL_UINT32(30 * MSS, acked);
+}
+
+void test_held_bytes_are_released_at_the_low_watermark() {
+    AsyncRxWindow window;
+    window.configure(LOW_WATERMARK, HIGH_WATERMARK, 0);
+    uint32_t held = 0;
+    while (window.buffered() < HIGH_WATERMARK) {
+        window.received(MSS);
+    }
+    held += window.received(MSS);
+    TEST_ASSERT_EQUAL_UINT32(0, held);
+    // Consumir hasta quedar apenas por encima de LOW_WATERMARK no alcanza
+    TEST_ASSERT_TRUE(window.consumed(window.buffered() - LOW_WATERMARK - 1));
+    TEST_ASSERT_EQUAL_UINT32(0, window.apply());
+    TEST_ASSERT_TRUE(window.consumed(1));
+    TEST_ASSERT_GREATER_THAN_UINT32(0, window.apply());
+    TEST_ASSERT_EQUAL_UINT32(LOW_WATERMARK, window.buffered());
+}
+
+void test_poll_flushes_a_partial_batch() {
+    AsyncRxWindow window;
+    window.configure(LOW_WATERMARK, HIGH_WATERMARK, 4 * MSS);
+    TEST_ASSERT_EQUAL_UINT32(0, window.received(MSS));
+    window.consumed(MSS);
+    TEST_ASSERT_EQUAL_UINT32(0, window.apply());
+    TEST_ASSERT_EQUAL_UINT32(MSS, window.flush());
+    TEST_ASSERT_EQUAL_UINT32(0, window.flush());
+}
+
+void test_only_the_first_pending_report_wakes_the_async_task() {
+    AsyncRxWindow window;
+    window.configure(LOW_WATERMARK, HIGH_WATERMARK, MSS);
+    window.received(MSS);
+    TEST_ASSERT_TRUE(window.consumed(100));
+    TEST_ASSERT_FALSE(window.consumed(100));
+    TEST_ASSERT_TRUE(window.pending());
+    window.apply();
+    TEST_ASSERT_FALSE(window.pending());
+    TEST_ASSERT_EQUAL_UINT32(MSS - 200, window.buffered());
+    TEST_ASSERT_TRUE(window.consumed(100));
+}
+
+void test_disabling_releases_everything_held() {
+    AsyncRxWindow window;
+    window.configure(LOW_WATERMARK, HIGH_WATERMARK, 4 * MSS);
+    TEST_ASSERT_EQUAL_UINT32(0, window.received(MSS));
+    TEST_ASSERT_EQUAL_UINT32(0, window.received(MSS));
+    TEST_ASSERT_EQUAL_UINT32(2 * MSS, window.configure(0, 0, 0));
+    TEST_ASSERT_FALSE(window.enabled());
+    TEST_ASSERT_EQUAL_UINT32(0, window.buffered());
+}
+
+void test_consumed_from_another_task() {
+    // Un hilo hace de aplicación (consumed) y otro de tarea async (received/apply):
+    // al final todo lo recibido se confirmó y no queda nada en el buffer
+    AsyncRxWindow window;
+    window.configure(LOW_WATERMARK, HIGH_WATERMARK, ASYNC_RX_ACK_BATCH);
+    const uint32_t TOTAL = 4 * 1024 * 1024;
+    std::atomic<uint32_t> delivered{0};
+    std::atomic<bool> done{false};
+    uint32_t acked = 0;
+    std::thread app([&] {
+        uint32_t consumed = 0;
+        while (consumed < TOTAL) {
+            uint32_t available = delivered - consumed;
+            if (available) {
+                uint32_t len = std::min(available, (uint32_t)700);
+                window.consumed(len);
+                consumed += len;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        done = true;
+    });
+    uint32_t sent = 0;
+    while (!done || window.pending()) {
+        if (sent < TOTAL && sent - acked < TCP_WINDOW) {
+            uint32_t len = std::min(MSS, TOTAL - sent);
+            sent += len;
+            acked += window.received(len);
+            delivered += len;
+        } else {
+            std::this_thread::yield();
+        }
+        acked += window.apply();
+    }
+    app.join();
+    acked += window.flush();
+    TEST_ASSERT_EQUAL_UINT32(TOTAL, acked);
+    TEST_ASSERT_EQUAL_UINT32(0, window.buffered());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_slow_consumer_keeps_memory_bounded);
+    RUN_TEST(test_slow_consumer_keeps_its_throughput);
+    RUN_TEST(test_acks_are_batched_by_their_own_setting);
+    RUN_TEST(test_held_bytes_are_released_at_the_low_watermark);
+    RUN_TEST(test_poll_flushes_a_partial_batch);
+    RUN_TEST(test_only_the_first_pending_report_wakes_the_async_task);
+    RUN_TEST(test_disabling_releases_everything_held);
+    RUN_TEST(test_consumed_from_another_task);
+    return UNITY_END();
+}
@@ -0,0 +1,197 @@
+// Benchmark de la cola de eventos de AsyncTCP con y sin coalescing de
+// SENT/POLL. Un hilo hace de lwIP (productor, bloquea si la cola de 32 está
+// llena, igual que xQueueSend con portMAX_DELAY) y otro de la tarea async_tcp
+// (consumidor con un coste fijo por evento, como el alta/baja en el WDT).
+// Se simula una subida de varios MB por varias conexiones.
+// Solo se comprueban cuentas de eventos; el rendimiento en MB/s depende de la
+// máquina y queda como mensaje.
+
+#include <unity.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include "AllocTracker.h"
+#include "AsyncEventCoalescer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    enum { EV_SENT, EV_RECV, EV_POLL, EV_END };
+
+    const int CONNECTIONS = 4;
+    const uint32_t UPLOAD_BYTES = 2 * 1024 * 1024;      // por conexión
+    const uint16_t ACKED_PER_SENT = 2 * 1460;           // ACK cada dos segmentos
+    const int SENT_PER_POLL = 16;
+    const int SENT_PER_RECV = 64;
+    const uint32_t PRODUCER_COST_NS = 2000;
+    const uint32_t CONSUMER_COST_NS = 20000;
+
+    struct Packet {
+        int event;
+        void* arg;
+        void* pcb;
+        uint16_t len;
+    };
+
+    // Secuencia de una conexión con los SENT consecutivos sumados y los POLL
+    // consecutivos colapsados: es lo que el coalescing debe conservar
+    typedef std::vector<std::pair<int, uint32_t>> Sequence;
+
+    void append(Sequence& sequence, int event, uint32_t len) {
+        if (!sequence.empty() && sequence.back().first == event && event != EV_RECV) {
+            sequence.back().second += len;
+        } else {
+            sequence.emplace_back(event, len);
+        }
+    }
+
+    void spin(uint32_t ns) {
+        auto end = std::chrono::steady_clock::now() + std::chrono::nanoseconds(ns);
+        while (std::chrono::steady_clock::now() < end) {
+        }
+    }
+
+    struct Result {
+        uint32_t events = 0;
+        uint32_t queued = 0;
+        uint32_t coalesced = 0;
+        uint32_t handled = 0;
+        uint64_t ackedBytes = 0;
+        double seconds = 0;
+        Sequence produced[CONNECTIONS];
+        Sequence consumed[CONNECTIONS];
+    };
+
+    void run(bool coalesce, Result& result) {
+        AsyncEventCoalescer* coalescer = new AsyncEventCoalescer();
+        QueueHandle_t queue = xQueueCreate(32, sizeof(Packet*));
+        int clients[CONNECTIONS];
+        int pcbs[CONNECTIONS];
+
+        auto send = [&](Packet* packet, bool tracked) {
+            if (tracked) {
+                coalescer->track(packet->arg, packet->event, packet->pcb, packet,
+                    packet->event == EV_SENT ? &packet->len : nullptr);
+            }
+            xQueueSend(queue, &packet, portMAX_DELAY);
+            result.queued++;
+        };
+
+        auto event = [&](int client, int kind, uint16_t len) {
+            void* arg = &clients[client];
+            void* pcb = &pcbs[client];
+            append(result.produced[client], kind, len);
+            result.events++;
+            bool foldable = kind == EV_SENT || kind == EV_POLL;
+            if (coalesce && foldable && coalescer->fold(arg, kind, pcb, len)) {
+                result.coalesced++;
+                return;
+            }
+            if (coalesce && !foldable) {
+                coalescer->forget(arg);
+            }
+            Packet* packet = (Packet*)malloc(sizeof(Packet));
+            *packet = Packet{kind, arg, pcb, len};
+            send(packet, coalesce && foldable);
+        };
+
+        std::thread consumer([&] {
+            for (;;) {
+                Packet* packet;
+                xQueueReceive(queue, &packet, portMAX_DELAY);
+                if (packet->event == EV_END) {
+                    free(packet);
+                    return;
+                }
+                result.handled++;
+                coalescer->handled(packet);
+                int client = (int*)packet->arg - clients;
+                append(result.consumed[client], packet->event, packet->len);
+                if (packet->event == EV_SENT) {
+                    result.ackedBytes += packet->len;
+                }
+                spin(CONSUMER_COST_NS);
+                free(packet);
+            }
+        });
+
+        auto start = std::chrono::steady_clock::now();
+        uint32_t acks = UPLOAD_BYTES / ACKED_PER_SENT;
+        for (uint32_t ack = 1; ack <= acks; ack++) {
+            for (int client = 0; client < CONNECTIONS; client++) {
+                spin(PRODUCER_COST_NS);
+                event(client, EV_SENT, ACKED_PER_SENT);
+                if (ack % SENT_PER_POLL == 0) {
+                    event(client, EV_POLL, 0);
+                }
+                if (ack % SENT_PER_RECV == 0) {
+                    event(client, EV_RECV, 64);
+                }
+            }
+        }
+        Packet* end = (Packet*)malloc(sizeof(Packet));
+        *end = Packet{EV_END, nullptr, nullptr, 0};
+        send(end, false);
+        consumer.join();
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        vQueueDelete(queue);
+        delete coalescer;
+    }
+
+    void report(const char* label, const Result& result) {
+        char line[160];
+        snprintf(line, sizeof(line), "%s: encolados=%u fusionados=%u atendidos=%u %.2f MB/s",
+            label, (unsigned)result.queued, (unsigned)result.coalesced, (unsigned)result.handled,
+            result.ackedBytes / result.seconds / 1e6);
+        TEST_MESSAGE(line);
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_coalescing_keeps_per_connection_order() {
+    Result result;
+    run(true, result);
+    for (int client = 0; client < CONNECTIONS; client++) {
+        TEST_ASSERT_TRUE(result.produced[client] == result.consumed[client]);
+    }
+    TEST_ASSERT_EQUAL_UINT32((uint64_t)CONNECTIONS * (UPLOAD_BYTES / ACKED_PER_SENT) * ACKED_PER_SENT,
+        result.ackedBytes);
+}
+
+void test_coalescing_reduces_handled_events() {
+    Result plain;
+    Result coalesced;
+    run(false, plain);
+    run(true, coalesced);
+    report("sin coalescing", plain);
+    report("con coalescing", coalesced);
+    TEST_ASSERT_EQUAL_UINT32(0, plain.coalesced);
+    TEST_ASSERT_EQUAL_UINT32(plain.events, plain.handled);
+    // Todo evento o se encoló (más el de fin) o se fusionó con uno encolado
+    TEST_ASSERT_EQUAL_UINT32(coalesced.events, coalesced.handled + coalesced.coalesced);
+    TEST_ASSERT_EQUAL_UINT32(coalesced.queued, coalesced.handled + 1);
+    TEST_ASSERT_TRUE(plain.ackedBytes == coalesced.ackedBytes);
+    TEST_ASSERT_LESS_THAN(plain.handled / 2, coalesced.handled);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_coalescing_keeps_per_connection_order);
+    RUN_TEST(test_coalescing_reduces_handled_events);
+    return UNITY_END();
+}
@@ -0,0 +1,185 @@
+// Reservas de memoria por trama de comando, de punta a punta: un servidor
+// WebSocket local manda comandos, WebSocketController los recibe con el
+// cliente del shim, los interpreta y los encola, y la "tarea de control" los
+// saca. AllocTracker cuenta las reservas de cada categoría (red, json, loop).
+// Solo tiene sentido con -DSUPERCARRO_ALLOC_TRACKING: pio test -e native_alloc
+
+#include <unity.h>
+
+#include <NativeShim.h>
+
+#include "AllocTracker.h"
+#include "WebServerController.h"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#ifdef SUPERCARRO_ALLOC_TRACKING
+
+namespace {
+
+    const int FRAMES = 1000;
+    // Lo que entra en la cola hacia el control sin descartar
+    const int BATCH = 4;
+
+    // Servidor WebSocket de una sola conexión: contesta el handshake desde
+    // su hilo (connect() espera la respuesta) y después el test manda las
+    // tramas por fd
+    class FrameServer {
+        public:
+            FrameServer() {
+                listener = socket(AF_INET, SOCK_STREAM, 0);
+                sockaddr_in addr = {};
+                addr.sin_family = AF_INET;
+                addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                bind(listener, (sockaddr*)&addr, sizeof(addr));
+                socklen_t length = sizeof(addr);
+                getsockname(listener, (sockaddr*)&addr, &length);
+                port = ntohs(addr.sin_port);
+                listen(listener, 1);
+                acceptor = std::thread([this] { run(); });
+            }
+
+            ~FrameServer() {
+                shutdown(listener, SHUT_RDWR);
+                acceptor.join();
+                if (fd >= 0) {
+                    close(fd);
+                }
+                close(listener);
+            }
+
+            // Trama de texto sin máscara, como las manda un servidor
+            bool sendText(const char* text, size_t length) {
+                uint8_t header[2] = {0x81, (uint8_t)length};
+                return send(fd, header, sizeof(header), MSG_NOSIGNAL) == 2
+                    && send(fd, text, length, MSG_NOSIGNAL) == (ssize_t)length;
+            }
+
+            uint16_t port;
+            std::atomic<bool> upgraded{false};
+
+        private:
+            void run() {
+                int client = accept(listener, nullptr, nullptr);
+                if (client < 0) {
+                    return;
+                }
+                std::string request;
+                char buffer[512];
+                while (request.find("\r\n\r\n") == std::string::npos) {
+                    ssize_t length = recv(client, buffer, sizeof(buffer), 0);
+                    if (length <= 0) {
+                        close(client);
+                        return;
+                    }
+                    request.append(buffer, length);
+                }
+                const char* response = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                    "Connection: Upgrade\r\nSec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n\r\n";
+                send(client, response, strlen(response), MSG_NOSIGNAL);
+                fd = client;
+                upgraded = true;
+            }
+
+            int listener;
+            int fd = -1;
+            std::thread acceptor;
+    };
+
+    int commandFrame(char* out, size_t size, int seq) {
+        return snprintf(out, size, "{\"throttle\":%d,\"steering\":%d,\"seq\":%d}", 40 + seq % 50, -(seq % 30), seq);
+    }
+
+}
+
+#endif
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_allocations_per_command_frame() {
+#ifndef SUPERCARRO_ALLOC_TRACKING
+    TEST_IGNORE_MESSAGE("compilar con -DSUPERCARRO_ALLOC_TRACKING (pio test -e native_alloc)");
+#else
+    FrameServer server;
+    WebSocketController controller("ssid", "clave", "127.0.0.1", server.port);
+    controller.begin();
+    TEST_ASSERT_TRUE(server.upgraded.load());
+
+    AllocTracker::Snapshot before = AllocTracker::snapshot();
+    int taken = 0;
+    int dropped = 0;
+    char frame[64];
+    for (int seq = 1; seq <= FRAMES; seq += BATCH) {
+        for (int i = 0; i < BATCH; i++) {
+            int length = commandFrame(frame, sizeof(frame), seq + i);
+            TEST_ASSERT_TRUE(server.sendText(frame, length));
+        }
+        // Tarea de red y de control por turnos hasta sacar el lote
+        for (int attempt = 0; attempt < 10000 && taken + dropped < seq + BATCH - 1; attempt++) {
+            controller.loop();
+            ALLOC_SCOPE(ALLOC_LOOP);
+            Command command;
+            while (controller.take_command(command)) {
+                taken++;
+            }
+            dropped += controller.take_dropped_commands();
+            if (taken + dropped < seq + BATCH - 1) {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+    AllocTracker::Snapshot after = AllocTracker::snapshot();
+    uint32_t network = after.allocations[ALLOC_NETWORK] - before.allocations[ALLOC_NETWORK];
+    uint32_t json = after.allocations[ALLOC_JSON] - before.allocations[ALLOC_JSON];
+    uint32_t loop = after.allocations[ALLOC_LOOP] - before.allocations[ALLOC_LOOP];
+
+    // Lo que costaría además una copia del mensaje: el callback de la
+    // librería ArduinoWebsockets lo recibe por valor, así que en el ESP32 el
+    // contenido se copia una vez antes de llegar a handleFrame
+    int length = commandFrame(frame, sizeof(frame), FRAMES);
+    websockets::WebsocketsMessage message(websockets::MessageType::Text, std::string(frame, length));
+    AllocTracker::Snapshot beforeCopy = AllocTracker::snapshot();
+    {
+        websockets::WebsocketsMessage copy = message;
+        TEST_ASSERT_EQUAL(message.length(), copy.length());
+    }
+    AllocTracker::Snapshot afterCopy = AllocTracker::snapshot();
+    uint32_t copy = afterCopy.allocations[ALLOC_OTHER] - beforeCopy.allocations[ALLOC_OTHER];
+
+    char line[200];
+    snprintf(line, sizeof(line), "%d tramas: red=%.2f json=%.2f loop=%.2f reservas por trama; "
+        "copia del mensaje por valor=%u reservas",
+        FRAMES, (double)network / FRAMES, (double)json / FRAMES, (double)loop / FRAMES, (unsigned)copy);
+    TEST_MESSAGE(line);
+
+    TEST_ASSERT_EQUAL(FRAMES, taken + dropped);
+    TEST_ASSERT_EQUAL(0, dropped);
+    // Interpretar el comando y encolarlo no reserva nada; sacarlo tampoco
+    TEST_ASSERT_EQUAL_UINT32(0, json);
+    TEST_ASSERT_EQUAL_UINT32(0, loop);
+    // En el shim queda una por trama: el payload que arma el cliente al
+    // separar las tramas (más algún crecimiento de su buffer de recepción)
+    TEST_ASSERT_LESS_OR_EQUAL(FRAMES + 16, network);
+    TEST_ASSERT_EQUAL_UINT32(1, copy);
+#endif
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_allocations_per_command_frame);
+    return UNITY_END();
+}
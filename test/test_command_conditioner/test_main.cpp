@@ -0,0 +1,105 @@
+// CommandConditioner: permanencia mínima, ráfagas, parada antes de invertir
+// y STOP inmediato
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "CommandConditioner.h"
+
+namespace {
+
+    const uint32_t MS = 1000;
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_first_motion_from_stop_is_immediate() {
+    CommandConditioner conditioner;
+    conditioner.request(MOTION_FORWARD);
+    TEST_ASSERT_EQUAL(MOTION_FORWARD, conditioner.update(1 * MS));
+    TEST_ASSERT_EQUAL_UINT32(1, conditioner.appliedCount());
+}
+
+void test_changes_wait_for_the_minimum_dwell() {
+    CommandConditioner conditioner;
+    conditioner.request(MOTION_FORWARD);
+    conditioner.update(0);
+    conditioner.request(MOTION_LEFT);
+    TEST_ASSERT_EQUAL(MOTION_FORWARD, conditioner.update((COMMAND_MIN_DWELL_MS - 1) * MS));
+    TEST_ASSERT_EQUAL(MOTION_LEFT, conditioner.update(COMMAND_MIN_DWELL_MS * MS));
+}
+
+void test_burst_within_the_dwell_collapses_to_the_last() {
+    CommandConditioner conditioner;
+    conditioner.request(MOTION_FORWARD);
+    conditioner.update(0);
+    conditioner.request(MOTION_LEFT);
+    conditioner.update(30 * MS);
+    conditioner.request(MOTION_RIGHT);
+    conditioner.update(60 * MS);
+    conditioner.request(MOTION_FORWARD);
+    conditioner.update(90 * MS);
+    // LEFT/RIGHT/FORWARD dentro de la permanencia: no hubo ningún cambio
+    TEST_ASSERT_EQUAL(MOTION_FORWARD, conditioner.update(COMMAND_MIN_DWELL_MS * MS));
+    TEST_ASSERT_EQUAL_UINT32(1, conditioner.appliedCount());
+}
+
+void test_reversal_stops_first() {
+    CommandConditioner conditioner;
+    conditioner.request(MOTION_FORWARD);
+    conditioner.update(0);
+    conditioner.request(MOTION_BACKWARD);
+    uint32_t now = COMMAND_MIN_DWELL_MS * MS;
+    TEST_ASSERT_EQUAL(MOTION_STOP, conditioner.update(now));
+    TEST_ASSERT_EQUAL(MOTION_STOP, conditioner.update(now + (COMMAND_REVERSAL_STOP_MS - 1) * MS));
+    TEST_ASSERT_EQUAL(MOTION_BACKWARD, conditioner.update(now + COMMAND_REVERSAL_STOP_MS * MS));
+    TEST_ASSERT_EQUAL_UINT32(3, conditioner.appliedCount());
+}
+
+void test_stop_is_immediate() {
+    CommandConditioner conditioner;
+    conditioner.request(MOTION_LEFT);
+    conditioner.update(0);
+    conditioner.request(MOTION_STOP);
+    TEST_ASSERT_EQUAL(MOTION_STOP, conditioner.update(1 * MS));
+}
+
+void test_stop_during_reversal_pause_cancels_it() {
+    CommandConditioner conditioner;
+    conditioner.request(MOTION_LEFT);
+    conditioner.update(0);
+    conditioner.request(MOTION_RIGHT);
+    uint32_t now = COMMAND_MIN_DWELL_MS * MS;
+    conditioner.update(now);
+    conditioner.request(MOTION_STOP);
+    TEST_ASSERT_EQUAL(MOTION_STOP, conditioner.update(now + COMMAND_REVERSAL_STOP_MS * MS));
+    TEST_ASSERT_EQUAL(MOTION_STOP, conditioner.update(now + 10 * COMMAND_REVERSAL_STOP_MS * MS));
+}
+
+void test_repeated_requests_do_not_count_as_changes() {
+    CommandConditioner conditioner;
+    for (uint32_t i = 0; i < 20; i++) {
+        conditioner.request(MOTION_FORWARD);
+        conditioner.update(i * 30 * MS);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, conditioner.appliedCount());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_motion_from_stop_is_immediate);
+    RUN_TEST(test_changes_wait_for_the_minimum_dwell);
+    RUN_TEST(test_burst_within_the_dwell_collapses_to_the_last);
+    RUN_TEST(test_reversal_stops_first);
+    RUN_TEST(test_stop_is_immediate);
+    RUN_TEST(test_stop_during_reversal_pause_cancels_it);
+    RUN_TEST(test_repeated_requests_do_not_count_as_changes);
+    return UNITY_END();
+}
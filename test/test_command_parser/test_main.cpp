@@ -0,0 +1,147 @@
+// CommandParser: lectura en una pasada de los comandos JSON del servidor
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "CommandParser.h"
+
+#include <cstring>
+
+namespace {
+
+    bool parse(const char* text, CommandFields& fields) {
+        return CommandParser::parse(text, strlen(text), fields);
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_state_is_borrowed_from_the_message() {
+    const char* text = "{\"state\":\"FORWARD\",\"seq\":12}";
+    CommandFields fields;
+    TEST_ASSERT_TRUE(parse(text, fields));
+    TEST_ASSERT_TRUE(fields.has(FIELD_STATE));
+    TEST_ASSERT_TRUE(fields.state > text && fields.state < text + strlen(text));
+    TEST_ASSERT_EQUAL(7, fields.stateLength);
+    TEST_ASSERT_EQUAL_MEMORY("FORWARD", fields.state, 7);
+    TEST_ASSERT_TRUE(fields.has(FIELD_SEQ));
+    TEST_ASSERT_EQUAL_UINT32(12, fields.seq);
+}
+
+void test_continuous_values_and_whitespace() {
+    CommandFields fields;
+    TEST_ASSERT_TRUE(parse(" {\n \"throttle\" : -80 ,\t\"steering\":25.7 }", fields));
+    TEST_ASSERT_TRUE(fields.has(FIELD_THROTTLE));
+    TEST_ASSERT_TRUE(fields.has(FIELD_STEERING));
+    TEST_ASSERT_FALSE(fields.has(FIELD_STATE));
+    TEST_ASSERT_EQUAL_INT32(-80, fields.throttle);
+    // La parte decimal se descarta
+    TEST_ASSERT_EQUAL_INT32(25, fields.steering);
+    TEST_ASSERT_TRUE(parse("{\"left\":60,\"right\":-1e2}", fields));
+    TEST_ASSERT_EQUAL_INT32(60, fields.left);
+    TEST_ASSERT_EQUAL_INT32(-1, fields.right);
+}
+
+void test_seq_and_ack_cover_the_full_unsigned_range() {
+    CommandFields fields;
+    TEST_ASSERT_TRUE(parse("{\"seq\":4294967295,\"ack\":99999999999}", fields));
+    TEST_ASSERT_EQUAL_UINT32(4294967295u, fields.seq);
+    TEST_ASSERT_EQUAL_UINT32(4294967295u, fields.ack);
+    TEST_ASSERT_TRUE(parse("{\"throttle\":-99999999999}", fields));
+    TEST_ASSERT_EQUAL_INT32(INT32_MIN, fields.throttle);
+}
+
+void test_unknown_keys_and_nested_values_are_skipped() {
+    CommandFields fields;
+    TEST_ASSERT_TRUE(parse("{\"meta\":{\"a\":[1,{\"state\":\"LEFT\"}],\"b\":\"}\"},"
+        "\"list\":[[],[\"]\"]],\"x\":null,\"y\":false,\"state\":\"STOP\"}", fields));
+    TEST_ASSERT_EQUAL(FIELD_STATE, fields.present);
+    TEST_ASSERT_EQUAL_MEMORY("STOP", fields.state, 4);
+}
+
+void test_escaped_quotes_are_kept_as_they_are() {
+    CommandFields fields;
+    TEST_ASSERT_TRUE(parse("{\"note\":\"say \\\"hi\\\"\",\"state\":\"A\\\"B\"}", fields));
+    TEST_ASSERT_EQUAL(4, fields.stateLength);
+    TEST_ASSERT_EQUAL_MEMORY("A\\\"B", fields.state, 4);
+}
+
+void test_heartbeat_with_any_value_and_compress() {
+    CommandFields fields;
+    TEST_ASSERT_TRUE(parse("{\"heartbeat\":{\"t\":1}}", fields));
+    TEST_ASSERT_TRUE(fields.has(FIELD_HEARTBEAT));
+    TEST_ASSERT_TRUE(parse("{\"heartbeat\":true,\"compress\":true}", fields));
+    TEST_ASSERT_TRUE(fields.has(FIELD_HEARTBEAT));
+    TEST_ASSERT_TRUE(fields.has(FIELD_COMPRESS));
+    TEST_ASSERT_TRUE(fields.compress);
+    TEST_ASSERT_TRUE(parse("{\"compress\":false}", fields));
+    TEST_ASSERT_FALSE(fields.compress);
+    TEST_ASSERT_TRUE(parse("{\"compress\":1}", fields));
+    TEST_ASSERT_TRUE(fields.compress);
+}
+
+void test_watchdog_timeout_is_never_negative() {
+    CommandFields fields;
+    TEST_ASSERT_TRUE(parse("{\"watchdog_ms\":250}", fields));
+    TEST_ASSERT_TRUE(fields.has(FIELD_WATCHDOG));
+    TEST_ASSERT_EQUAL_UINT32(250, fields.watchdogMs);
+    TEST_ASSERT_TRUE(parse("{\"watchdog_ms\":-5}", fields));
+    TEST_ASSERT_EQUAL_UINT32(0, fields.watchdogMs);
+}
+
+void test_empty_object_has_no_fields() {
+    CommandFields fields;
+    TEST_ASSERT_TRUE(parse("{ }", fields));
+    TEST_ASSERT_EQUAL(0, fields.present);
+}
+
+void test_malformed_messages_are_rejected() {
+    const char* bad[] = {
+        "",
+        "[1,2]",
+        "\"state\"",
+        "{\"state\":\"FORWARD\"",
+        "{\"state\" \"FORWARD\"}",
+        "{\"state\":\"FORWARD}",
+        "{\"seq\":-}",
+        "{\"a\":[1,2}",
+        "{\"a\":nul}",
+        "{\"a\":1,}",
+        "{state:1}",
+    };
+    for (const char* text : bad) {
+        CommandFields fields;
+        TEST_ASSERT_FALSE_MESSAGE(parse(text, fields), text);
+    }
+}
+
+void test_only_the_given_length_is_read() {
+    // El mensaje no termina en '\0': lo que sigue no es parte de él
+    const char buffer[] = "{\"seq\":5}{\"seq\":6}";
+    CommandFields fields;
+    TEST_ASSERT_TRUE(CommandParser::parse(buffer, 9, fields));
+    TEST_ASSERT_EQUAL_UINT32(5, fields.seq);
+    TEST_ASSERT_FALSE(CommandParser::parse(buffer, 8, fields));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_state_is_borrowed_from_the_message);
+    RUN_TEST(test_continuous_values_and_whitespace);
+    RUN_TEST(test_seq_and_ack_cover_the_full_unsigned_range);
+    RUN_TEST(test_unknown_keys_and_nested_values_are_skipped);
+    RUN_TEST(test_escaped_quotes_are_kept_as_they_are);
+    RUN_TEST(test_heartbeat_with_any_value_and_compress);
+    RUN_TEST(test_watchdog_timeout_is_never_negative);
+    RUN_TEST(test_empty_object_has_no_fields);
+    RUN_TEST(test_malformed_messages_are_rejected);
+    RUN_TEST(test_only_the_given_length_is_read);
+    return UNITY_END();
+}
@@ -0,0 +1,101 @@
+// CommandSequence: por UDP gana el comando más nuevo y por TCP solo se
+// cuentan los huecos
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "CommandSequence.h"
+
+namespace {
+
+    bool accept(CommandSequence& sequence, uint32_t seq) {
+        uint32_t lost = 0;
+        return sequence.accept(seq, lost);
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_udp_newest_wins() {
+    CommandSequence udp(true);
+    TEST_ASSERT_TRUE(accept(udp, 5));
+    TEST_ASSERT_TRUE(accept(udp, 7));
+    // 6 llegó después de 7: ya no vale
+    TEST_ASSERT_FALSE(accept(udp, 6));
+    TEST_ASSERT_TRUE(accept(udp, 8));
+    TEST_ASSERT_EQUAL_UINT32(8, udp.last());
+}
+
+void test_udp_drops_duplicates_and_missing_seq() {
+    CommandSequence udp(true);
+    TEST_ASSERT_FALSE(accept(udp, 0));
+    TEST_ASSERT_TRUE(accept(udp, 3));
+    TEST_ASSERT_FALSE(accept(udp, 3));
+    TEST_ASSERT_FALSE(accept(udp, 0));
+    TEST_ASSERT_EQUAL_UINT32(3, udp.last());
+}
+
+void test_udp_seq_wraps_around() {
+    CommandSequence udp(true);
+    TEST_ASSERT_TRUE(accept(udp, 0xFFFFFFFE));
+    TEST_ASSERT_TRUE(accept(udp, 0xFFFFFFFF));
+    TEST_ASSERT_TRUE(accept(udp, 1));
+    TEST_ASSERT_FALSE(accept(udp, 0xFFFFFFFF));
+}
+
+void test_gaps_count_lost_commands() {
+    CommandSequence udp(true);
+    uint32_t lost = 0;
+    TEST_ASSERT_TRUE(udp.accept(10, lost));
+    TEST_ASSERT_EQUAL_UINT32(0, lost);
+    TEST_ASSERT_TRUE(udp.accept(11, lost));
+    TEST_ASSERT_EQUAL_UINT32(0, lost);
+    TEST_ASSERT_TRUE(udp.accept(15, lost));
+    TEST_ASSERT_EQUAL_UINT32(3, lost);
+    // Uno rechazado no cuenta como pérdida
+    TEST_ASSERT_FALSE(udp.accept(14, lost));
+    TEST_ASSERT_EQUAL_UINT32(0, lost);
+}
+
+void test_tcp_accepts_everything_and_counts_gaps() {
+    CommandSequence tcp(false);
+    uint32_t lost = 0;
+    TEST_ASSERT_TRUE(tcp.accept(0, lost));
+    TEST_ASSERT_TRUE(tcp.accept(1, lost));
+    TEST_ASSERT_TRUE(tcp.accept(0, lost));
+    TEST_ASSERT_EQUAL_UINT32(1, tcp.last());
+    TEST_ASSERT_TRUE(tcp.accept(4, lost));
+    TEST_ASSERT_EQUAL_UINT32(2, lost);
+    // Un servidor reiniciado vuelve a empezar sin sumar pérdidas
+    TEST_ASSERT_TRUE(tcp.accept(1, lost));
+    TEST_ASSERT_EQUAL_UINT32(0, lost);
+    TEST_ASSERT_EQUAL_UINT32(1, tcp.last());
+}
+
+void test_reset_accepts_a_restarted_server() {
+    CommandSequence udp(true);
+    TEST_ASSERT_TRUE(accept(udp, 500));
+    TEST_ASSERT_FALSE(accept(udp, 1));
+    udp.reset();
+    uint32_t lost = 0;
+    TEST_ASSERT_TRUE(udp.accept(1, lost));
+    TEST_ASSERT_EQUAL_UINT32(0, lost);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_udp_newest_wins);
+    RUN_TEST(test_udp_drops_duplicates_and_missing_seq);
+    RUN_TEST(test_udp_seq_wraps_around);
+    RUN_TEST(test_gaps_count_lost_commands);
+    RUN_TEST(test_tcp_accepts_everything_and_counts_gaps);
+    RUN_TEST(test_reset_accepts_a_restarted_server);
+    return UNITY_END();
+}
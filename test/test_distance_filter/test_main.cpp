@@ -0,0 +1,96 @@
+// DistanceFilter: conversión del eco a mm y filtro de Hampel sobre la ventana
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "DistanceFilter.h"
+
+namespace {
+
+    // µs de eco para una distancia en mm (inverso de toMillimeters)
+    uint32_t echoFor(uint32_t mm) {
+        return (mm * 65536u + 11140u) / 11141u;
+    }
+
+    void fill(DistanceFilter& filter, uint32_t mm) {
+        for (int i = 0; i < DISTANCE_FILTER_WINDOW; i++) {
+            filter.update(echoFor(mm));
+        }
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_echo_converts_to_millimeters() {
+    TEST_ASSERT_UINT32_WITHIN(1, 1000, DistanceFilter::toMillimeters(5882));
+    TEST_ASSERT_EQUAL_UINT16(500, DistanceFilter::toMillimeters(echoFor(500)));
+}
+
+void test_out_of_range_echo_is_no_echo() {
+    TEST_ASSERT_EQUAL_UINT16(DistanceFilter::NO_ECHO, DistanceFilter::toMillimeters(0));
+    TEST_ASSERT_EQUAL_UINT16(DistanceFilter::NO_ECHO, DistanceFilter::toMillimeters(100));
+    TEST_ASSERT_EQUAL_UINT16(DistanceFilter::NO_ECHO, DistanceFilter::toMillimeters(ECHO_TIMEOUT_US + 1));
+}
+
+void test_single_spike_is_replaced_by_the_median() {
+    DistanceFilter filter;
+    fill(filter, 1000);
+    TEST_ASSERT_UINT32_WITHIN(1, 1000, filter.update(echoFor(150)));
+    TEST_ASSERT_EQUAL_UINT32(1, filter.outliers());
+    TEST_ASSERT_UINT32_WITHIN(1, 1005, filter.update(echoFor(1005)));
+}
+
+void test_single_missing_echo_is_replaced_by_the_median() {
+    DistanceFilter filter;
+    fill(filter, 800);
+    TEST_ASSERT_UINT32_WITHIN(1, 800, filter.update(0));
+}
+
+void test_mostly_missing_echoes_report_no_echo() {
+    DistanceFilter filter;
+    fill(filter, 800);
+    uint16_t output = 1;
+    for (int i = 0; i < DISTANCE_FILTER_WINDOW / 2 + 1; i++) {
+        output = filter.update(0);
+    }
+    TEST_ASSERT_EQUAL_UINT16(0, output);
+}
+
+void test_real_step_passes_once_it_is_the_majority() {
+    DistanceFilter filter;
+    fill(filter, 1000);
+    // Sobre una ventana plana el escalón se retiene WINDOW / 2 lecturas
+    for (int i = 0; i < DISTANCE_FILTER_WINDOW / 2; i++) {
+        TEST_ASSERT_UINT32_WITHIN(1, 1000, filter.update(echoFor(500)));
+    }
+    TEST_ASSERT_UINT32_WITHIN(1, 500, filter.update(echoFor(500)));
+    TEST_ASSERT_EQUAL_UINT32(DISTANCE_FILTER_WINDOW / 2, filter.outliers());
+}
+
+void test_noise_within_the_spread_passes_through() {
+    DistanceFilter filter;
+    const uint32_t readings[] = {1000, 1040, 960, 1020, 980, 1035, 965};
+    for (uint32_t mm : readings) {
+        TEST_ASSERT_UINT32_WITHIN(1, mm, filter.update(echoFor(mm)));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, filter.outliers());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_echo_converts_to_millimeters);
+    RUN_TEST(test_out_of_range_echo_is_no_echo);
+    RUN_TEST(test_single_spike_is_replaced_by_the_median);
+    RUN_TEST(test_single_missing_echo_is_replaced_by_the_median);
+    RUN_TEST(test_mostly_missing_echoes_report_no_echo);
+    RUN_TEST(test_real_step_passes_once_it_is_the_majority);
+    RUN_TEST(test_noise_within_the_spread_passes_through);
+    return UNITY_END();
+}
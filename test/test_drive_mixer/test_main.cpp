@@ -0,0 +1,171 @@
+// DriveMixer: mezcla acelerador/dirección, modo tanque y zona muerta, más
+// un benchmark de la tabla contra calcular la mezcla en cada comando
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "DriveMixer.h"
+
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+    // La misma cuenta que la tabla, hecha en el momento
+    int8_t deadband(int value) {
+        if (value == 0) {
+            return 0;
+        }
+        int magnitude = MOTOR_MIN_DUTY + abs(value) * (100 - MOTOR_MIN_DUTY) / 100;
+        return value > 0 ? magnitude : -magnitude;
+    }
+
+    DriveMixer::Wheels mixDirect(int throttle, int steering) {
+        int left = throttle + steering;
+        int right = throttle - steering;
+        int peak = abs(left) > abs(right) ? abs(left) : abs(right);
+        if (peak > 100) {
+            left = left * 100 / peak;
+            right = right * 100 / peak;
+        }
+        return {deadband(left), deadband(right)};
+    }
+
+    bool turns(int8_t duty) {
+        return duty == 0 || abs(duty) >= MOTOR_MIN_DUTY;
+    }
+
+    volatile int sink;
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_basic_mixes() {
+    DriveMixer mixer;
+    DriveMixer::Wheels wheels = mixer.mix(0, 0);
+    TEST_ASSERT_EQUAL_INT8(0, wheels.left);
+    TEST_ASSERT_EQUAL_INT8(0, wheels.right);
+    wheels = mixer.mix(100, 0);
+    TEST_ASSERT_EQUAL_INT8(100, wheels.left);
+    TEST_ASSERT_EQUAL_INT8(100, wheels.right);
+    wheels = mixer.mix(-100, 0);
+    TEST_ASSERT_EQUAL_INT8(-100, wheels.left);
+    TEST_ASSERT_EQUAL_INT8(-100, wheels.right);
+    // Girar en el lugar hacia la derecha
+    wheels = mixer.mix(0, 100);
+    TEST_ASSERT_EQUAL_INT8(100, wheels.left);
+    TEST_ASSERT_EQUAL_INT8(-100, wheels.right);
+    // Acelerador y dirección al máximo: se reescala, la rueda de adentro queda quieta
+    wheels = mixer.mix(100, 100);
+    TEST_ASSERT_EQUAL_INT8(100, wheels.left);
+    TEST_ASSERT_EQUAL_INT8(0, wheels.right);
+}
+
+void test_table_matches_direct_mix_on_its_steps() {
+    DriveMixer mixer;
+    for (int t = -100; t <= 100; t += MIX_STEP) {
+        for (int s = -100; s <= 100; s += MIX_STEP) {
+            DriveMixer::Wheels table = mixer.mix(t, s);
+            DriveMixer::Wheels direct = mixDirect(t, s);
+            TEST_ASSERT_EQUAL_INT8(direct.left, table.left);
+            TEST_ASSERT_EQUAL_INT8(direct.right, table.right);
+        }
+    }
+}
+
+void test_no_wheel_is_left_inside_the_deadband() {
+    DriveMixer mixer;
+    for (int t = -100; t <= 100; t++) {
+        for (int s = -100; s <= 100; s++) {
+            DriveMixer::Wheels wheels = mixer.mix(t, s);
+            TEST_ASSERT_TRUE(turns(wheels.left));
+            TEST_ASSERT_TRUE(turns(wheels.right));
+        }
+        DriveMixer::Wheels wheels = mixer.tank(t, -t);
+        TEST_ASSERT_TRUE(turns(wheels.left));
+        TEST_ASSERT_TRUE(turns(wheels.right));
+    }
+}
+
+void test_reducing_the_request_keeps_the_wheels_turning() {
+    // Así reduce main.cpp la velocidad: se escala lo pedido y se vuelve a
+    // mezclar, en lugar de escalar el ciclo útil que ya pasó la zona muerta
+    DriveMixer mixer;
+    for (int throttle = MIX_STEP * 2; throttle <= 100; throttle += MIX_STEP) {
+        DriveMixer::Wheels full = mixer.mix(throttle, 0);
+        DriveMixer::Wheels half = mixer.mix(throttle * 50 / 100, 0);
+        TEST_ASSERT_GREATER_OR_EQUAL(MOTOR_MIN_DUTY, half.left);
+        TEST_ASSERT_LESS_THAN(full.left, half.left);
+    }
+}
+
+void test_tank_clamps_and_applies_the_deadband() {
+    DriveMixer mixer;
+    DriveMixer::Wheels wheels = mixer.tank(150, -150);
+    TEST_ASSERT_EQUAL_INT8(100, wheels.left);
+    TEST_ASSERT_EQUAL_INT8(-100, wheels.right);
+    wheels = mixer.tank(1, 0);
+    TEST_ASSERT_EQUAL_INT8(MOTOR_MIN_DUTY, wheels.left);
+    TEST_ASSERT_EQUAL_INT8(0, wheels.right);
+}
+
+void test_motion_of_wheels() {
+    TEST_ASSERT_EQUAL(MOTION_STOP, DriveMixer::motionOf({0, 0}));
+    TEST_ASSERT_EQUAL(MOTION_FORWARD, DriveMixer::motionOf({60, 40}));
+    TEST_ASSERT_EQUAL(MOTION_BACKWARD, DriveMixer::motionOf({-60, -40}));
+    TEST_ASSERT_EQUAL(MOTION_LEFT, DriveMixer::motionOf({-50, 50}));
+    TEST_ASSERT_EQUAL(MOTION_RIGHT, DriveMixer::motionOf({50, 0}));
+}
+
+void test_benchmark_table_against_direct_mix() {
+    DriveMixer mixer;
+    const int ROUNDS = 50;
+    int checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int t = -100; t <= 100; t++) {
+            for (int s = -100; s <= 100; s++) {
+                DriveMixer::Wheels wheels = mixer.mix(t, s);
+                checksum += wheels.left - wheels.right;
+            }
+        }
+    }
+    double tableNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    sink = checksum;
+    checksum = 0;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int t = -100; t <= 100; t++) {
+            for (int s = -100; s <= 100; s++) {
+                DriveMixer::Wheels wheels = mixDirect(t, s);
+                checksum += wheels.left - wheels.right;
+            }
+        }
+    }
+    double directNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    sink = checksum;
+    double calls = ROUNDS * 201.0 * 201.0;
+    char line[120];
+    snprintf(line, sizeof(line), "mezcla: tabla %.1f ns/comando, directa %.1f ns/comando",
+        tableNs / calls, directNs / calls);
+    TEST_MESSAGE(line);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_basic_mixes);
+    RUN_TEST(test_table_matches_direct_mix_on_its_steps);
+    RUN_TEST(test_no_wheel_is_left_inside_the_deadband);
+    RUN_TEST(test_reducing_the_request_keeps_the_wheels_turning);
+    RUN_TEST(test_tank_clamps_and_applies_the_deadband);
+    RUN_TEST(test_motion_of_wheels);
+    RUN_TEST(test_benchmark_table_against_direct_mix);
+    return UNITY_END();
+}
@@ -0,0 +1,80 @@
+// LatencyStats: percentiles del histograma y los dos contadores de comandos
+// que no se aplicaron (perdidos y reemplazados), que tools/bench_server.py lee
+// del reporte por separado
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "LatencyStats.h"
+
+#include <string>
+
+namespace {
+
+    class Capture : public Print {
+        public:
+            size_t write(uint8_t c) override {
+                text += (char)c;
+                return 1;
+            }
+
+            std::string text;
+    };
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_percentiles_stay_within_a_bucket() {
+    LatencyStats stats;
+    for (uint32_t us = 1; us <= 1000; us++) {
+        stats.record(us);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1000, stats.count());
+    TEST_ASSERT_EQUAL_UINT32(1000, stats.max());
+    // Error de la cubeta menor al 12.5%
+    TEST_ASSERT_UINT32_WITHIN(500 / 8, 500, stats.percentile(50));
+    TEST_ASSERT_UINT32_WITHIN(990 / 8, 990, stats.percentile(99));
+    TEST_ASSERT_EQUAL_UINT32(1000, stats.percentile(100));
+}
+
+void test_superseded_commands_are_not_counted_as_lost() {
+    LatencyStats stats;
+    // Tres comandos en la cola en una vuelta: se aplica el último
+    stats.superseded(2);
+    stats.record(300);
+    // Uno que el servidor mandó y nunca llegó
+    stats.dropped(1);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.count());
+    TEST_ASSERT_EQUAL_UINT32(1, stats.droppedCount());
+    TEST_ASSERT_EQUAL_UINT32(2, stats.supersededCount());
+}
+
+void test_report_lists_both_counters_and_reset_clears_them() {
+    LatencyStats stats;
+    stats.record(300);
+    stats.dropped(4);
+    stats.superseded(7);
+    Capture out;
+    stats.report(out, "Latencia comando->GPIO");
+    TEST_ASSERT_TRUE(out.text.find("n=1 ") != std::string::npos);
+    TEST_ASSERT_TRUE(out.text.find("perdidos=4 reemplazados=7") != std::string::npos);
+    stats.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, stats.count());
+    TEST_ASSERT_EQUAL_UINT32(0, stats.droppedCount());
+    TEST_ASSERT_EQUAL_UINT32(0, stats.supersededCount());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_percentiles_stay_within_a_bucket);
+    RUN_TEST(test_superseded_commands_are_not_counted_as_lost);
+    RUN_TEST(test_report_lists_both_counters_and_reset_clears_them);
+    return UNITY_END();
+}
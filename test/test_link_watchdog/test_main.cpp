@@ -0,0 +1,210 @@
+// Tiempo hasta parar los motores cuando se corta el enlace: HardwareController,
+// MotorTicker en su esp_timer y LinkWatchdog sobre el reloj virtual del shim,
+// mirando los pines reales de los motores
+
+#include <unity.h>
+
+#include <NativeShim.h>
+
+#include "AllocTracker.h"
+#include "HardwareController.h"
+#include "LinkWatchdog.h"
+#include "MotorTicker.h"
+
+namespace {
+
+    const uint8_t LEFT_FORWARD = 26;
+    const uint8_t RIGHT_FORWARD = 25;
+    const uint8_t LEFT_BACKWARD = 27;
+    const uint8_t RIGHT_BACKWARD = 33;
+    const uint8_t LIGHT = 2;
+
+    // Un solo ticker para todo el programa: su esp_timer no se borra. Cada
+    // test usa un watchdog nuevo, desarmado; los anteriores no se liberan
+    // porque el tick puede estar leyéndolos
+    HardwareController hardware(LEFT_FORWARD, RIGHT_FORWARD, LEFT_BACKWARD, RIGHT_BACKWARD, LIGHT);
+    MotorTicker ticker(hardware);
+    LinkWatchdog watchdogs[16];
+    LinkWatchdog* watchdog = watchdogs;
+
+    bool motorsStopped() {
+        return native::pin_state(LEFT_FORWARD) == LOW
+            && native::pin_state(RIGHT_FORWARD) == LOW
+            && native::pin_state(LEFT_BACKWARD) == LOW
+            && native::pin_state(RIGHT_BACKWARD) == LOW;
+    }
+
+    bool drivingForward() {
+        return native::pin_state(LEFT_FORWARD) == HIGH
+            && native::pin_state(RIGHT_FORWARD) == HIGH
+            && native::pin_state(LEFT_BACKWARD) == LOW
+            && native::pin_state(RIGHT_BACKWARD) == LOW;
+    }
+
+    // Avanza el reloj en pasos de 100 us hasta que los motores paran o pasa
+    // limitUs; devuelve cuánto tardaron. En PWM los pines no pasan por
+    // digitalWrite hasta que stop() los devuelve al modo digital
+    uint64_t timeToStop(uint64_t limitUs) {
+        uint64_t start = native::now_us();
+        while (!(motorsStopped() && hardware.motion() == MOTION_STOP) && native::now_us() - start < limitUs) {
+            native::advance_us(100);
+        }
+        return native::now_us() - start;
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+    watchdog++;
+    ticker.watch(*watchdog);
+    ticker.set(MOTION_STOP);
+    native::advance_us(2 * MOTOR_TICK_US);
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_stop_drives_all_motor_pins_low() {
+    hardware.Forward();
+    TEST_ASSERT_TRUE(drivingForward());
+    hardware.stop();
+    TEST_ASSERT_TRUE(motorsStopped());
+    hardware.turnRight();
+    hardware.apply(MOTION_STOP);
+    TEST_ASSERT_TRUE(motorsStopped());
+}
+
+void test_commands_arm_the_watchdog_with_the_command_timeout() {
+    TEST_ASSERT_FALSE(watchdog->isArmed());
+    watchdog->feed(micros());
+    TEST_ASSERT_EQUAL_UINT32(LINK_COMMAND_TIMEOUT_MS, watchdog->timeoutMs());
+    ticker.set(MOTION_FORWARD);
+    // Un servidor sin latidos que repite el comando más lento que LINK_TIMEOUT_MS
+    for (int i = 0; i < 10; i++) {
+        native::advance_us(2 * LINK_TIMEOUT_MS * 1000UL);
+        watchdog->feed(micros());
+        TEST_ASSERT_TRUE(drivingForward());
+    }
+    uint64_t elapsed = timeToStop(10 * LINK_COMMAND_TIMEOUT_MS * 1000UL);
+    TEST_ASSERT_TRUE(watchdog->tripped());
+    TEST_ASSERT_GREATER_THAN(LINK_COMMAND_TIMEOUT_MS * 1000UL, elapsed + 100);
+    TEST_ASSERT_LESS_OR_EQUAL(LINK_COMMAND_TIMEOUT_MS * 1000UL + MOTOR_TICK_US + 100, elapsed);
+}
+
+void test_heartbeat_shortens_the_timeout() {
+    watchdog->feed(micros());
+    watchdog->heartbeat(micros());
+    TEST_ASSERT_EQUAL_UINT32(LINK_TIMEOUT_MS, watchdog->timeoutMs());
+    // Un comando después no lo vuelve a alargar
+    watchdog->feed(micros());
+    TEST_ASSERT_EQUAL_UINT32(LINK_TIMEOUT_MS, watchdog->timeoutMs());
+}
+
+void test_server_timeout_wins_and_zero_disarms() {
+    watchdog->setTimeout(200, micros());
+    watchdog->heartbeat(micros());
+    watchdog->feed(micros());
+    TEST_ASSERT_EQUAL_UINT32(200, watchdog->timeoutMs());
+    watchdog->setTimeout(0, micros());
+    watchdog->feed(micros());
+    TEST_ASSERT_FALSE(watchdog->isArmed());
+    ticker.set(MOTION_FORWARD);
+    native::advance_us(10 * LINK_COMMAND_TIMEOUT_MS * 1000UL);
+    TEST_ASSERT_FALSE(watchdog->tripped());
+    TEST_ASSERT_TRUE(drivingForward());
+}
+
+void test_reconnect_to_a_server_without_heartbeats() {
+    // El servidor anterior mandaba latidos
+    watchdog->heartbeat(micros());
+    TEST_ASSERT_EQUAL_UINT32(LINK_TIMEOUT_MS, watchdog->timeoutMs());
+    // El nuevo solo manda comandos, cada 2 x LINK_TIMEOUT_MS: no se corta a pedazos
+    watchdog->disarm();
+    TEST_ASSERT_FALSE(watchdog->isArmed());
+    watchdog->feed(micros());
+    ticker.set(MOTION_FORWARD);
+    for (int i = 0; i < 10; i++) {
+        native::advance_us(2 * LINK_TIMEOUT_MS * 1000UL);
+        watchdog->feed(micros());
+        TEST_ASSERT_TRUE(drivingForward());
+    }
+    TEST_ASSERT_FALSE(watchdog->tripped());
+    TEST_ASSERT_EQUAL_UINT32(LINK_COMMAND_TIMEOUT_MS, watchdog->timeoutMs());
+}
+
+void test_heartbeats_keep_the_motors_running() {
+    watchdog->heartbeat(micros());
+    ticker.set(MOTION_FORWARD);
+    for (int i = 0; i < 20; i++) {
+        native::advance_us(30000);
+        watchdog->heartbeat(micros());
+        TEST_ASSERT_TRUE(drivingForward());
+    }
+    TEST_ASSERT_FALSE(watchdog->tripped());
+}
+
+void test_motors_stop_within_the_timeout_after_the_last_heartbeat() {
+    watchdog->heartbeat(micros());
+    ticker.set(MOTION_FORWARD);
+    native::advance_us(2 * MOTOR_TICK_US);
+    TEST_ASSERT_TRUE(drivingForward());
+    // Último latido; después solo comandos que ya no llegan
+    watchdog->heartbeat(micros());
+    uint64_t elapsed = timeToStop(10 * LINK_TIMEOUT_MS * 1000UL);
+    TEST_ASSERT_TRUE(motorsStopped());
+    TEST_ASSERT_TRUE(watchdog->tripped());
+    TEST_ASSERT_GREATER_THAN(LINK_TIMEOUT_MS * 1000UL, elapsed + 100);
+    TEST_ASSERT_LESS_OR_EQUAL(LINK_TIMEOUT_MS * 1000UL + MOTOR_TICK_US + 100, elapsed);
+    char line[80];
+    snprintf(line, sizeof(line), "tiempo hasta parar: %u us", (unsigned)elapsed);
+    TEST_MESSAGE(line);
+}
+
+void test_pwm_drive_also_stops() {
+    watchdog->heartbeat(micros());
+    ticker.drive(80, -40);
+    native::advance_us(2 * MOTOR_TICK_US);
+    TEST_ASSERT_EQUAL(MOTION_COUNT, hardware.motion());
+    watchdog->heartbeat(micros());
+    uint64_t elapsed = timeToStop(10 * LINK_TIMEOUT_MS * 1000UL);
+    TEST_ASSERT_EQUAL(MOTION_STOP, hardware.motion());
+    TEST_ASSERT_TRUE(motorsStopped());
+    TEST_ASSERT_LESS_OR_EQUAL(LINK_TIMEOUT_MS * 1000UL + MOTOR_TICK_US + 100, elapsed);
+}
+
+void test_tripped_watchdog_holds_stop_until_rearmed() {
+    watchdog->heartbeat(micros());
+    ticker.set(MOTION_FORWARD);
+    native::advance_us(2 * MOTOR_TICK_US);
+    TEST_ASSERT_TRUE(drivingForward());
+    timeToStop(10 * LINK_TIMEOUT_MS * 1000UL);
+    TEST_ASSERT_TRUE(watchdog->tripped());
+    // Vuelve el enlace pero sin rearmar: sigue parado
+    watchdog->heartbeat(micros());
+    native::advance_us(5 * MOTOR_TICK_US);
+    TEST_ASSERT_TRUE(motorsStopped());
+    // La tarea de control publica STOP y rearma; luego un comando nuevo
+    ticker.set(MOTION_STOP);
+    watchdog->rearm();
+    ticker.set(MOTION_FORWARD);
+    native::advance_us(2 * MOTOR_TICK_US);
+    TEST_ASSERT_TRUE(drivingForward());
+}
+
+int main() {
+    hardware.begin();
+    ticker.begin();
+    UNITY_BEGIN();
+    RUN_TEST(test_stop_drives_all_motor_pins_low);
+    RUN_TEST(test_commands_arm_the_watchdog_with_the_command_timeout);
+    RUN_TEST(test_heartbeat_shortens_the_timeout);
+    RUN_TEST(test_server_timeout_wins_and_zero_disarms);
+    RUN_TEST(test_reconnect_to_a_server_without_heartbeats);
+    RUN_TEST(test_heartbeats_keep_the_motors_running);
+    RUN_TEST(test_motors_stop_within_the_timeout_after_the_last_heartbeat);
+    RUN_TEST(test_pwm_drive_also_stops);
+    RUN_TEST(test_tripped_watchdog_holds_stop_until_rearmed);
+    return UNITY_END();
+}
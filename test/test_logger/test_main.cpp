@@ -0,0 +1,216 @@
+// Logger: orden de los mensajes, el buffer lleno (se descartan mensajes
+// enteros y se informa cuántos bytes), el límite de frecuencia por punto, y
+// cuánto dura una vuelta de un loop() con muchos mensajes por vuelta: sin
+// logs, con Logger (la tarea lo vacía a una UART lenta) y escribiendo directo
+// a esa UART como se hacía antes de Logger.
+
+#include <unity.h>
+
+#include <NativeShim.h>
+
+#include "AllocTracker.h"
+#include "Logger.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+namespace {
+
+    class Capture : public Print {
+        public:
+            size_t write(uint8_t c) override {
+                text += (char)c;
+                return 1;
+            }
+
+            std::string text;
+    };
+
+    // Una UART a 115200 baudios: unos 87 us por byte, en tiempo real
+    class SlowUart : public Print {
+        public:
+            size_t write(uint8_t c) override {
+                return write(&c, 1);
+            }
+
+            size_t write(const uint8_t* buffer, size_t size) override {
+                std::this_thread::sleep_for(std::chrono::microseconds(87 * size));
+                for (size_t i = 0; i < size; i++) {
+                    if (buffer[i] == '\n') {
+                        lines++;
+                    }
+                }
+                return size;
+            }
+
+            std::atomic<int> lines{0};
+    };
+
+    int count(const std::string& text, const char* what) {
+        int found = 0;
+        for (size_t at = text.find(what); at != std::string::npos; at = text.find(what, at + 1)) {
+            found++;
+        }
+        return found;
+    }
+
+    enum LoopLogging { LOGGING_OFF, LOGGING_LOGGER, LOGGING_DIRECT };
+
+    const int LOOPS = 100;
+    const int MESSAGES_PER_LOOP = 2;
+
+    struct LoopTimes {
+        double meanUs;
+        double maxUs;
+        int loggedLines;
+    };
+
+    // Lo que hace una vuelta además de registrar, para que haya con qué comparar
+    volatile uint32_t work;
+
+    LoopTimes runLoop(LoopLogging logging, Print& uart) {
+        LoopTimes times = {0, 0, 0};
+        for (int i = 0; i < LOOPS; i++) {
+            auto start = std::chrono::steady_clock::now();
+            for (uint32_t j = 0; j < 2000; j++) {
+                work = work * 1664525u + 1013904223u;
+            }
+            for (int m = 0; m < MESSAGES_PER_LOOP; m++) {
+                char line[Logger::LINE_SIZE];
+                int length = snprintf(line, sizeof(line), "vuelta %d: distancia=%d cm, motores=%d/%d\n",
+                    i, (int)(work % 400), m, -m);
+                if (logging == LOGGING_LOGGER) {
+                    LOG_INFO("vuelta %d: distancia=%d cm, motores=%d/%d", i, (int)(work % 400), m, -m);
+                    times.loggedLines++;
+                } else if (logging == LOGGING_DIRECT) {
+                    uart.write((const uint8_t*)line, length);
+                    times.loggedLines++;
+                }
+            }
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            times.meanUs += us / LOOPS;
+            if (us > times.maxUs) {
+                times.maxUs = us;
+            }
+            // El periodo de la tarea de control; aquí corre la del log
+            delay(10);
+        }
+        return times;
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_messages_come_out_in_order() {
+    Logger logger;
+    Capture out;
+    logger.setOutput(out);
+    LogSite site(0);
+    logger.log(site, LOG_LEVEL_INFO, "primero %d", 1);
+    logger.log(site, LOG_LEVEL_WARN, "segundo");
+    logger.printf("reporte %s\n", "crudo");
+    TEST_ASSERT_TRUE(logger.drain() > 0);
+    size_t first = out.text.find("I primero 1\n");
+    size_t second = out.text.find("W segundo\n");
+    size_t third = out.text.find("reporte crudo\n");
+    TEST_ASSERT_TRUE(first != std::string::npos);
+    TEST_ASSERT_TRUE(second > first && second != std::string::npos);
+    TEST_ASSERT_TRUE(third > second && third != std::string::npos);
+    TEST_ASSERT_EQUAL(0, logger.drain());
+}
+
+void test_full_ring_drops_whole_messages_and_reports_them() {
+    Logger logger;
+    Capture out;
+    logger.setOutput(out);
+    // Mensajes de 100 bytes hasta pasar la capacidad
+    char message[101];
+    memset(message, 'x', 99);
+    message[99] = '\n';
+    message[100] = 0;
+    size_t accepted = 0;
+    size_t dropped = 0;
+    for (int i = 0; i < 30; i++) {
+        if (logger.print(message) == 100) {
+            accepted++;
+        } else {
+            dropped++;
+        }
+    }
+    TEST_ASSERT_EQUAL((Logger::BUFFER_SIZE - 1) / 100, accepted);
+    logger.drain();
+    // Los que entraron salen enteros; de los otros solo queda la cuenta
+    TEST_ASSERT_EQUAL((int)accepted, count(out.text, message));
+    char report[48];
+    snprintf(report, sizeof(report), "[log] %u bytes perdidos\n", (unsigned)(dropped * 100));
+    TEST_ASSERT_EQUAL(1, count(out.text, report));
+    TEST_ASSERT_EQUAL(accepted * 100 + strlen(report), out.text.size());
+    // Con lugar otra vez, se vuelve a aceptar y la cuenta no se repite
+    out.text.clear();
+    TEST_ASSERT_EQUAL(100, logger.print(message));
+    logger.drain();
+    TEST_ASSERT_EQUAL_STRING(message, out.text.c_str());
+}
+
+void test_rate_limited_site_reports_what_it_suppressed() {
+    Logger logger;
+    Capture out;
+    logger.setOutput(out);
+    LogSite site(1000);
+    for (int i = 0; i < 5; i++) {
+        logger.log(site, LOG_LEVEL_WARN, "muro cerca");
+    }
+    native::advance_us(1000 * 1000);
+    logger.log(site, LOG_LEVEL_WARN, "muro cerca");
+    logger.drain();
+    TEST_ASSERT_EQUAL(2, count(out.text, "muro cerca"));
+    TEST_ASSERT_EQUAL(1, count(out.text, "muro cerca (+4 suprimidos)\n"));
+}
+
+void test_loop_time_with_heavy_logging() {
+    // La tarea del log y su UART viven lo que el programa: la tarea no se puede parar
+    static SlowUart uart;
+    static SlowUart direct;
+    native::claim_clock();
+    Logger::instance().begin(uart);
+
+    LoopTimes off = runLoop(LOGGING_OFF, direct);
+    LoopTimes logger = runLoop(LOGGING_LOGGER, direct);
+    // Tiempo para que la tarea vacíe lo último
+    delay(100);
+    LoopTimes serial = runLoop(LOGGING_DIRECT, direct);
+
+    char line[200];
+    snprintf(line, sizeof(line), "vuelta sin logs: media %.1f us, peor %.1f us; con Logger: %.1f / %.1f us; "
+        "directo a la UART: %.1f / %.1f us (%d mensajes por vuelta)",
+        off.meanUs, off.maxUs, logger.meanUs, logger.maxUs, serial.meanUs, serial.maxUs, MESSAGES_PER_LOOP);
+    TEST_MESSAGE(line);
+    // Todo lo registrado llegó a la UART, sin descartes, por la tarea del log
+    TEST_ASSERT_EQUAL(LOOPS * MESSAGES_PER_LOOP, logger.loggedLines);
+    TEST_ASSERT_EQUAL(logger.loggedLines, uart.lines.load());
+    TEST_ASSERT_EQUAL(serial.loggedLines, direct.lines.load());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_messages_come_out_in_order);
+    RUN_TEST(test_full_ring_drops_whole_messages_and_reports_them);
+    RUN_TEST(test_rate_limited_site_reports_what_it_suppressed);
+    RUN_TEST(test_loop_time_with_heavy_logging);
+    int failures = UNITY_END();
+    // La tarea del log no termina nunca; salir sin destruir el reloj virtual
+    // en el que espera, como native_main
+    fflush(stdout);
+    std::_Exit(failures);
+}
@@ -0,0 +1,197 @@
+// LzCodec: ida y vuelta con el propio codec y contra el decodificador del
+// servidor (tools/telemetry_decode.py), con tramas armadas igual que
+// WebSocketController::sendFrame
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "LzCodec.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+    typedef std::vector<uint8_t> Bytes;
+
+    // Telemetría parecida a la real: perfiles del barrido que cambian poco
+    Bytes scanFrame(int i) {
+        if (i == 0) {
+            // Sin historia solo conviene comprimir una trama repetitiva, como
+            // el barrido de una pared lejana
+            const char flat[] = "{\"type\":\"scan\",\"start\":30,\"step\":10,\"cm\":[300,300,300,300,300,300,300,300,300,300,300,300,300]}";
+            return Bytes(flat, flat + sizeof(flat) - 1);
+        }
+        char text[256];
+        int length = snprintf(text, sizeof(text),
+            "{\"type\":\"scan\",\"start\":30,\"step\":10,\"cm\":[%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d]}",
+            120 + i % 7, 118, 117 + i % 3, 116, 150, 151, 152 + i % 5, 90, 88, 87, 86 + i % 2, 300, 301);
+        return Bytes(text, text + length);
+    }
+
+    Bytes randomFrame(size_t length, uint32_t& seed) {
+        Bytes frame(length);
+        for (uint8_t& byte : frame) {
+            seed = seed * 1103515245u + 12345u;
+            byte = seed >> 24;
+        }
+        // Que no empiece con 'Z' o el decodificador la tomaría por comprimida
+        frame[0] = 'M';
+        return frame;
+    }
+
+    Bytes compressed(LzCodec& codec, const Bytes& frame) {
+        Bytes out(LZ_MAX_INPUT + LZ_MAX_INPUT / 8 + 1);
+        size_t length = codec.compress(frame.data(), frame.size(), out.data(), out.size());
+        out.resize(length);
+        return out;
+    }
+
+    // Comprime y descomprime con dos codecs que llevan la misma historia
+    bool roundTrip(LzCodec& sender, LzCodec& receiver, const Bytes& frame) {
+        Bytes packed = compressed(sender, frame);
+        if (packed.empty()) {
+            return false;
+        }
+        Bytes out(LZ_MAX_INPUT);
+        out.resize(receiver.decompress(packed.data(), packed.size(), out.data(), out.size()));
+        sender.append(frame.data(), frame.size());
+        receiver.append(out.data(), out.size());
+        return out == frame;
+    }
+
+    std::string projectDir() {
+        std::string file = __FILE__;
+        return file.substr(0, file.rfind("test/test_lz_codec/"));
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_round_trip_with_shared_history() {
+    LzCodec sender;
+    LzCodec receiver;
+    for (int i = 0; i < 200; i++) {
+        TEST_ASSERT_TRUE(roundTrip(sender, receiver, scanFrame(i)));
+    }
+}
+
+void test_history_makes_repeated_frames_small() {
+    LzCodec codec;
+    Bytes first = scanFrame(1);
+    size_t alone = compressed(codec, first).size();
+    codec.append(first.data(), first.size());
+    size_t withHistory = compressed(codec, scanFrame(2)).size();
+    TEST_ASSERT_LESS_THAN(alone / 3, withHistory);
+}
+
+void test_overlapping_match_and_window_wraparound() {
+    LzCodec sender;
+    LzCodec receiver;
+    TEST_ASSERT_TRUE(roundTrip(sender, receiver, Bytes(LZ_MAX_INPUT, 'a')));
+    // Más de LZ_WINDOW bytes de historia: lo viejo se descarta en los dos lados
+    uint32_t seed = 1;
+    for (int i = 0; i < 8; i++) {
+        Bytes noise = randomFrame(300, seed);
+        sender.append(noise.data(), noise.size());
+        receiver.append(noise.data(), noise.size());
+        TEST_ASSERT_TRUE(roundTrip(sender, receiver, scanFrame(i)));
+    }
+}
+
+void test_incompressible_frame_does_not_fit_a_smaller_buffer() {
+    LzCodec codec;
+    uint32_t seed = 7;
+    Bytes frame = randomFrame(200, seed);
+    uint8_t out[LZ_MAX_INPUT];
+    TEST_ASSERT_EQUAL(0, codec.compress(frame.data(), frame.size(), out, frame.size() - 8));
+    TEST_ASSERT_EQUAL(0, codec.compress(frame.data(), LZ_MAX_INPUT + 1, out, sizeof(out)));
+}
+
+void test_corrupt_input_is_rejected() {
+    LzCodec codec;
+    uint8_t out[LZ_MAX_INPUT];
+    // Coincidencia que apunta antes del comienzo
+    const uint8_t before[] = {0x01, 0xC0, 0x00};
+    TEST_ASSERT_EQUAL(0, codec.decompress(before, sizeof(before), out, sizeof(out)));
+    // Coincidencia cortada a la mitad
+    const uint8_t truncated[] = {0x02, 'a', 0x00};
+    TEST_ASSERT_EQUAL(0, codec.decompress(truncated, sizeof(truncated), out, sizeof(out)));
+}
+
+void test_server_decoder_reads_the_same_stream() {
+    if (system("python3 -c '' 2>/dev/null") != 0) {
+        TEST_IGNORE_MESSAGE("sin python3");
+    }
+    char dir[] = "/tmp/lz_codec_XXXXXX";
+    TEST_ASSERT_NOT_NULL(mkdtemp(dir));
+
+    // Igual que sendFrame: la historia empieza con la primera trama
+    // comprimida (marcada en minúscula) y desde ahí entra cada trama
+    LzCodec codec;
+    bool historyReset = true;
+    uint32_t seed = 3;
+    Bytes expected;
+    std::string files;
+    for (int i = 0; i < 40; i++) {
+        Bytes frame = i % 10 == 3 ? randomFrame(64, seed) : scanFrame(i);
+        Bytes packed = compressed(codec, frame);
+        Bytes sent;
+        if (!packed.empty() && packed.size() + 4 + 8 <= frame.size()) {
+            sent = {'Z', (uint8_t)(historyReset ? 't' : 'T'), (uint8_t)(frame.size() & 0xFF), (uint8_t)(frame.size() >> 8)};
+            sent.insert(sent.end(), packed.begin(), packed.end());
+            codec.append(frame.data(), frame.size());
+            historyReset = false;
+        } else {
+            sent = frame;
+            if (!historyReset) {
+                codec.append(frame.data(), frame.size());
+            }
+        }
+        expected.insert(expected.end(), frame.begin(), frame.end());
+        std::string path = std::string(dir) + "/" + std::to_string(1000 + i);
+        FILE* f = fopen(path.c_str(), "wb");
+        TEST_ASSERT_NOT_NULL(f);
+        fwrite(sent.data(), 1, sent.size(), f);
+        fclose(f);
+        files += " " + path;
+    }
+    TEST_ASSERT_FALSE(historyReset);
+
+    std::string output = std::string(dir) + "/decoded";
+    std::string command = "python3 " + projectDir() + "tools/telemetry_decode.py" + files + " > " + output;
+    TEST_ASSERT_EQUAL(0, system(command.c_str()));
+    FILE* f = fopen(output.c_str(), "rb");
+    TEST_ASSERT_NOT_NULL(f);
+    Bytes decoded;
+    int c;
+    while ((c = fgetc(f)) != EOF) {
+        decoded.push_back(c);
+    }
+    fclose(f);
+    std::string cleanup = std::string("rm -rf ") + dir;
+    TEST_ASSERT_EQUAL(0, system(cleanup.c_str()));
+    TEST_ASSERT_EQUAL(expected.size(), decoded.size());
+    TEST_ASSERT_TRUE(expected == decoded);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_with_shared_history);
+    RUN_TEST(test_history_makes_repeated_frames_small);
+    RUN_TEST(test_overlapping_match_and_window_wraparound);
+    RUN_TEST(test_incompressible_frame_does_not_fit_a_smaller_buffer);
+    RUN_TEST(test_corrupt_input_is_rejected);
+    RUN_TEST(test_server_decoder_reads_the_same_stream);
+    return UNITY_END();
+}
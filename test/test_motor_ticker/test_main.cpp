@@ -0,0 +1,121 @@
+// MotorTicker: jitter entre ticks sobre el reloj virtual del shim. Con el
+// esp_timer simulado cada tick llega en su plazo; manejando tick() con un
+// reloj propio se inyectan ticks atrasados (la tarea de esp_timer desplazada)
+// y el reporte tiene que mostrarlos como jitter, con su propia etiqueta.
+
+#include <unity.h>
+
+#include <NativeShim.h>
+
+#include "AllocTracker.h"
+#include "HardwareController.h"
+#include "MotorTicker.h"
+
+#include <cstdio>
+#include <string>
+
+namespace {
+
+    HardwareController hardware(26, 25, 27, 33, 2);
+
+    class Capture : public Print {
+        public:
+            size_t write(uint8_t c) override {
+                text += (char)c;
+                return 1;
+            }
+
+            std::string text;
+    };
+
+    struct Jitter {
+        unsigned period;
+        unsigned ticks;
+        unsigned p50;
+        unsigned p99;
+        unsigned max;
+    };
+
+    // Lee lo que imprime report(); ticks = ~0u si el formato no coincide
+    Jitter reportOf(MotorTicker& ticker, std::string* text = nullptr) {
+        Capture out;
+        ticker.report(out, "Jitter tick motores");
+        Jitter jitter = {0, ~0u, 0, 0, 0};
+        if (sscanf(out.text.c_str(), "Jitter tick motores: periodo=%uus ticks=%u jitter p50=%uus p99=%uus max=%uus",
+                &jitter.period, &jitter.ticks, &jitter.p50, &jitter.p99, &jitter.max) != 5) {
+            jitter.ticks = ~0u;
+        }
+        if (text) {
+            *text = out.text;
+        }
+        return jitter;
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_esp_timer_ticks_have_no_jitter_on_the_virtual_clock() {
+    // Su esp_timer no se borra: vive lo que el programa
+    static MotorTicker ticker(hardware);
+    native::claim_clock();
+    ticker.begin();
+    const uint32_t TICKS = 1000;
+    native::advance_us((uint64_t)TICKS * MOTOR_TICK_US);
+    Jitter jitter = reportOf(ticker);
+    // El primer tick no tiene anterior con que comparar
+    TEST_ASSERT_EQUAL_UINT32(MOTOR_TICK_US, jitter.period);
+    TEST_ASSERT_EQUAL_UINT32(TICKS - 1, jitter.ticks);
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.max);
+
+    // Lo publicado llega a los pines en el tick siguiente
+    ticker.set(MOTION_FORWARD);
+    native::advance_us(MOTOR_TICK_US);
+    TEST_ASSERT_EQUAL(MOTION_FORWARD, ticker.applied().motion);
+    ticker.set(MOTION_STOP);
+    native::advance_us(MOTOR_TICK_US);
+    TEST_ASSERT_EQUAL(MOTION_STOP, ticker.applied().motion);
+}
+
+void test_late_ticks_show_up_as_jitter() {
+    MotorTicker ticker(hardware);
+    const int TICKS = 1000;
+    const int64_t LATE_US = 300;
+    const int64_t STALL_US = 2500;
+    // Uno de cada diez ticks llega LATE_US tarde: su intervalo y el del
+    // siguiente se desvían LATE_US. A mitad de camino el timer se traba
+    // STALL_US y sigue con esa fase
+    for (int k = 1; k <= TICKS; k++) {
+        int64_t delay = k % 10 == 5 ? LATE_US : 0;
+        int64_t phase = k >= TICKS / 2 ? STALL_US : 0;
+        ticker.tick((int64_t)k * MOTOR_TICK_US + phase + delay);
+    }
+    std::string text;
+    Jitter jitter = reportOf(ticker, &text);
+    TEST_MESSAGE(text.substr(0, text.size() - 1).c_str());
+    TEST_ASSERT_EQUAL_UINT32(TICKS - 1, jitter.ticks);
+    // El 80% de los intervalos es exacto, el 20% se desvía LATE_US (dentro
+    // del error de la cubeta)
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.p50);
+    TEST_ASSERT_UINT32_WITHIN(LATE_US / 8, LATE_US, jitter.p99);
+    TEST_ASSERT_EQUAL_UINT32(STALL_US, jitter.max);
+    // Ni perdidos ni reemplazados: eso es de los comandos
+    TEST_ASSERT_TRUE(text.find("perdidos") == std::string::npos);
+    TEST_ASSERT_TRUE(text.find("reemplazados") == std::string::npos);
+
+    // El reporte reinicia el histograma
+    TEST_ASSERT_EQUAL_UINT32(0, reportOf(ticker).ticks);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_esp_timer_ticks_have_no_jitter_on_the_virtual_clock);
+    RUN_TEST(test_late_ticks_show_up_as_jitter);
+    return UNITY_END();
+}
@@ -0,0 +1,160 @@
+// OccupancyGrid: trazado de lecturas, baldosas que se reutilizan al moverse,
+// exportación de las celdas que cambiaron, la memoria que ocupa y cuánto
+// cuesta trazar una lectura
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "OccupancyGrid.h"
+
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+    const int32_t TILE_CM = OCC_TILE_CELLS * OCC_CELL_CM;
+
+    // Pares (celda, valor) que trae una exportación
+    size_t exportedCells(const uint8_t* buffer, size_t length) {
+        size_t cells = 0;
+        size_t pos = 2;
+        while (pos + 5 <= length) {
+            uint8_t n = buffer[pos + 4];
+            cells += n;
+            pos += 5 + 2 * n;
+        }
+        return cells;
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_hit_marks_the_end_occupied_and_the_path_free() {
+    OccupancyGrid grid;
+    grid.addRay(0, 100);
+    TEST_ASSERT_EQUAL_INT8(OCC_HIT, grid.at(105, 5));
+    TEST_ASSERT_EQUAL_INT8(OCC_MISS, grid.at(55, 5));
+    TEST_ASSERT_EQUAL_INT8(OCC_MISS, grid.at(5, 5));
+    TEST_ASSERT_EQUAL_INT8(0, grid.at(-55, 5));
+    TEST_ASSERT_EQUAL_UINT32(1, grid.rayCount());
+}
+
+void test_bearing_and_heading_rotate_the_ray() {
+    OccupancyGrid grid;
+    grid.addRay(90, 100);
+    TEST_ASSERT_EQUAL_INT8(OCC_HIT, grid.at(5, 105));
+    grid.setPose(0, 0, 180);
+    grid.addRay(0, 100);
+    TEST_ASSERT_EQUAL_INT8(OCC_HIT, grid.at(-95, 5));
+}
+
+void test_no_echo_only_clears_up_to_the_free_range() {
+    OccupancyGrid grid;
+    grid.addRay(0, 0);
+    TEST_ASSERT_EQUAL_INT8(OCC_MISS, grid.at(OCC_FREE_RANGE_CM + 5, 5));
+    TEST_ASSERT_EQUAL_INT8(0, grid.at(OCC_FREE_RANGE_CM + 15, 5));
+}
+
+void test_repeated_hits_saturate_at_the_limit() {
+    OccupancyGrid grid;
+    for (int i = 0; i < 50; i++) {
+        grid.addRay(0, 100);
+    }
+    TEST_ASSERT_EQUAL_INT8(OCC_LIMIT, grid.at(105, 5));
+    TEST_ASSERT_EQUAL_INT8(-OCC_LIMIT, grid.at(55, 5));
+}
+
+void test_tile_left_behind_is_reused_ahead() {
+    OccupancyGrid grid;
+    grid.addRay(0, 100);
+    // OCC_TILES baldosas más adelante cae en el mismo lugar del arreglo
+    grid.setPose(OCC_TILES * TILE_CM, 0, 0);
+    grid.addRay(0, 50);
+    TEST_ASSERT_EQUAL_INT8(0, grid.at(105, 5));
+    TEST_ASSERT_EQUAL_INT8(OCC_HIT, grid.at(OCC_TILES * TILE_CM + 55, 5));
+}
+
+void test_export_sends_each_change_once() {
+    OccupancyGrid grid;
+    grid.addRay(0, 100);
+    uint8_t buffer[512];
+    size_t length = grid.exportDelta(buffer, sizeof(buffer));
+    TEST_ASSERT_GREATER_THAN(0, length);
+    TEST_ASSERT_EQUAL_UINT8('M', buffer[0]);
+    TEST_ASSERT_EQUAL_UINT8(OCC_CELL_CM, buffer[1]);
+    // Del carro a los 100 cm: 11 celdas
+    TEST_ASSERT_EQUAL(11, exportedCells(buffer, length));
+    TEST_ASSERT_EQUAL(0, grid.exportDelta(buffer, sizeof(buffer)));
+    grid.addRay(0, 100);
+    TEST_ASSERT_EQUAL(11, exportedCells(buffer, grid.exportDelta(buffer, sizeof(buffer))));
+}
+
+void test_export_that_does_not_fit_continues_next_time() {
+    OccupancyGrid grid;
+    grid.addRay(0, 100);
+    uint8_t buffer[2 + 5 + 2 * 4];
+    size_t total = 0;
+    while (size_t length = grid.exportDelta(buffer, sizeof(buffer))) {
+        TEST_ASSERT_LESS_OR_EQUAL(sizeof(buffer), length);
+        total += exportedCells(buffer, length);
+    }
+    TEST_ASSERT_EQUAL(11, total);
+}
+
+void test_memory_is_fixed_by_the_tiles() {
+    // 25 baldosas de 16x16 celdas de un byte más sus marcas de cambio
+    TEST_ASSERT_EQUAL(7400, OccupancyGrid::memoryBytes());
+    TEST_ASSERT_LESS_OR_EQUAL(OccupancyGrid::memoryBytes() + 16, sizeof(OccupancyGrid));
+    char line[80];
+    snprintf(line, sizeof(line), "sizeof(OccupancyGrid) = %u bytes", (unsigned)sizeof(OccupancyGrid));
+    TEST_MESSAGE(line);
+}
+
+void test_benchmark_ray_update() {
+    OccupancyGrid grid;
+    const int RAYS = 200000;
+    // Lecturas de 1.5 m en todos los rumbos del barrido, girando el carro
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < RAYS; i++) {
+        grid.setPose(0, 0, (i / 13) % 360);
+        grid.addRay((i % 13) * 10 - 60, 150);
+    }
+    double hitNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    // Al frente, a 1.5 m, quedó ocupado; a 1 m, libre
+    TEST_ASSERT_TRUE(grid.at(155, 5) > 0);
+    TEST_ASSERT_TRUE(grid.at(105, 5) < 0);
+    // Sin eco se traza hasta OCC_FREE_RANGE_CM
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < RAYS; i++) {
+        grid.setPose(0, 0, (i / 13) % 360);
+        grid.addRay((i % 13) * 10 - 60, 0);
+    }
+    double missNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    char line[120];
+    snprintf(line, sizeof(line), "rayo de 1.5 m: %.1f ns, sin eco (%d cm): %.1f ns",
+        hitNs / RAYS, OCC_FREE_RANGE_CM, missNs / RAYS);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL_UINT32(2 * RAYS, grid.rayCount());
+    TEST_ASSERT_TRUE(grid.at(155, 5) < 0);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_hit_marks_the_end_occupied_and_the_path_free);
+    RUN_TEST(test_bearing_and_heading_rotate_the_ray);
+    RUN_TEST(test_no_echo_only_clears_up_to_the_free_range);
+    RUN_TEST(test_repeated_hits_saturate_at_the_limit);
+    RUN_TEST(test_tile_left_behind_is_reused_ahead);
+    RUN_TEST(test_export_sends_each_change_once);
+    RUN_TEST(test_export_that_does_not_fit_continues_next_time);
+    RUN_TEST(test_memory_is_fixed_by_the_tiles);
+    RUN_TEST(test_benchmark_ray_update);
+    return UNITY_END();
+}
@@ -0,0 +1,125 @@
+// Odometry: navegación a estima con la calibración por defecto
+// (avanzar 300 mm/s, retroceder 250 mm/s, girar 180 °/s)
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "Odometry.h"
+
+namespace {
+
+    // Mantiene un movimiento durante ms, llamando a update() cada 30 ms como loop()
+    void hold(Odometry& odometry, Motion motion, uint32_t ms, uint32_t& nowUs) {
+        for (uint32_t end = nowUs + ms * 1000; nowUs < end; nowUs += 30000) {
+            odometry.update(motion, nowUs);
+        }
+    }
+
+    void holdWheels(Odometry& odometry, int8_t left, int8_t right, uint32_t ms, uint32_t& nowUs) {
+        MotorOutputs outputs;
+        outputs.pwm = true;
+        outputs.left = left;
+        outputs.right = right;
+        for (uint32_t end = nowUs + ms * 1000; nowUs < end; nowUs += 30000) {
+            odometry.update(outputs, nowUs);
+        }
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_forward_then_stop_covers_speed_times_time() {
+    Odometry odometry;
+    uint32_t now = 0;
+    hold(odometry, MOTION_FORWARD, 2010, now);
+    TEST_ASSERT_INT_WITHIN(2, 30, odometry.speedCmPerSecond());
+    // Al parar se sigue la curva de respuesta: recorre lo que le faltó al arrancar
+    hold(odometry, MOTION_STOP, 2010, now);
+    TEST_ASSERT_INT_WITHIN(3, 60, odometry.xCm());
+    TEST_ASSERT_INT_WITHIN(1, 0, odometry.yCm());
+    TEST_ASSERT_EQUAL_INT(0, odometry.headingDeg());
+    TEST_ASSERT_EQUAL_INT(0, odometry.speedCmPerSecond());
+}
+
+void test_backward_uses_its_own_calibration() {
+    Odometry odometry;
+    uint32_t now = 0;
+    hold(odometry, MOTION_BACKWARD, 2010, now);
+    hold(odometry, MOTION_STOP, 2010, now);
+    TEST_ASSERT_INT_WITHIN(3, -50, odometry.xCm());
+}
+
+void test_turning_changes_heading_and_wraps() {
+    Odometry odometry;
+    uint32_t now = 0;
+    hold(odometry, MOTION_LEFT, 510, now);
+    hold(odometry, MOTION_STOP, 1500, now);
+    TEST_ASSERT_INT_WITHIN(4, 90, odometry.headingDeg());
+    // 90 + 180 = 270, que se informa como -90
+    hold(odometry, MOTION_LEFT, 1020, now);
+    hold(odometry, MOTION_STOP, 1500, now);
+    TEST_ASSERT_INT_WITHIN(6, -90, odometry.headingDeg());
+    TEST_ASSERT_INT_WITHIN(1, 0, odometry.xCm());
+}
+
+void test_square_returns_near_the_start() {
+    Odometry odometry;
+    uint32_t now = 0;
+    for (int side = 0; side < 4; side++) {
+        hold(odometry, MOTION_FORWARD, 1500, now);
+        hold(odometry, MOTION_STOP, 1500, now);
+        hold(odometry, MOTION_LEFT, 510, now);
+        hold(odometry, MOTION_STOP, 1500, now);
+    }
+    TEST_ASSERT_INT_WITHIN(8, 0, odometry.xCm());
+    TEST_ASSERT_INT_WITHIN(8, 0, odometry.yCm());
+}
+
+void test_pwm_wheels_drive_and_turn() {
+    Odometry forward;
+    uint32_t now = 0;
+    holdWheels(forward, 100, 100, 2010, now);
+    TEST_ASSERT_INT_WITHIN(2, 30, forward.speedCmPerSecond());
+
+    // Media velocidad: la mitad de distancia
+    Odometry half;
+    now = 0;
+    holdWheels(half, 50, 50, 2010, now);
+    hold(half, MOTION_STOP, 2010, now);
+    TEST_ASSERT_INT_WITHIN(3, 30, half.xCm());
+
+    // Ruedas opuestas, derecha adelante: gira a la izquierda sin avanzar
+    Odometry spin;
+    now = 0;
+    holdWheels(spin, -100, 100, 510, now);
+    hold(spin, MOTION_STOP, 1500, now);
+    TEST_ASSERT_INT_WITHIN(4, 90, spin.headingDeg());
+    TEST_ASSERT_INT_WITHIN(1, 0, spin.xCm());
+}
+
+void test_reset_returns_to_origin() {
+    Odometry odometry;
+    uint32_t now = 0;
+    hold(odometry, MOTION_FORWARD, 1000, now);
+    odometry.reset();
+    TEST_ASSERT_EQUAL_INT(0, odometry.xCm());
+    TEST_ASSERT_EQUAL_INT(0, odometry.speedCmPerSecond());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_forward_then_stop_covers_speed_times_time);
+    RUN_TEST(test_backward_uses_its_own_calibration);
+    RUN_TEST(test_turning_changes_heading_and_wraps);
+    RUN_TEST(test_square_returns_near_the_start);
+    RUN_TEST(test_pwm_wheels_drive_and_turn);
+    RUN_TEST(test_reset_returns_to_origin);
+    return UNITY_END();
+}
@@ -0,0 +1,211 @@
+// RangeScanner: barrido de una habitación simulada. Cada lectura sale de
+// trazar el rayo del ángulo al que apunta el servo contra las paredes, una
+// puerta abierta al frente (sin eco) y una columna, y pasa por la misma
+// conversión del eco que scanStep(). El perfil tiene que dar la distancia de
+// cada rumbo, y el barrido durar lo que piden el servo y el sensor.
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "DistanceFilter.h"
+#include "RangeScanner.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+    const uint32_t POLL_US = 1000;
+
+    // Habitación en cm con el sensor en el origen; 90° es el frente (+y) y
+    // 0° la derecha (+x)
+    struct Room {
+        double left = -120;
+        double right = 250;
+        double front = 180;
+        double back = -50;
+        // Puerta en la pared del frente, a un pasillo más largo que el alcance
+        double doorFrom = 60;
+        double doorTo = 140;
+        double corridor = 600;
+        // Columna redonda
+        double pillarX = -50;
+        double pillarY = 90;
+        double pillarRadius = 12;
+    };
+
+    double rangeCm(const Room& room, double deg) {
+        double dx = cos(deg * M_PI / 180);
+        double dy = sin(deg * M_PI / 180);
+        double t = 1e9;
+        if (dx > 1e-9) {
+            t = fmin(t, room.right / dx);
+        }
+        if (dx < -1e-9) {
+            t = fmin(t, room.left / dx);
+        }
+        if (dy > 1e-9) {
+            double x = dx * room.front / dy;
+            double wall = x >= room.doorFrom && x <= room.doorTo ? room.corridor : room.front;
+            t = fmin(t, wall / dy);
+        }
+        if (dy < -1e-9) {
+            t = fmin(t, room.back / dy);
+        }
+        // Rayo contra el círculo: |t * d - c|^2 = r^2
+        double along = dx * room.pillarX + dy * room.pillarY;
+        double across = room.pillarX * room.pillarX + room.pillarY * room.pillarY - along * along;
+        double r2 = room.pillarRadius * room.pillarRadius;
+        if (along > 0 && across <= r2) {
+            t = fmin(t, along - sqrt(r2 - across));
+        }
+        return t;
+    }
+
+    // Lo que scanStep() manda al perfil: eco del sensor, sin eco si no vuelve
+    // antes del timeout, y mm a cm
+    uint16_t measuredCm(const Room& room, double deg) {
+        double mm = rangeCm(room, deg) * 10;
+        uint32_t echoUs = mm > ECHO_TIMEOUT_US * 11141.0 / 65536 ? 0 : (uint32_t)lround(mm * 65536 / 11141);
+        uint16_t measured = DistanceFilter::toMillimeters(echoUs);
+        return measured == DistanceFilter::NO_ECHO ? 0 : measured / 10;
+    }
+
+    // Lo que se espera en el perfil: 0 más allá del alcance del sensor
+    uint16_t expectedCm(const Room& room, double deg) {
+        double cm = rangeCm(room, deg);
+        return cm * 10 > DistanceFilter::MAX_MM ? 0 : (uint16_t)(cm + 1e-6);
+    }
+
+    // Sondea el escáner cada POLL_US hasta completar un barrido, como el loop
+    // de control; devuelve las lecturas tomadas
+    int sweepOnce(RangeScanner& scanner, const Room& room, uint32_t& nowUs) {
+        int pings = 0;
+        for (int polls = 0; polls < 100000; polls++) {
+            if (scanner.ready(nowUs)) {
+                pings++;
+                if (scanner.record(measuredCm(room, scanner.angle()), nowUs)) {
+                    return pings;
+                }
+            }
+            nowUs += POLL_US;
+        }
+        return pings;
+    }
+
+    // Puntos del perfil que no dan la distancia de su rumbo
+    int wrongBearings(const RangeScanner& scanner, const Room& room, int skip = -1) {
+        int wrong = 0;
+        for (uint8_t i = 0; i < scanner.size(); i++) {
+            double deg = scanner.startAngle() + i * scanner.stepAngle();
+            if (i != skip && abs((int)scanner.profile()[i] - (int)expectedCm(room, deg)) > 1) {
+                char line[80];
+                snprintf(line, sizeof(line), "%.0f grados: %u cm, se esperaban %u cm",
+                    deg, scanner.profile()[i], expectedCm(room, deg));
+                TEST_MESSAGE(line);
+                wrong++;
+            }
+        }
+        return wrong;
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_sweep_reports_each_bearing_of_the_room() {
+    Room room;
+    RangeScanner scanner;
+    uint32_t now = 0;
+    scanner.setSweeping(true, now);
+    int pings = sweepOnce(scanner, room, now);
+
+    TEST_ASSERT_EQUAL(1, scanner.sweepCount());
+    TEST_ASSERT_EQUAL((SCAN_MAX_DEG - SCAN_MIN_DEG) / SCAN_STEP_DEG + 1, scanner.size());
+    TEST_ASSERT_EQUAL(scanner.size(), pings);
+    TEST_ASSERT_EQUAL(SCAN_MIN_DEG, scanner.startAngle());
+    TEST_ASSERT_EQUAL(SCAN_STEP_DEG, scanner.stepAngle());
+    TEST_ASSERT_EQUAL(0, wrongBearings(scanner, room));
+
+    // Los puntos con algo particular, por rumbo
+    const uint16_t* profile = scanner.profile();
+    uint8_t front = (SCAN_CENTER_DEG - SCAN_MIN_DEG) / SCAN_STEP_DEG;
+    TEST_ASSERT_UINT32_WITHIN(1, 180, profile[front]);
+    // La puerta, entre 60° y 70°: el pasillo queda fuera de alcance
+    TEST_ASSERT_EQUAL_UINT16(0, profile[(60 - SCAN_MIN_DEG) / SCAN_STEP_DEG]);
+    TEST_ASSERT_EQUAL_UINT16(0, profile[(70 - SCAN_MIN_DEG) / SCAN_STEP_DEG]);
+    // La columna (centro a 119° y 103 cm) solo aparece en el rumbo de 120°
+    TEST_ASSERT_UINT32_WITHIN(2, 91, profile[(120 - SCAN_MIN_DEG) / SCAN_STEP_DEG]);
+    TEST_ASSERT_TRUE(profile[(110 - SCAN_MIN_DEG) / SCAN_STEP_DEG] > 150);
+    TEST_ASSERT_TRUE(profile[(130 - SCAN_MIN_DEG) / SCAN_STEP_DEG] > 150);
+}
+
+void test_sweep_overlaps_the_servo_move_with_the_ping_interval() {
+    Room room;
+    RangeScanner scanner;
+    uint32_t now = 0;
+    scanner.setSweeping(true, now);
+    sweepOnce(scanner, room, now);
+    // Del frente al primer ángulo, y después cada paso espera al más lento
+    // entre el servo y el sensor, no a la suma
+    uint32_t first = (SCAN_CENTER_DEG - SCAN_MIN_DEG) * SERVO_US_PER_DEG + SERVO_SETTLE_US;
+    uint32_t step = SCAN_STEP_DEG * SERVO_US_PER_DEG + SERVO_SETTLE_US;
+    uint32_t perPoint = step > PING_INTERVAL_US ? step : PING_INTERVAL_US;
+    uint32_t expected = first + (scanner.size() - 1) * perPoint;
+    char line[120];
+    snprintf(line, sizeof(line), "barrido de %u puntos en %.0f ms (%.0f ms por punto)",
+        scanner.size(), now / 1000.0, perPoint / 1000.0);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_UINT32_WITHIN(POLL_US, expected, now);
+}
+
+void test_return_sweep_keeps_points_at_their_bearings() {
+    Room room;
+    RangeScanner scanner;
+    uint32_t now = 0;
+    scanner.setSweeping(true, now);
+    sweepOnce(scanner, room, now);
+
+    // Se cierra la puerta y la columna se mueve a la derecha
+    Room changed = room;
+    changed.doorFrom = changed.doorTo = 1000;
+    changed.pillarX = 60;
+    changed.pillarY = 100;
+    int pings = sweepOnce(scanner, changed, now);
+    TEST_ASSERT_EQUAL(2, scanner.sweepCount());
+    // El extremo donde se dio la vuelta no se vuelve a medir
+    uint8_t last = scanner.size() - 1;
+    TEST_ASSERT_EQUAL(last, pings);
+    TEST_ASSERT_EQUAL(0, wrongBearings(scanner, changed, last));
+    TEST_ASSERT_EQUAL_UINT16(measuredCm(room, SCAN_MAX_DEG), scanner.profile()[last]);
+}
+
+void test_full_arc_with_fine_steps() {
+    Room room;
+    RangeScanner scanner;
+    scanner.setArc(0, 180, 5);
+    uint32_t now = 0;
+    scanner.setSweeping(true, now);
+    sweepOnce(scanner, room, now);
+    TEST_ASSERT_EQUAL(SCAN_MAX_POINTS, scanner.size());
+    TEST_ASSERT_EQUAL(0, wrongBearings(scanner, room));
+    // A los costados, las paredes izquierda y derecha
+    TEST_ASSERT_UINT32_WITHIN(1, 250, scanner.profile()[0]);
+    TEST_ASSERT_UINT32_WITHIN(1, 120, scanner.profile()[SCAN_MAX_POINTS - 1]);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_sweep_reports_each_bearing_of_the_room);
+    RUN_TEST(test_sweep_overlaps_the_servo_move_with_the_ping_interval);
+    RUN_TEST(test_return_sweep_keeps_points_at_their_bearings);
+    RUN_TEST(test_full_arc_with_fine_steps);
+    return UNITY_END();
+}
@@ -0,0 +1,132 @@
+// RangeTracker: seguimiento alfa-beta de la distancia al obstáculo y nivel de
+// frenado según la distancia de detención
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "RangeTracker.h"
+
+namespace {
+
+    const uint32_t PERIOD_US = 30000;
+
+    // Lecturas cada PERIOD_US de un obstáculo que se acerca a speed cm/s;
+    // devuelve el primer nivel distinto de BRAKE_NONE y deja el tiempo en nowUs
+    BrakeLevel approach(RangeTracker& tracker, float fromCm, float speed, uint32_t& nowUs, float& atCm) {
+        float cm = fromCm;
+        while (cm > 0) {
+            BrakeLevel level = tracker.update(lroundf(cm), nowUs);
+            if (level != BRAKE_NONE) {
+                atCm = cm;
+                return level;
+            }
+            nowUs += PERIOD_US;
+            cm -= speed * PERIOD_US / 1e6f;
+        }
+        atCm = 0;
+        return BRAKE_NONE;
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_still_obstacle_far_away_does_not_brake() {
+    RangeTracker tracker;
+    uint32_t now = 1000;
+    for (int i = 0; i < 50; i++) {
+        TEST_ASSERT_EQUAL(BRAKE_NONE, tracker.update(300, now));
+        now += PERIOD_US;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1, 300, tracker.distance());
+    TEST_ASSERT_FLOAT_WITHIN(1, 0, tracker.speed());
+}
+
+void test_approaching_obstacle_slows_then_stops_before_the_margin() {
+    RangeTracker tracker;
+    uint32_t now = 1000;
+    float at = 0;
+    TEST_ASSERT_EQUAL(BRAKE_SLOW, approach(tracker, 300, 100, now, at));
+    float slowAt = at;
+    BrakeLevel level = BRAKE_SLOW;
+    float cm = at;
+    while (level != BRAKE_STOP && cm > 0) {
+        now += PERIOD_US;
+        cm -= 100 * PERIOD_US / 1e6f;
+        level = tracker.update(lroundf(cm), now);
+    }
+    TEST_ASSERT_EQUAL(BRAKE_STOP, level);
+    TEST_ASSERT_GREATER_THAN(cm, slowAt);
+    // Al parar todavía queda por delante la distancia de frenado completa
+    TEST_ASSERT_GREATER_OR_EQUAL(RANGE_MARGIN_CM + 100 * 100 / (2 * RANGE_DECEL_CM_S2), (long)cm);
+    TEST_ASSERT_FLOAT_WITHIN(15, 100, tracker.speed());
+}
+
+void test_faster_approach_brakes_earlier() {
+    RangeTracker slow;
+    RangeTracker fast;
+    uint32_t now = 1000;
+    float slowAt = 0;
+    float fastAt = 0;
+    approach(slow, 350, 50, now, slowAt);
+    now = 1000;
+    approach(fast, 350, 150, now, fastAt);
+    TEST_ASSERT_GREATER_THAN(slowAt, fastAt);
+}
+
+void test_single_false_echo_is_ignored() {
+    RangeTracker tracker;
+    uint32_t now = 1000;
+    for (int i = 0; i < 10; i++) {
+        tracker.update(200, now);
+        now += PERIOD_US;
+    }
+    TEST_ASSERT_EQUAL(BRAKE_NONE, tracker.update(15, now));
+    TEST_ASSERT_FLOAT_WITHIN(1, 200, tracker.distance());
+    now += PERIOD_US;
+    TEST_ASSERT_EQUAL(BRAKE_NONE, tracker.update(200, now));
+}
+
+void test_repeated_jump_is_accepted() {
+    RangeTracker tracker;
+    uint32_t now = 1000;
+    for (int i = 0; i < 10; i++) {
+        tracker.update(200, now);
+        now += PERIOD_US;
+    }
+    // Alguien se cruza dentro del margen: la segunda lectura igual se acepta
+    tracker.update(15, now);
+    now += PERIOD_US;
+    TEST_ASSERT_EQUAL(BRAKE_STOP, tracker.update(15, now));
+    TEST_ASSERT_FLOAT_WITHIN(1, 15, tracker.distance());
+}
+
+void test_stale_estimate_is_forgotten() {
+    RangeTracker tracker;
+    uint32_t now = 1000;
+    for (int i = 0; i < 10; i++) {
+        tracker.update(30, now);
+        now += PERIOD_US;
+    }
+    // Una sola lectura después de un hueco largo no basta para volver a seguir
+    now += (RANGE_STALE_MS + 100) * 1000UL;
+    TEST_ASSERT_EQUAL(BRAKE_NONE, tracker.update(30, now));
+    TEST_ASSERT_FLOAT_IS_INF(tracker.timeToCollision());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_still_obstacle_far_away_does_not_brake);
+    RUN_TEST(test_approaching_obstacle_slows_then_stops_before_the_margin);
+    RUN_TEST(test_faster_approach_brakes_earlier);
+    RUN_TEST(test_single_false_echo_is_ignored);
+    RUN_TEST(test_repeated_jump_is_accepted);
+    RUN_TEST(test_stale_estimate_is_forgotten);
+    return UNITY_END();
+}
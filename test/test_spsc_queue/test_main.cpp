@@ -0,0 +1,132 @@
+// SpscQueue: orden, cola llena, escritura en el lugar y un productor y un
+// consumidor en hilos distintos
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "SpscQueue.h"
+
+#include <thread>
+
+namespace {
+
+    struct Item {
+        uint32_t seq;
+        uint32_t check;
+    };
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_items_come_out_in_order() {
+    SpscQueue<uint32_t, 4> queue;
+    uint32_t value = 0;
+    TEST_ASSERT_FALSE(queue.pop(value));
+    TEST_ASSERT_TRUE(queue.push(1));
+    TEST_ASSERT_TRUE(queue.push(2));
+    TEST_ASSERT_EQUAL(2, queue.size());
+    TEST_ASSERT_TRUE(queue.pop(value));
+    TEST_ASSERT_EQUAL_UINT32(1, value);
+    TEST_ASSERT_TRUE(queue.pop(value));
+    TEST_ASSERT_EQUAL_UINT32(2, value);
+    TEST_ASSERT_NULL(queue.front());
+}
+
+void test_full_queue_rejects_without_overwriting() {
+    SpscQueue<uint32_t, 4> queue;
+    for (uint32_t i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(queue.push(i));
+    }
+    TEST_ASSERT_FALSE(queue.push(99));
+    TEST_ASSERT_NULL(queue.reserve());
+    uint32_t value = 0;
+    TEST_ASSERT_TRUE(queue.pop(value));
+    TEST_ASSERT_EQUAL_UINT32(0, value);
+    TEST_ASSERT_TRUE(queue.push(4));
+    for (uint32_t i = 1; i <= 4; i++) {
+        TEST_ASSERT_TRUE(queue.pop(value));
+        TEST_ASSERT_EQUAL_UINT32(i, value);
+    }
+}
+
+void test_reserve_and_front_work_in_place() {
+    SpscQueue<Item, 2> queue;
+    Item* slot = queue.reserve();
+    TEST_ASSERT_NOT_NULL(slot);
+    slot->seq = 7;
+    slot->check = 70;
+    // Sin commit el consumidor todavía no lo ve
+    TEST_ASSERT_NULL(queue.front());
+    queue.commit();
+    const Item* first = queue.front();
+    TEST_ASSERT_NOT_NULL(first);
+    TEST_ASSERT_EQUAL_UINT32(7, first->seq);
+    TEST_ASSERT_EQUAL_UINT32(70, first->check);
+    queue.pop();
+    TEST_ASSERT_EQUAL(0, queue.size());
+}
+
+void test_indices_wrap_around() {
+    SpscQueue<uint32_t, 4> queue;
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < 1000; i++) {
+        TEST_ASSERT_TRUE(queue.push(i));
+        TEST_ASSERT_TRUE(queue.push(i + 1));
+        TEST_ASSERT_TRUE(queue.pop(value));
+        TEST_ASSERT_EQUAL_UINT32(i, value);
+        TEST_ASSERT_TRUE(queue.pop(value));
+        TEST_ASSERT_EQUAL_UINT32(i + 1, value);
+    }
+}
+
+void test_producer_and_consumer_threads() {
+    static SpscQueue<Item, 8> queue;
+    const uint32_t COUNT = 200000;
+    std::thread producer([&] {
+        for (uint32_t seq = 1; seq <= COUNT; ) {
+            Item* slot = queue.reserve();
+            if (!slot) {
+                std::this_thread::yield();
+                continue;
+            }
+            slot->seq = seq;
+            slot->check = seq * 2654435761u;
+            queue.commit();
+            seq++;
+        }
+    });
+    uint32_t expected = 1;
+    uint32_t corrupted = 0;
+    while (expected <= COUNT) {
+        const Item* item = queue.front();
+        if (!item) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (item->seq != expected || item->check != expected * 2654435761u) {
+            corrupted++;
+        }
+        queue.pop();
+        expected++;
+    }
+    producer.join();
+    TEST_ASSERT_EQUAL_UINT32(0, corrupted);
+    TEST_ASSERT_EQUAL(0, queue.size());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_items_come_out_in_order);
+    RUN_TEST(test_full_queue_rejects_without_overwriting);
+    RUN_TEST(test_reserve_and_front_work_in_place);
+    RUN_TEST(test_indices_wrap_around);
+    RUN_TEST(test_producer_and_consumer_threads);
+    return UNITY_END();
+}
@@ -0,0 +1,229 @@
+// StateEncoder: keyframes, diferencias contra la referencia y confirmaciones,
+// decodificando igual que StateDecoder de tools/telemetry_decode.py
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "StateEncoder.h"
+
+#include <map>
+
+namespace {
+
+    struct Frame {
+        bool keyframe;
+        uint32_t seq;
+        uint32_t back;
+        uint32_t mask;
+        size_t length;
+    };
+
+    uint32_t readVarint(const uint8_t* data, size_t& pos) {
+        uint32_t value = 0;
+        for (int shift = 0; ; shift += 7) {
+            uint8_t byte = data[pos++];
+            value |= (uint32_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+    }
+
+    // Lado del servidor: guarda cada estado reconstruido por seq
+    class Decoder {
+        public:
+            // false si falta la referencia
+            bool feed(const uint8_t* data, size_t length, Frame& frame, StateSnapshot& state) {
+                size_t pos = 1;
+                frame.keyframe = data[pos++] & 1;
+                frame.seq = readVarint(data, pos);
+                frame.back = frame.keyframe ? 0 : readVarint(data, pos);
+                frame.mask = readVarint(data, pos);
+                frame.length = length;
+                StateSnapshot base = {};
+                if (!frame.keyframe) {
+                    auto found = states.find(frame.seq - frame.back);
+                    if (found == states.end()) {
+                        return false;
+                    }
+                    base = found->second;
+                }
+                for (int i = 0; i < STATE_FIELD_COUNT; i++) {
+                    if (frame.mask & (1UL << i)) {
+                        uint32_t delta = readVarint(data, pos);
+                        base.values[i] = (int32_t)((uint32_t)base.values[i] + ((delta >> 1) ^ -(delta & 1)));
+                    }
+                }
+                if (pos != length) {
+                    return false;
+                }
+                states[frame.seq] = base;
+                state = base;
+                return true;
+            }
+
+        private:
+            std::map<uint32_t, StateSnapshot> states;
+    };
+
+    StateSnapshot snapshotAt(int i) {
+        StateSnapshot snapshot = {};
+        snapshot.values[STATE_ACTION] = 1;
+        snapshot.values[STATE_DISTANCE] = 200 - i;
+        snapshot.values[STATE_X] = i * 3;
+        snapshot.values[STATE_HEADING] = -45;
+        snapshot.values[STATE_LOOP_US] = 1200 + i % 4;
+        return snapshot;
+    }
+
+    bool same(const StateSnapshot& a, const StateSnapshot& b) {
+        return memcmp(a.values, b.values, sizeof(a.values)) == 0;
+    }
+
+    Frame send(StateEncoder& encoder, Decoder& decoder, const StateSnapshot& snapshot, bool& decoded) {
+        uint8_t buffer[STATE_FRAME_MAX_BYTES];
+        size_t length = encoder.encode(snapshot, buffer);
+        Frame frame = {};
+        StateSnapshot state = {};
+        decoded = buffer[0] == 'S' && decoder.feed(buffer, length, frame, state) && same(state, snapshot);
+        return frame;
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_first_frame_is_a_keyframe() {
+    StateEncoder encoder;
+    Decoder decoder;
+    bool decoded = false;
+    Frame frame = send(encoder, decoder, snapshotAt(0), decoded);
+    TEST_ASSERT_TRUE(decoded);
+    TEST_ASSERT_TRUE(frame.keyframe);
+    TEST_ASSERT_EQUAL_UINT32(1, frame.seq);
+}
+
+void test_unchanged_state_sends_an_empty_delta() {
+    StateEncoder encoder;
+    Decoder decoder;
+    bool decoded = false;
+    send(encoder, decoder, snapshotAt(0), decoded);
+    Frame frame = send(encoder, decoder, snapshotAt(0), decoded);
+    TEST_ASSERT_TRUE(decoded);
+    TEST_ASSERT_FALSE(frame.keyframe);
+    TEST_ASSERT_EQUAL_UINT32(0, frame.mask);
+    TEST_ASSERT_EQUAL(5, frame.length);
+}
+
+void test_without_acks_deltas_are_against_the_keyframe() {
+    StateEncoder encoder;
+    Decoder decoder;
+    bool decoded = false;
+    send(encoder, decoder, snapshotAt(0), decoded);
+    for (int i = 1; i < 10; i++) {
+        Frame frame = send(encoder, decoder, snapshotAt(i), decoded);
+        TEST_ASSERT_TRUE(decoded);
+        TEST_ASSERT_EQUAL_UINT32(i, frame.back);
+    }
+}
+
+void test_ack_moves_the_reference() {
+    StateEncoder encoder;
+    Decoder decoder;
+    bool decoded = false;
+    for (int i = 0; i < 5; i++) {
+        send(encoder, decoder, snapshotAt(i), decoded);
+    }
+    encoder.acknowledge(5);
+    Frame frame = send(encoder, decoder, snapshotAt(5), decoded);
+    TEST_ASSERT_TRUE(decoded);
+    TEST_ASSERT_EQUAL_UINT32(1, frame.back);
+    // Respecto de la trama anterior solo cambian distancia, x y tiempo de loop
+    TEST_ASSERT_EQUAL_UINT32((1UL << STATE_DISTANCE) | (1UL << STATE_X) | (1UL << STATE_LOOP_US), frame.mask);
+}
+
+void test_stale_or_unknown_acks_are_ignored() {
+    StateEncoder encoder;
+    Decoder decoder;
+    bool decoded = false;
+    for (int i = 0; i < 20; i++) {
+        send(encoder, decoder, snapshotAt(i), decoded);
+    }
+    encoder.acknowledge(19);
+    // Más viejo que la referencia, fuera de la historia, o todavía no enviado
+    encoder.acknowledge(18);
+    encoder.acknowledge(20 - STATE_HISTORY);
+    encoder.acknowledge(25);
+    Frame frame = send(encoder, decoder, snapshotAt(20), decoded);
+    TEST_ASSERT_TRUE(decoded);
+    TEST_ASSERT_EQUAL_UINT32(2, frame.back);
+}
+
+void test_lost_reference_recovers_with_the_next_keyframe() {
+    StateEncoder encoder;
+    Decoder decoder;
+    Decoder late;
+    bool decoded = false;
+    send(encoder, decoder, snapshotAt(0), decoded);
+    // late no vio el keyframe: no puede reconstruir hasta el siguiente
+    for (int i = 1; i < STATE_KEYFRAME_INTERVAL + 1; i++) {
+        uint8_t buffer[STATE_FRAME_MAX_BYTES];
+        size_t length = encoder.encode(snapshotAt(i), buffer);
+        Frame frame;
+        StateSnapshot state;
+        bool ok = late.feed(buffer, length, frame, state);
+        TEST_ASSERT_EQUAL(frame.keyframe, ok);
+        if (frame.keyframe) {
+            TEST_ASSERT_EQUAL_UINT32(STATE_KEYFRAME_INTERVAL + 1, frame.seq);
+            TEST_ASSERT_TRUE(same(state, snapshotAt(i)));
+        }
+    }
+}
+
+void test_reset_starts_over_with_a_keyframe() {
+    StateEncoder encoder;
+    Decoder decoder;
+    bool decoded = false;
+    send(encoder, decoder, snapshotAt(0), decoded);
+    send(encoder, decoder, snapshotAt(1), decoded);
+    encoder.reset();
+    Decoder fresh;
+    Frame frame = send(encoder, fresh, snapshotAt(2), decoded);
+    TEST_ASSERT_TRUE(frame.keyframe);
+    TEST_ASSERT_TRUE(decoded);
+}
+
+void test_extreme_values_round_trip() {
+    StateEncoder encoder;
+    Decoder decoder;
+    bool decoded = false;
+    StateSnapshot snapshot = {};
+    snapshot.values[STATE_X] = INT32_MIN;
+    snapshot.values[STATE_Y] = INT32_MAX;
+    send(encoder, decoder, snapshot, decoded);
+    TEST_ASSERT_TRUE(decoded);
+    snapshot.values[STATE_X] = INT32_MAX;
+    snapshot.values[STATE_Y] = INT32_MIN;
+    Frame frame = send(encoder, decoder, snapshot, decoded);
+    TEST_ASSERT_TRUE(decoded);
+    TEST_ASSERT_LESS_OR_EQUAL(STATE_FRAME_MAX_BYTES, frame.length);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_frame_is_a_keyframe);
+    RUN_TEST(test_unchanged_state_sends_an_empty_delta);
+    RUN_TEST(test_without_acks_deltas_are_against_the_keyframe);
+    RUN_TEST(test_ack_moves_the_reference);
+    RUN_TEST(test_stale_or_unknown_acks_are_ignored);
+    RUN_TEST(test_lost_reference_recovers_with_the_next_keyframe);
+    RUN_TEST(test_reset_starts_over_with_a_keyframe);
+    RUN_TEST(test_extreme_values_round_trip);
+    return UNITY_END();
+}
@@ -0,0 +1,349 @@
+// SyncClientPool contra un servidor de eco TCP local. El pool está escrito
+// para cualquier cliente con la API de conexión y callbacks de AsyncClient;
+// aquí el cliente es un socket del host. Se compara cuántas peticiones por
+// segundo salen abriendo una conexión por petición y reusándolas del pool, y
+// se prueban los chequeos del pool (clave, timeout, par caído, capacidad).
+
+#include <unity.h>
+
+#include <NativeShim.h>
+
+#include "AllocTracker.h"
+#include "SyncClientPool.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    const int REQUESTS = 2000;
+    const size_t REQUEST_BYTES = 64;
+
+    // Eco por conexión, un hilo por cliente
+    class EchoServer {
+        public:
+            EchoServer() {
+                listener = socket(AF_INET, SOCK_STREAM, 0);
+                sockaddr_in addr = {};
+                addr.sin_family = AF_INET;
+                addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                bind(listener, (sockaddr*)&addr, sizeof(addr));
+                socklen_t length = sizeof(addr);
+                getsockname(listener, (sockaddr*)&addr, &length);
+                port = ntohs(addr.sin_port);
+                listen(listener, 64);
+                acceptor = std::thread([this] { run(); });
+            }
+
+            ~EchoServer() {
+                shutdown(listener, SHUT_RDWR);
+                acceptor.join();
+                closeAll();
+                for (std::thread& worker : workers) {
+                    worker.join();
+                }
+                close(listener);
+            }
+
+            // El servidor corta todas las conexiones abiertas
+            void closeAll() {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (int fd : connections) {
+                    shutdown(fd, SHUT_RDWR);
+                }
+            }
+
+            uint16_t port;
+            std::atomic<int> accepted{0};
+
+        private:
+            void run() {
+                for (;;) {
+                    int fd = accept(listener, nullptr, nullptr);
+                    if (fd < 0) {
+                        return;
+                    }
+                    accepted++;
+                    std::lock_guard<std::mutex> lock(mutex);
+                    connections.push_back(fd);
+                    workers.emplace_back([fd] {
+                        char buffer[512];
+                        ssize_t length;
+                        while ((length = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+                            send(fd, buffer, length, MSG_NOSIGNAL);
+                        }
+                        close(fd);
+                    });
+                }
+            }
+
+            int listener;
+            std::thread acceptor;
+            std::mutex mutex;
+            std::vector<int> connections;
+            std::vector<std::thread> workers;
+    };
+
+    // Lo que el pool usa de AsyncClient, sobre un socket bloqueante
+    class SocketClient {
+        public:
+            typedef std::function<void(void*, SocketClient*)> ConnectHandler;
+            typedef std::function<void(void*, SocketClient*, void*, size_t)> DataHandler;
+            typedef std::function<void(void*, SocketClient*, size_t, uint32_t)> AckHandler;
+            typedef std::function<void(void*, SocketClient*, uint32_t)> TimeoutHandler;
+
+            static int deleted;
+
+            ~SocketClient() {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+                deleted++;
+            }
+
+            bool connect(uint16_t remotePort) {
+                fd = socket(AF_INET, SOCK_STREAM, 0);
+                int on = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                sockaddr_in addr = {};
+                addr.sin_family = AF_INET;
+                addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                addr.sin_port = htons(remotePort);
+                port = remotePort;
+                return ::connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0;
+            }
+
+            bool request(const char* data, size_t length) {
+                if (send(fd, data, length, MSG_NOSIGNAL) != (ssize_t)length) {
+                    return false;
+                }
+                char reply[REQUEST_BYTES];
+                size_t received = 0;
+                while (received < length) {
+                    ssize_t n = recv(fd, reply + received, length - received, 0);
+                    if (n <= 0) {
+                        return false;
+                    }
+                    received += n;
+                }
+                return memcmp(reply, data, length) == 0;
+            }
+
+            // Espera a que el otro lado cierre, como lo vería lwIP
+            bool waitPeerClosed() {
+                pollfd watch = {fd, POLLIN | POLLRDHUP, 0};
+                return ::poll(&watch, 1, 2000) == 1;
+            }
+
+            IPAddress remoteIP() { return IPAddress(127, 0, 0, 1); }
+            uint16_t remotePort() { return port; }
+
+            bool connected() {
+                if (fd < 0 || closing) {
+                    return false;
+                }
+                char byte;
+                ssize_t n = recv(fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+                return n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+            }
+
+            // Como AsyncClient: close(false) lo deja para el próximo poll
+            void close(bool now) {
+                if (!now) {
+                    closing = true;
+                    return;
+                }
+                if (fd >= 0) {
+                    ::close(fd);
+                    fd = -1;
+                }
+                if (disconnectCb) {
+                    disconnectCb(disconnectArg, this);  // puede borrar el cliente
+                }
+            }
+
+            void poll() {
+                if (closing) {
+                    close(true);
+                } else if (pollCb) {
+                    pollCb(pollArg, this);
+                }
+            }
+
+            void onDisconnect(ConnectHandler cb, void* arg) { disconnectCb = cb; disconnectArg = arg; }
+            void onPoll(ConnectHandler cb, void* arg) { pollCb = cb; pollArg = arg; }
+            void onData(DataHandler cb, void* arg) { dataCb = cb; dataArg = arg; }
+            void onAck(AckHandler, void*) {}
+            void onTimeout(TimeoutHandler, void*) {}
+
+        private:
+            int fd = -1;
+            uint16_t port = 0;
+            bool closing = false;
+            ConnectHandler disconnectCb;
+            void* disconnectArg = nullptr;
+            ConnectHandler pollCb;
+            void* pollArg = nullptr;
+            DataHandler dataCb;
+            void* dataArg = nullptr;
+    };
+
+    int SocketClient::deleted = 0;
+
+    typedef BasicSyncClientPool<SocketClient> Pool;
+
+    const IPAddress LOCALHOST(127, 0, 0, 1);
+
+    SocketClient* open(Pool* pool, uint16_t port) {
+        SocketClient* client = pool ? pool->acquire(LOCALHOST, port) : nullptr;
+        if (!client) {
+            client = new SocketClient();
+            if (!client->connect(port)) {
+                delete client;
+                return nullptr;
+            }
+        }
+        return client;
+    }
+
+    // Peticiones por segundo; failed cuenta las que no volvieron con su eco
+    double requestsPerSecond(EchoServer& server, Pool* pool, int& failed) {
+        char payload[REQUEST_BYTES];
+        memset(payload, 'x', sizeof(payload));
+        failed = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < REQUESTS; i++) {
+            SocketClient* client = open(pool, server.port);
+            if (!client) {
+                failed++;
+                continue;
+            }
+            if (!client->request(payload, sizeof(payload))) {
+                failed++;
+            }
+            if (pool) {
+                pool->release(client);
+            } else {
+                delete client;
+            }
+        }
+        return REQUESTS / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+    SocketClient::deleted = 0;
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_pooling_reuses_one_connection() {
+    EchoServer server;
+    int plainFailed;
+    int pooledFailed;
+    double plain = requestsPerSecond(server, nullptr, plainFailed);
+    int plainAccepted = server.accepted;
+    Pool pool;
+    double pooled = requestsPerSecond(server, &pool, pooledFailed);
+    char line[160];
+    snprintf(line, sizeof(line), "sin pool: %.0f peticiones/s (%d conexiones); con pool: %.0f peticiones/s (%d conexiones)",
+        plain, plainAccepted, pooled, server.accepted - plainAccepted);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL(0, plainFailed);
+    TEST_ASSERT_EQUAL(0, pooledFailed);
+    TEST_ASSERT_EQUAL(REQUESTS, plainAccepted);
+    TEST_ASSERT_EQUAL(1, server.accepted - plainAccepted);
+    TEST_ASSERT_EQUAL_UINT32(REQUESTS - 1, pool.hits());
+    TEST_ASSERT_EQUAL_UINT32(1, pool.misses());
+    TEST_ASSERT_EQUAL(1, pool.idle());
+}
+
+void test_connections_are_keyed_by_port() {
+    EchoServer first;
+    EchoServer second;
+    Pool pool;
+    pool.release(open(&pool, first.port));
+    TEST_ASSERT_NULL(pool.acquire(LOCALHOST, second.port));
+    SocketClient* client = pool.acquire(LOCALHOST, first.port);
+    TEST_ASSERT_NOT_NULL(client);
+    delete client;
+}
+
+void test_idle_connections_time_out() {
+    EchoServer server;
+    Pool pool(4, 1000);
+    pool.release(open(&pool, server.port));
+    native::advance_us(1000 * 1000);
+    TEST_ASSERT_NULL(pool.acquire(LOCALHOST, server.port));
+    TEST_ASSERT_EQUAL(1, SocketClient::deleted);
+    TEST_ASSERT_EQUAL(0, pool.idle());
+}
+
+void test_idle_timeout_from_poll_closes_on_the_next_poll() {
+    EchoServer server;
+    Pool pool(4, 1000);
+    SocketClient* client = open(&pool, server.port);
+    pool.release(client);
+    native::advance_us(1000 * 1000);
+    client->poll();
+    // Cerrándose: ya no se entrega, pero se borra recién en el poll siguiente
+    TEST_ASSERT_EQUAL(0, pool.idle());
+    TEST_ASSERT_EQUAL(0, SocketClient::deleted);
+    client->poll();
+    TEST_ASSERT_EQUAL(1, SocketClient::deleted);
+}
+
+void test_dead_peer_is_not_handed_out() {
+    EchoServer server;
+    Pool pool;
+    SocketClient* client = open(&pool, server.port);
+    // Con el eco de vuelta, el servidor ya tiene la conexión registrada
+    TEST_ASSERT_TRUE(client->request("ping", 4));
+    pool.release(client);
+    server.closeAll();
+    TEST_ASSERT_TRUE(client->waitPeerClosed());
+    TEST_ASSERT_NULL(pool.acquire(LOCALHOST, server.port));
+    TEST_ASSERT_EQUAL(1, SocketClient::deleted);
+}
+
+void test_full_pool_closes_the_oldest() {
+    EchoServer server;
+    Pool pool(2);
+    SocketClient* clients[3];
+    for (int i = 0; i < 3; i++) {
+        clients[i] = open(nullptr, server.port);
+    }
+    for (int i = 0; i < 3; i++) {
+        pool.release(clients[i]);
+        native::advance_us(1000);
+    }
+    TEST_ASSERT_EQUAL(2, pool.idle());
+    TEST_ASSERT_EQUAL(1, SocketClient::deleted);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_pooling_reuses_one_connection);
+    RUN_TEST(test_connections_are_keyed_by_port);
+    RUN_TEST(test_idle_connections_time_out);
+    RUN_TEST(test_idle_timeout_from_poll_closes_on_the_next_poll);
+    RUN_TEST(test_dead_peer_is_not_handed_out);
+    RUN_TEST(test_full_pool_closes_the_oldest);
+    return UNITY_END();
+}
@@ -0,0 +1,215 @@
+// Tarea de control y tarea de red separadas, con std::thread y el reloj del
+// host (modo realtime del shim). La red está cargada: cada tanto un envío
+// lento la tiene ocupada más que un periodo de control entero. Con la red en
+// su propio hilo, la vuelta de control (comandos de la SpscQueue, mezcla,
+// lectura del sensor, filtro, seguimiento y mapa) cumple todos sus plazos
+// según TaskLoad; con la red dentro de la misma vuelta, como antes de separar
+// las tareas, los pierde.
+
+#include <unity.h>
+
+#include <NativeShim.h>
+
+#include "AllocTracker.h"
+#include "CommandParser.h"
+#include "DistanceFilter.h"
+#include "DriveMixer.h"
+#include "OccupancyGrid.h"
+#include "RangeTracker.h"
+#include "SpscQueue.h"
+#include "TaskLoad.h"
+#include "WebServerController.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    // Los periodos de src/main.cpp
+    const uint32_t CONTROL_PERIOD_US = 30000;
+    const uint32_t NETWORK_PERIOD_US = 5000;
+    // Envío lento (TCP con la ventana llena) cada NETWORK_BURST_EVERY vueltas de red
+    const uint32_t NETWORK_BURST_US = 50000;
+    const uint32_t NETWORK_BURST_EVERY = 8;
+    // Espera del eco en pulseIn: un obstáculo a 1 m
+    const uint32_t ECHO_US = 5900;
+    const uint32_t RUN_US = 1500000;
+
+    // pulseIn y la pila de red esperan sin soltar la CPU
+    void spin(uint32_t us) {
+        uint32_t start = micros();
+        while (micros() - start < us) {
+        }
+    }
+
+    void sleepUntil(uint32_t wakeUs) {
+        int32_t left = (int32_t)(wakeUs - micros());
+        if (left > 0) {
+            delayMicroseconds(left);
+        }
+    }
+
+    struct Harness {
+        SpscQueue<Command, 8> commands;
+        TaskLoad controlLoad{CONTROL_PERIOD_US};
+        TaskLoad networkLoad{NETWORK_PERIOD_US};
+        std::atomic<bool> running{true};
+        // Red
+        uint32_t networkIterations = 0;
+        uint32_t produced = 0;
+        uint32_t dropped = 0;
+        // Control
+        uint32_t taken = 0;
+        uint32_t worstLatencyUs = 0;
+        DriveMixer mixer;
+        DistanceFilter filter;
+        RangeTracker tracker;
+        OccupancyGrid grid;
+        DriveMixer::Wheels wheels = {0, 0};
+    };
+
+    // Una vuelta de la tarea de red: llega un comando, se interpreta y se
+    // encola para el control; a veces el envío de la telemetría se traba
+    void networkStep(Harness& h) {
+        char text[64];
+        int length = snprintf(text, sizeof(text), "{\"throttle\":%d,\"steering\":%d,\"seq\":%u}",
+            (int)(h.networkIterations % 100), -(int)(h.networkIterations % 40), (unsigned)h.networkIterations);
+        CommandFields fields;
+        if (CommandParser::parse(text, length, fields)) {
+            Command command = {};
+            command.mode = COMMAND_ARCADE;
+            command.throttle = constrain(fields.throttle, -100, 100);
+            command.steering = constrain(fields.steering, -100, 100);
+            command.seq = fields.seq;
+            command.receivedAt = micros();
+            h.produced++;
+            if (!h.commands.push(command)) {
+                h.dropped++;
+            }
+        }
+        if (++h.networkIterations % NETWORK_BURST_EVERY == 0) {
+            spin(NETWORK_BURST_US);
+        }
+    }
+
+    // Una vuelta de la tarea de control
+    void controlStep(Harness& h) {
+        Command command = {};
+        bool commandTaken = false;
+        while (h.commands.pop(command)) {
+            h.taken++;
+            commandTaken = true;
+        }
+        if (commandTaken) {
+            h.wheels = h.mixer.mix(command.throttle, command.steering);
+        }
+        spin(ECHO_US);
+        long distance = h.filter.update(ECHO_US) / 10;
+        h.tracker.update(distance, micros());
+        h.grid.addRay(0, distance);
+        if (commandTaken) {
+            uint32_t latency = micros() - command.receivedAt;
+            if (latency > h.worstLatencyUs) {
+                h.worstLatencyUs = latency;
+            }
+        }
+    }
+
+    void networkTask(Harness& h) {
+#ifdef __linux__
+        // Prioridad menor que la del control, como NETWORK_TASK_PRIORITY
+        setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19);
+#endif
+        while (h.running) {
+            h.networkLoad.begin();
+            networkStep(h);
+            h.networkLoad.end();
+            delayMicroseconds(NETWORK_PERIOD_US);
+        }
+    }
+
+    // La vuelta de control a periodo fijo durante RUN_US; con inlineNetwork
+    // la red corre dentro de ella, una vez por vuelta
+    void runControl(Harness& h, bool inlineNetwork) {
+        uint32_t start = micros();
+        uint32_t wake = start;
+        while (micros() - start < RUN_US) {
+            h.controlLoad.begin();
+            if (inlineNetwork) {
+                networkStep(h);
+            }
+            controlStep(h);
+            h.controlLoad.end();
+            wake += CONTROL_PERIOD_US;
+            sleepUntil(wake);
+        }
+        h.running = false;
+    }
+
+    void report(const char* name, Harness& h) {
+        char line[200];
+        snprintf(line, sizeof(line), "%s: control vueltas=%u excedidas=%u tarde=%u; red vueltas=%u excedidas=%u; "
+            "comandos=%u descartados=%u peor latencia=%u us",
+            name, (unsigned)h.controlLoad.iterationCount(), (unsigned)h.controlLoad.overrunCount(),
+            (unsigned)h.controlLoad.lateCount(), (unsigned)h.networkIterations,
+            (unsigned)h.networkLoad.overrunCount(), (unsigned)h.produced, (unsigned)h.dropped,
+            (unsigned)h.worstLatencyUs);
+        TEST_MESSAGE(line);
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+    native::set_realtime(true);
+}
+
+void tearDown() {
+    native::set_realtime(false);
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_control_deadlines_hold_under_network_load() {
+    std::unique_ptr<Harness> h(new Harness());
+    std::thread network(networkTask, std::ref(*h));
+    runControl(*h, false);
+    network.join();
+    report("tareas separadas", *h);
+
+    uint32_t iterations = RUN_US / CONTROL_PERIOD_US;
+    TEST_ASSERT_UINT32_WITHIN(1, iterations, h->controlLoad.iterationCount());
+    TEST_ASSERT_EQUAL_UINT32(0, h->controlLoad.overrunCount());
+    TEST_ASSERT_EQUAL_UINT32(0, h->controlLoad.lateCount());
+    // La red sí estuvo cargada: sus envíos lentos le hicieron perder plazos
+    TEST_ASSERT_TRUE(h->networkLoad.overrunCount() > 0);
+    // Cada comando se aplicó, se descartó con la cola llena o sigue en la cola
+    TEST_ASSERT_TRUE(h->taken > 0);
+    TEST_ASSERT_EQUAL_UINT32(h->produced, h->taken + h->dropped + h->commands.size());
+}
+
+void test_network_inside_the_control_loop_misses_deadlines() {
+    std::unique_ptr<Harness> h(new Harness());
+    runControl(*h, true);
+    report("red dentro del control", *h);
+
+    // Cada envío lento se come una vuelta entera de control
+    uint32_t bursts = h->networkIterations / NETWORK_BURST_EVERY;
+    TEST_ASSERT_TRUE(bursts > 0);
+    TEST_ASSERT_EQUAL_UINT32(bursts, h->controlLoad.overrunCount());
+    TEST_ASSERT_TRUE(h->controlLoad.lateCount() > 0);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_control_deadlines_hold_under_network_load);
+    RUN_TEST(test_network_inside_the_control_loop_misses_deadlines);
+    return UNITY_END();
+}
@@ -0,0 +1,344 @@
+// Reanudación de sesiones TLS de ESPAsyncTCP (tcp_ssl_sessions.h) con
+// handshakes reales: axTLS no corre en el host, así que el cliente es OpenSSL
+// haciendo lo mismo que tcp_axtls.c con la tabla (ofrecer la sesión guardada,
+// registrar el handshake, fijar o comparar la huella SHA1 del certificado)
+// contra un servidor TLS 1.2 sin tickets en 127.0.0.1. Se compara el tiempo
+// de un handshake completo con el de uno reanudado.
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "tcp_ssl_sessions.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <thread>
+
+namespace {
+
+    const int RECONNECTS = 40;
+    const uint32_t LOCALHOST = 0x0100007F;
+
+    EVP_PKEY* serverKey;
+    X509* serverCert;
+    uint8_t serverFingerprint[TCP_SSL_FINGERPRINT_SIZE];
+
+    // Clave RSA 2048 y certificado autofirmado, como los de ssl/gen_server_cert.sh
+    void makeServerIdentity() {
+        EVP_PKEY_CTX* keygen = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, nullptr);
+        EVP_PKEY_keygen_init(keygen);
+        EVP_PKEY_CTX_set_rsa_keygen_bits(keygen, 2048);
+        EVP_PKEY_keygen(keygen, &serverKey);
+        EVP_PKEY_CTX_free(keygen);
+
+        serverCert = X509_new();
+        X509_set_version(serverCert, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(serverCert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(serverCert), 0);
+        X509_gmtime_adj(X509_getm_notAfter(serverCert), 3600);
+        X509_set_pubkey(serverCert, serverKey);
+        X509_NAME* name = X509_get_subject_name(serverCert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"supercarro.local", -1, -1, 0);
+        X509_set_issuer_name(serverCert, name);
+        X509_sign(serverCert, serverKey, EVP_sha256());
+
+        unsigned int length = sizeof(serverFingerprint);
+        X509_digest(serverCert, EVP_sha1(), serverFingerprint, &length);
+    }
+
+    // Acepta conexiones de a una y las cierra cuando el cliente manda close_notify
+    class TlsServer {
+        public:
+            TlsServer() {
+                ctx = SSL_CTX_new(TLS_server_method());
+                SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+                SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);  // axTLS solo reanuda por ID de sesión
+                SSL_CTX_use_certificate(ctx, serverCert);
+                SSL_CTX_use_PrivateKey(ctx, serverKey);
+
+                listener = socket(AF_INET, SOCK_STREAM, 0);
+                sockaddr_in addr = {};
+                addr.sin_family = AF_INET;
+                addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                bind(listener, (sockaddr*)&addr, sizeof(addr));
+                socklen_t length = sizeof(addr);
+                getsockname(listener, (sockaddr*)&addr, &length);
+                port = ntohs(addr.sin_port);
+                listen(listener, 8);
+                acceptor = std::thread([this] { run(); });
+            }
+
+            ~TlsServer() {
+                shutdown(listener, SHUT_RDWR);
+                acceptor.join();
+                close(listener);
+                SSL_CTX_free(ctx);
+            }
+
+            // Como un servidor reiniciado: ya no reconoce ninguna sesión
+            void forgetSessions() {
+                SSL_CTX_flush_sessions(ctx, LONG_MAX);
+            }
+
+            uint16_t port;
+
+        private:
+            void run() {
+                for (;;) {
+                    int fd = accept(listener, nullptr, nullptr);
+                    if (fd < 0) {
+                        return;
+                    }
+                    SSL* ssl = SSL_new(ctx);
+                    SSL_set_fd(ssl, fd);
+                    if (SSL_accept(ssl) == 1) {
+                        char byte;
+                        while (SSL_read(ssl, &byte, 1) > 0) {
+                        }
+                        SSL_shutdown(ssl);
+                    }
+                    SSL_free(ssl);
+                    close(fd);
+                }
+            }
+
+            SSL_CTX* ctx;
+            int listener;
+            std::thread acceptor;
+    };
+
+    struct Handshake {
+        bool ok;
+        bool resumed;           // según la tabla
+        bool reusedByOpenSsl;   // según OpenSSL
+        bool fingerprintOk;
+        double ms;
+    };
+
+    // El lado cliente de tcp_axtls.c; las SSL_SESSION hacen de la caché del
+    // contexto de axTLS, que guarda los secretos de cada ID
+    class Client {
+        public:
+            Client() {
+                ctx = SSL_CTX_new(TLS_client_method());
+                SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION);
+                SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);  // SSL_SERVER_VERIFY_LATER
+                memset(&cache, 0, sizeof(cache));
+                memset(saved, 0, sizeof(saved));
+            }
+
+            ~Client() {
+                for (SSL_SESSION* session : saved) {
+                    SSL_SESSION_free(session);
+                }
+                SSL_CTX_free(ctx);
+            }
+
+            // pin: lo que hace AsyncClient::setFingerprint(); nullptr es no chequear
+            // (o chequear con ssl_match_fingerprint(), que no fija nada)
+            Handshake connect(uint16_t port, const uint8_t* pin) {
+                Handshake result = {};
+                int fd = socket(AF_INET, SOCK_STREAM, 0);
+                int on = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                sockaddr_in addr = {};
+                addr.sin_family = AF_INET;
+                addr.sin_addr.s_addr = LOCALHOST;
+                addr.sin_port = htons(port);
+                if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+                    close(fd);
+                    return result;
+                }
+
+                SSL* ssl = SSL_new(ctx);
+                SSL_set_fd(ssl, fd);
+                int offered = tcp_ssl_session_offer(&cache, LOCALHOST, port);
+                if (offered >= 0) {
+                    SSL_set_session(ssl, saved[offered]);
+                }
+                auto start = std::chrono::steady_clock::now();
+                result.ok = SSL_connect(ssl) == 1;
+                result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                if (result.ok) {
+                    unsigned int idLength = 0;
+                    const uint8_t* id = SSL_SESSION_get_id(SSL_get_session(ssl), &idLength);
+                    int slot = tcp_ssl_session_store(&cache, offered, LOCALHOST, port, id, idLength, &result.resumed);
+                    result.reusedByOpenSsl = SSL_session_reused(ssl);
+                    if (slot >= 0 && !result.resumed) {
+                        SSL_SESSION_free(saved[slot]);
+                        saved[slot] = SSL_get1_session(ssl);
+                    }
+                    result.fingerprintOk = true;
+                    if (pin) {
+                        result.fingerprintOk = matchFingerprint(ssl, slot, result.resumed, pin);
+                    }
+                    if (SSL_shutdown(ssl) == 0) {
+                        SSL_shutdown(ssl);
+                    }
+                }
+                SSL_free(ssl);
+                close(fd);
+                return result;
+            }
+
+            tcp_ssl_session_cache cache;
+
+        private:
+            // tcp_ssl_match_fingerprint()
+            bool matchFingerprint(SSL* ssl, int slot, bool resumed, const uint8_t* fp) {
+                if (resumed) {
+                    return tcp_ssl_session_pinned_to(&cache, slot, fp);
+                }
+                X509* cert = SSL_get_peer_certificate(ssl);
+                uint8_t digest[TCP_SSL_FINGERPRINT_SIZE];
+                unsigned int length = sizeof(digest);
+                bool match = cert && X509_digest(cert, EVP_sha1(), digest, &length) && !memcmp(digest, fp, sizeof(digest));
+                X509_free(cert);
+                if (match && slot >= 0) {
+                    tcp_ssl_session_pin(&cache, slot, fp);
+                }
+                return match;
+            }
+
+            SSL_CTX* ctx;
+            SSL_SESSION* saved[TCP_SSL_CLIENT_SESSIONS];
+    };
+
+    struct Run {
+        int failed = 0;
+        int resumed = 0;
+        int mismatched = 0;     // tabla y OpenSSL no coinciden en si se reanudó
+        double fullMs = 0;
+        double resumedMs = 0;
+    };
+
+    Run reconnect(TlsServer& server, Client& client, const uint8_t* pin) {
+        Run run;
+        for (int i = 0; i < RECONNECTS; i++) {
+            Handshake handshake = client.connect(server.port, pin);
+            if (!handshake.ok || !handshake.fingerprintOk) {
+                run.failed++;
+                continue;
+            }
+            if (handshake.resumed != handshake.reusedByOpenSsl) {
+                run.mismatched++;
+            }
+            if (handshake.resumed) {
+                run.resumed++;
+                run.resumedMs += handshake.ms;
+            } else {
+                run.fullMs += handshake.ms;
+            }
+        }
+        return run;
+    }
+
+    uint8_t otherFingerprint[TCP_SSL_FINGERPRINT_SIZE];
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_pinned_reconnects_resume() {
+    TlsServer server;
+    // Sin fijar la huella (ssl_match_fingerprint() desde onConnect): todo completo
+    Client unpinned;
+    Run full = reconnect(server, unpinned, nullptr);
+    // Con setFingerprint(): solo el primero es completo
+    Client pinned;
+    Run resumed = reconnect(server, pinned, serverFingerprint);
+
+    char line[200];
+    snprintf(line, sizeof(line), "handshake completo: %.3f ms; reanudado: %.3f ms (%d de %d reconexiones)",
+        full.fullMs / RECONNECTS, resumed.resumed ? resumed.resumedMs / resumed.resumed : 0.0,
+        resumed.resumed, RECONNECTS);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL(0, full.failed);
+    TEST_ASSERT_EQUAL(0, full.resumed);
+    TEST_ASSERT_EQUAL(0, resumed.failed);
+    TEST_ASSERT_EQUAL(0, resumed.mismatched);
+    TEST_ASSERT_EQUAL(RECONNECTS - 1, resumed.resumed);
+    TEST_ASSERT_EQUAL_UINT32(1, pinned.cache.full_handshakes);
+    TEST_ASSERT_EQUAL_UINT32(RECONNECTS - 1, pinned.cache.resumed_handshakes);
+}
+
+void test_resumed_session_is_checked_against_the_pin() {
+    TlsServer server;
+    Client client;
+    TEST_ASSERT_TRUE(client.connect(server.port, serverFingerprint).fingerprintOk);
+    Handshake handshake = client.connect(server.port, otherFingerprint);
+    TEST_ASSERT_TRUE(handshake.resumed);
+    TEST_ASSERT_FALSE(handshake.fingerprintOk);
+}
+
+void test_wrong_certificate_is_not_pinned() {
+    TlsServer server;
+    Client client;
+    TEST_ASSERT_FALSE(client.connect(server.port, otherFingerprint).fingerprintOk);
+    Handshake handshake = client.connect(server.port, otherFingerprint);
+    TEST_ASSERT_FALSE(handshake.resumed);
+    TEST_ASSERT_FALSE(handshake.fingerprintOk);
+}
+
+void test_server_that_forgot_the_session_does_a_full_handshake() {
+    TlsServer server;
+    Client client;
+    client.connect(server.port, serverFingerprint);
+    server.forgetSessions();
+    Handshake handshake = client.connect(server.port, serverFingerprint);
+    TEST_ASSERT_TRUE(handshake.ok);
+    TEST_ASSERT_FALSE(handshake.resumed);
+    TEST_ASSERT_FALSE(handshake.reusedByOpenSsl);
+    // El certificado se volvió a chequear y la sesión nueva queda fijada
+    TEST_ASSERT_TRUE(handshake.fingerprintOk);
+    TEST_ASSERT_TRUE(client.connect(server.port, serverFingerprint).resumed);
+}
+
+void test_least_recently_used_server_is_forgotten() {
+    tcp_ssl_session_cache cache;
+    memset(&cache, 0, sizeof(cache));
+    uint8_t id[TCP_SSL_SESSION_ID_MAX];
+    bool resumed;
+    for (int port = 1; port <= TCP_SSL_CLIENT_SESSIONS + 1; port++) {
+        memset(id, port, sizeof(id));
+        int slot = tcp_ssl_session_store(&cache, -1, LOCALHOST, port, id, sizeof(id), &resumed);
+        tcp_ssl_session_pin(&cache, slot, serverFingerprint);
+    }
+    TEST_ASSERT_EQUAL(-1, tcp_ssl_session_offer(&cache, LOCALHOST, 1));
+    for (int port = 2; port <= TCP_SSL_CLIENT_SESSIONS + 1; port++) {
+        TEST_ASSERT_TRUE(tcp_ssl_session_offer(&cache, LOCALHOST, port) >= 0);
+    }
+}
+
+int main() {
+    makeServerIdentity();
+    memset(otherFingerprint, 0xAB, sizeof(otherFingerprint));
+    UNITY_BEGIN();
+    RUN_TEST(test_pinned_reconnects_resume);
+    RUN_TEST(test_resumed_session_is_checked_against_the_pin);
+    RUN_TEST(test_wrong_certificate_is_not_pinned);
+    RUN_TEST(test_server_that_forgot_the_session_does_a_full_handshake);
+    RUN_TEST(test_least_recently_used_server_is_forgotten);
+    int failures = UNITY_END();
+    X509_free(serverCert);
+    EVP_PKEY_free(serverKey);
+    return failures;
+}
@@ -0,0 +1,222 @@
+// TraceBuffer: los registros salen completos y en orden, las vueltas del
+// escritor se reportan como TRACE_OVERRUN, varios escritores contra el lector
+// no producen registros mezclados, y cuánto cuesta un punto de traza
+// incluyendo el vaciado a una salida que descarta todo.
+
+#include <unity.h>
+
+#include "AllocTracker.h"
+#include "Trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    struct Frame {
+        uint32_t cycles;
+        uint16_t event;
+        uint16_t core;
+        uint32_t arg0;
+        uint32_t arg1;
+    };
+
+    // emit() escribe cada registro de una vez: 0xA5 0x5A y 16 bytes
+    class FrameSink : public Print {
+        public:
+            size_t write(uint8_t) override {
+                return 0;
+            }
+
+            size_t write(const uint8_t* buffer, size_t size) override {
+                if (size != 18 || buffer[0] != 0xA5 || buffer[1] != 0x5A) {
+                    malformed++;
+                    return size;
+                }
+                Frame frame;
+                memcpy(&frame.cycles, buffer + 2, 4);
+                memcpy(&frame.event, buffer + 6, 2);
+                memcpy(&frame.core, buffer + 8, 2);
+                memcpy(&frame.arg0, buffer + 10, 4);
+                memcpy(&frame.arg1, buffer + 14, 4);
+                received(frame);
+                return size;
+            }
+
+            virtual void received(const Frame& frame) {
+                frames.push_back(frame);
+            }
+
+            std::vector<Frame> frames;
+            uint32_t malformed = 0;
+    };
+
+    // Los args de cada registro dependen uno del otro: un registro copiado a
+    // medias mientras lo pisaban no cumple la relación
+    uint32_t checkOf(uint32_t arg0) {
+        return arg0 * 2654435761u;
+    }
+
+    class CheckingSink : public FrameSink {
+        public:
+            void received(const Frame& frame) override {
+                if (frame.event == TRACE_OVERRUN) {
+                    lost += frame.arg0;
+                    return;
+                }
+                delivered++;
+                if (frame.arg1 != checkOf(frame.arg0)) {
+                    torn++;
+                    return;
+                }
+                // Cada escritor numera sus registros: tienen que llegar en orden
+                uint32_t writer = frame.arg0 >> 24;
+                uint32_t sequence = frame.arg0 & 0xFFFFFF;
+                if (writer < 2) {
+                    if (seen[writer] && sequence <= last[writer]) {
+                        outOfOrder++;
+                    }
+                    seen[writer] = true;
+                    last[writer] = sequence;
+                }
+            }
+
+            uint64_t delivered = 0;
+            uint64_t lost = 0;
+            uint32_t torn = 0;
+            uint32_t outOfOrder = 0;
+            bool seen[2] = {false, false};
+            uint32_t last[2] = {0, 0};
+    };
+
+    class NullSink : public Print {
+        public:
+            size_t write(uint8_t) override {
+                return 1;
+            }
+
+            size_t write(const uint8_t*, size_t size) override {
+                return size;
+            }
+    };
+
+    // Con () los registros quedan en cero como los del buffer estático
+    std::unique_ptr<TraceBuffer> newBuffer() {
+        return std::unique_ptr<TraceBuffer>(new TraceBuffer());
+    }
+
+}
+
+void setUp() {
+    ALLOC_TEST_BEGIN();
+}
+
+void tearDown() {
+    ALLOC_TEST_END(Unity.CurrentTestName);
+}
+
+void test_records_come_out_whole_and_in_order() {
+    auto buffer = newBuffer();
+    buffer->write(TRACE_LOOP_START);
+    buffer->write(TRACE_DISTANCE, 42);
+    buffer->write(TRACE_COMMAND_RECEIVED, 7, 31);
+    FrameSink sink;
+    TEST_ASSERT_EQUAL(3, buffer->drain(sink));
+    TEST_ASSERT_EQUAL(3, sink.frames.size());
+    TEST_ASSERT_EQUAL(TRACE_LOOP_START, sink.frames[0].event);
+    TEST_ASSERT_EQUAL(TRACE_DISTANCE, sink.frames[1].event);
+    TEST_ASSERT_EQUAL_UINT32(42, sink.frames[1].arg0);
+    TEST_ASSERT_EQUAL(TRACE_COMMAND_RECEIVED, sink.frames[2].event);
+    TEST_ASSERT_EQUAL_UINT32(7, sink.frames[2].arg0);
+    TEST_ASSERT_EQUAL_UINT32(31, sink.frames[2].arg1);
+    TEST_ASSERT_EQUAL(0, buffer->drain(sink));
+}
+
+void test_wrapped_writer_reports_the_lost_records() {
+    auto buffer = newBuffer();
+    for (uint32_t i = 0; i < TraceBuffer::CAPACITY + 10; i++) {
+        buffer->write(TRACE_DISTANCE, i);
+    }
+    FrameSink sink;
+    buffer->drain(sink, 2 * TraceBuffer::CAPACITY);
+    TEST_ASSERT_EQUAL(TraceBuffer::CAPACITY + 1, sink.frames.size());
+    TEST_ASSERT_EQUAL(TRACE_OVERRUN, sink.frames[0].event);
+    TEST_ASSERT_EQUAL_UINT32(10, sink.frames[0].arg0);
+    // Quedan los más nuevos
+    TEST_ASSERT_EQUAL_UINT32(10, sink.frames[1].arg0);
+    TEST_ASSERT_EQUAL_UINT32(TraceBuffer::CAPACITY + 9, sink.frames.back().arg0);
+}
+
+void test_concurrent_writers_never_yield_torn_records() {
+    const uint32_t PER_WRITER = 200000;
+    auto buffer = newBuffer();
+    CheckingSink sink;
+    std::atomic<int> running{2};
+    std::vector<std::thread> writers;
+    for (uint32_t w = 0; w < 2; w++) {
+        writers.emplace_back([&buffer, &running, w, PER_WRITER] {
+            for (uint32_t i = 0; i < PER_WRITER; i++) {
+                uint32_t arg0 = (w << 24) | i;
+                buffer->write(TRACE_DISTANCE, arg0, checkOf(arg0));
+                // Para que el lector también saque registros, no solo vueltas
+                if ((i & 255) == 255) {
+                    std::this_thread::yield();
+                }
+            }
+            running--;
+        });
+    }
+    // El lector corre a la par, dejando que los escritores den la vuelta
+    while (running > 0) {
+        buffer->drain(sink, 64);
+    }
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    while (buffer->drain(sink) > 0) {
+    }
+    char line[160];
+    snprintf(line, sizeof(line), "escritos=%u entregados=%llu perdidos por vuelta=%llu",
+        (unsigned)(2 * PER_WRITER), (unsigned long long)sink.delivered, (unsigned long long)sink.lost);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL_UINT32(0, sink.malformed);
+    TEST_ASSERT_EQUAL_UINT32(0, sink.torn);
+    TEST_ASSERT_EQUAL_UINT32(0, sink.outOfOrder);
+    // Los que no salieron están contados en algún TRACE_OVERRUN
+    TEST_ASSERT_TRUE(sink.delivered + sink.lost == 2 * PER_WRITER);
+}
+
+void test_trace_point_overhead() {
+    // Un punto de traza más su parte del vaciado, como en el firmware
+    const uint32_t EVENTS = 1 << 20;
+    auto buffer = newBuffer();
+    NullSink sink;
+    size_t drained = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < EVENTS; i++) {
+        buffer->write(TRACE_COMMAND_APPLIED, i);
+        if ((i & 63) == 63) {
+            drained += buffer->drain(sink, 64);
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    char line[120];
+    snprintf(line, sizeof(line), "%.1f ns por punto de traza, vaciado incluido (%u eventos)",
+        ns / EVENTS, (unsigned)EVENTS);
+    TEST_MESSAGE(line);
+    // Vaciando cada 64 el buffer nunca da la vuelta
+    TEST_ASSERT_EQUAL(EVENTS, drained);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_records_come_out_whole_and_in_order);
+    RUN_TEST(test_wrapped_writer_reports_the_lost_records);
+    RUN_TEST(test_concurrent_writers_never_yield_torn_records);
+    RUN_TEST(test_trace_point_overhead);
+    return UNITY_END();
+}
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Mide la latencia comando->GPIO del firmware compilado para el host.
+
+Levanta un servidor WebSocket local, arranca el programa de `pio run -e native`
+apuntándolo a ese servidor (SUPERCARRO_WS_HOST/SUPERCARRO_WS_PORT) con el reloj
+real, le manda comandos numerados a ritmo fijo y junta los reportes
+"Latencia comando->GPIO" que el firmware imprime cada 5 s. El resumen queda en
+bench_output.txt (p50/p99/max por ventana, máximo global, comandos perdidos y
+comandos reemplazados: los que llegaron pero otro más nuevo los pisó en la cola
+antes de que la tarea de control los aplicara, que no son una pérdida).
+
+Uso: python3 tools/bench_server.py [--rate 50] [--seconds 20]
+         [--program .pio/build/native/program] [--output bench_output.txt]
+"""
+import argparse
+import base64
+import hashlib
+import os
+import re
+import socket
+import struct
+import subprocess
+import threading
+import time
+
+GUID = b"258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+REPORT = re.compile(r"Latencia comando->GPIO: n=(\d+) p50=(\d+)us p99=(\d+)us max=(\d+)us perdidos=(\d+) reemplazados=(\d+)")
+STATES = [b"FORWARD", b"LEFT", b"FORWARD", b"RIGHT"]
+
+
+def handshake(conn):
+    request = b""
+    while b"\r\n\r\n" not in request:
+        chunk = conn.recv(1024)
+        if not chunk:
+            raise ConnectionError("el cliente cerró durante el handshake")
+        request += chunk
+    key = re.search(rb"Sec-WebSocket-Key: *(\S+)", request, re.I).group(1)
+    accept = base64.b64encode(hashlib.sha1(key + GUID).digest())
+    conn.sendall(b"HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                 b"Connection: Upgrade\r\nSec-WebSocket-Accept: " + accept + b"\r\n\r\n")
+
+
+def text_frame(payload):
+    if len(payload) < 126:
+        return bytes([0x81, len(payload)]) + payload
+    return bytes([0x81, 126]) + struct.pack(">H", len(payload)) + payload
+
+
+def discard_frames(conn):
+    # La telemetría del carro no interesa aquí, pero hay que leerla para que su
+    # envío no se bloquee
+    try:
+        while conn.recv(4096):
+            pass
+    except OSError:
+        pass
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--rate", type=float, default=50, help="comandos por segundo")
+    parser.add_argument("--seconds", type=float, default=20, help="duración de la prueba")
+    parser.add_argument("--program", default=".pio/build/native/program")
+    parser.add_argument("--output", default="bench_output.txt")
+    args = parser.parse_args()
+
+    server = socket.socket()
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(("127.0.0.1", 0))
+    server.listen(1)
+    port = server.getsockname()[1]
+
+    env = dict(os.environ,
+               SUPERCARRO_WS_HOST="127.0.0.1",
+               SUPERCARRO_WS_PORT=str(port),
+               SUPERCARRO_REALTIME="1",
+               SUPERCARRO_RUN_MS=str(int((args.seconds + 1) * 1000)))
+    program = subprocess.Popen([args.program], env=env, stdout=subprocess.PIPE, text=True, errors="replace")
+
+    reports = []
+
+    def read_output():
+        for line in program.stdout:
+            match = REPORT.search(line)
+            if match:
+                reports.append(tuple(int(v) for v in match.groups()))
+
+    reader = threading.Thread(target=read_output, daemon=True)
+    reader.start()
+
+    server.settimeout(10)
+    conn, _ = server.accept()
+    conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    handshake(conn)
+    threading.Thread(target=discard_frames, args=(conn,), daemon=True).start()
+
+    sent = 0
+    period = 1.0 / args.rate
+    start = time.monotonic()
+    while time.monotonic() - start < args.seconds:
+        sent += 1
+        state = STATES[sent % len(STATES)]
+        try:
+            conn.sendall(text_frame(b'{"state":"' + state + b'","seq":%d}' % sent))
+        except OSError:
+            break
+        time.sleep(max(0.0, start + sent * period - time.monotonic()))
+
+    program.wait(timeout=30)
+    reader.join(timeout=5)
+    conn.close()
+    server.close()
+
+    applied = sum(r[0] for r in reports)
+    dropped = sum(r[4] for r in reports)
+    superseded = sum(r[5] for r in reports)
+    with open(args.output, "w") as out:
+        out.write("comandos enviados=%d a %.0f/s durante %.0f s\n" % (sent, args.rate, args.seconds))
+        for i, (n, p50, p99, worst, lost, replaced) in enumerate(reports):
+            out.write("ventana %d: n=%d p50=%dus p99=%dus max=%dus perdidos=%d reemplazados=%d\n"
+                      % (i, n, p50, p99, worst, lost, replaced))
+        out.write("total: aplicados=%d reemplazados=%d perdidos=%d max=%dus\n"
+                  % (applied, superseded, dropped, max((r[3] for r in reports), default=0)))
+    with open(args.output) as out:
+        print(out.read(), end="")
+
+
+if __name__ == "__main__":
+    main()
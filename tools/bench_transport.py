@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""Compara la latencia de los comandos por TCP (WebSocket) y por UDP con pérdida.
+
+Un emisor manda comandos numerados a ritmo fijo por un socket TCP y por uno
+UDP locales, y un receptor hace lo mismo que la tarea de red del carro: cada
+NETWORK_PERIOD_MS lee lo que llegó, aplica la regla de seq de
+include/CommandSequence.h (en orden por TCP, gana el más nuevo por UDP) y deja
+el comando en un buzón de 8 lugares que la tarea de control vacía cada
+CONTROL_PERIOD_MS; si el buzón está lleno el comando se pierde.
+
+La pérdida se inyecta en el emisor con la misma secuencia aleatoria para los
+dos transportes. En loopback TCP no pierde nada, así que se emula lo que haría
+la retransmisión: el segmento perdido y todo lo que va detrás esperan --rto-ms
+(bloqueo de cabeza de línea). Por UDP el paquete perdido simplemente no llega
+y el siguiente lo reemplaza.
+
+La latencia es desde que el servidor quiso mandar el comando hasta que entra
+en el buzón; lo que tarda después la tarea de control en aplicarlo es igual
+para los dos y lo mide tools/bench_server.py.
+
+Uso: python3 tools/bench_transport.py [--rate 50] [--count 1500] [--loss 0 5]
+         [--rto-ms 200] [--seed 1] [--output transport_output.txt]
+"""
+import argparse
+import json
+import random
+import socket
+import threading
+import time
+
+# Los de src/main.cpp y WebServerController.h
+NETWORK_PERIOD_MS = 5
+CONTROL_PERIOD_MS = 30
+MAILBOX_SIZE = 8
+
+
+class CommandSequence:
+    """La regla de include/CommandSequence.h."""
+
+    def __init__(self, newest_wins):
+        self.newest_wins = newest_wins
+        self.last = 0
+
+    def accept(self, seq):
+        """Devuelve (aceptado, perdidos entre el último y este)."""
+        ahead = (seq - self.last + 2**31) % 2**32 - 2**31
+        if self.newest_wins and (seq == 0 or (self.last != 0 and ahead <= 0)):
+            return False, 0
+        if seq == 0:
+            return True, 0
+        lost = ahead - 1 if self.last != 0 and ahead > 1 else 0
+        self.last = seq
+        return True, lost
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, max(0, int(round(p / 100.0 * len(ordered) + 0.5)) - 1))]
+
+
+def run(transport, args, loss):
+    """Una corrida; devuelve latencias en ms y contadores."""
+    rng = random.Random(args.seed)
+    lost_seqs = {seq for seq in range(1, args.count + 1) if rng.random() < loss / 100.0}
+    period = 1.0 / args.rate
+    rto = args.rto_ms / 1000.0
+    intended = {}
+
+    if transport == "udp":
+        receiver = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        receiver.bind(("127.0.0.1", 0))
+        sender = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sender.connect(receiver.getsockname())
+    else:
+        listener = socket.socket()
+        listener.bind(("127.0.0.1", 0))
+        listener.listen(1)
+        sender = socket.create_connection(listener.getsockname())
+        sender.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        receiver, _ = listener.accept()
+        listener.close()
+    receiver.setblocking(False)
+
+    start = time.monotonic() + 0.05
+    done = threading.Event()
+
+    def send():
+        held = []  # TCP: lo que espera detrás de un segmento perdido
+        held_until = 0.0
+        for seq in range(1, args.count + 1):
+            due = start + seq * period
+            # Mientras tanto puede vencer la retransmisión
+            while held and held_until <= due:
+                time.sleep(max(0.0, held_until - time.monotonic()))
+                for payload in held:
+                    sender.sendall(payload)
+                held = []
+            time.sleep(max(0.0, due - time.monotonic()))
+            intended[seq] = due
+            payload = json.dumps({"throttle": 60, "steering": seq % 40 - 20, "seq": seq}).encode()
+            if transport == "udp":
+                if seq not in lost_seqs:
+                    sender.send(payload)
+                continue
+            payload += b"\n"
+            if seq in lost_seqs and not held:
+                held_until = time.monotonic() + rto
+            if held or seq in lost_seqs:
+                held.append(payload)
+            else:
+                sender.sendall(payload)
+        if held:
+            time.sleep(max(0.0, held_until - time.monotonic()))
+            for payload in held:
+                sender.sendall(payload)
+        time.sleep(3 * CONTROL_PERIOD_MS / 1000.0)
+        done.set()
+
+    thread = threading.Thread(target=send)
+    thread.start()
+
+    sequence = CommandSequence(newest_wins=transport == "udp")
+    mailbox = 0
+    latencies = []
+    counts = {"perdidos": 0, "fuera_de_orden": 0, "buzon_lleno": 0, "reemplazados": 0}
+    pending = b""
+    next_control = start
+    while not done.is_set():
+        now = time.monotonic()
+        while True:
+            try:
+                data = receiver.recv(65536)
+            except BlockingIOError:
+                break
+            if not data:
+                break
+            if transport == "udp":
+                frames = [data]
+            else:
+                pending += data
+                *frames, pending = pending.split(b"\n")
+            for frame in frames:
+                seq = json.loads(frame)["seq"]
+                accepted, lost = sequence.accept(seq)
+                if not accepted:
+                    counts["fuera_de_orden"] += 1
+                    continue
+                counts["perdidos"] += lost
+                if mailbox >= MAILBOX_SIZE:
+                    counts["buzon_lleno"] += 1
+                    continue
+                mailbox += 1
+                latencies.append((now - intended[seq]) * 1000.0)
+        if now >= next_control:
+            # La tarea de control aplica el último y reemplaza los demás
+            counts["reemplazados"] += max(0, mailbox - 1)
+            mailbox = 0
+            next_control += CONTROL_PERIOD_MS / 1000.0
+        time.sleep(NETWORK_PERIOD_MS / 1000.0)
+
+    thread.join()
+    sender.close()
+    receiver.close()
+    return latencies, counts
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--rate", type=float, default=50, help="comandos por segundo")
+    parser.add_argument("--count", type=int, default=1500, help="comandos por corrida")
+    parser.add_argument("--loss", type=float, nargs="+", default=[0, 5], help="%% de pérdida a probar")
+    parser.add_argument("--rto-ms", type=float, default=200, help="retransmisión de TCP emulada")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--output", default="transport_output.txt")
+    args = parser.parse_args()
+
+    lines = ["%d comandos a %.0f/s, RTO de TCP %.0f ms, latencia envío->buzón en ms"
+             % (args.count, args.rate, args.rto_ms)]
+    for loss in args.loss:
+        for transport in ("tcp", "udp"):
+            latencies, counts = run(transport, args, loss)
+            lines.append("%s %g%% pérdida: n=%d p50=%.1f p95=%.1f p99=%.1f max=%.1f %s"
+                         % (transport.upper(), loss, len(latencies),
+                            percentile(latencies, 50), percentile(latencies, 95),
+                            percentile(latencies, 99), max(latencies, default=0.0),
+                            " ".join("%s=%d" % item for item in counts.items())))
+    with open(args.output, "w") as out:
+        out.write("\n".join(lines) + "\n")
+    print("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""Decodifica la telemetría binaria del firmware del lado del servidor: la
+comprimida (include/LzCodec.h) y el estado por diferencias
+(include/StateEncoder.h).
+
+Se activa mandando {"compress":true} al carro. Una trama comprimida es binaria
+y empieza con 'Z', luego 'T' (era texto) o 'B' (era binaria) y el largo
+original en 16 bits little endian. Las coincidencias pueden apuntar a tramas
+anteriores, así que hay que pasar por el mismo Decoder todas las tramas que
+mande el carro, en orden, comprimidas o no. Con 't' o 'b' en minúscula la
+historia empieza de nuevo.
+
+Las tramas de estado empiezan con 'S' y traen solo los campos que cambiaron
+respecto de una trama anterior; StateDecoder las reconstruye. Conviene
+confirmarlas mandando {"ack":seq} al carro para que las diferencias sean
+contra una trama más nueva.
+
+Uso como módulo:
+    decoder = Decoder()
+    states = StateDecoder()
+    kind, payload = decoder.feed(trama, es_texto)
+    if payload[:1] == b"S":
+        seq, estado = states.feed(payload)
+"""
+import struct
+import sys
+
+WINDOW = 1024
+MIN_MATCH = 3
+HEADER = struct.Struct("<ccH")
+
+
+class Decoder:
+    def __init__(self):
+        self.history = b""
+        self.started = False
+
+    def decompress(self, data, length):
+        out = bytearray(self.history)
+        start = len(out)
+        pos = 0
+        while pos < len(data):
+            flags = data[pos]
+            pos += 1
+            for bit in range(8):
+                if pos >= len(data):
+                    break
+                if not flags & (1 << bit):
+                    out.append(data[pos])
+                    pos += 1
+                    continue
+                token = data[pos] | data[pos + 1] << 8
+                pos += 2
+                distance = (token >> 6) + 1
+                # Byte a byte: la coincidencia puede solaparse con lo que se escribe
+                for _ in range((token & 0x3F) + MIN_MATCH):
+                    out.append(out[-distance])
+        if len(out) - start != length:
+            raise ValueError("largo %d, se esperaba %d" % (len(out) - start, length))
+        return bytes(out[start:])
+
+    def feed(self, frame, text):
+        """Devuelve ("text" o "binary", contenido original)."""
+        kind = "text" if text else "binary"
+        if not text and len(frame) >= HEADER.size and frame[:1] == b"Z":
+            _, flag, length = HEADER.unpack_from(frame)
+            if flag in (b"t", b"b"):
+                self.history = b""
+                self.started = True
+            frame = self.decompress(frame[HEADER.size:], length)
+            kind = "text" if flag in (b"T", b"t") else "binary"
+        if self.started:
+            self.history = (self.history + frame)[-WINDOW:]
+        return kind, frame
+
+
+STATE_FIELDS = ["action", "motion", "left", "right", "distance", "x", "y",
+                "heading", "speed", "loop_us"]
+# Más que STATE_KEYFRAME_INTERVAL: sin confirmaciones la referencia es el
+# último keyframe
+STATE_HISTORY = 64
+
+
+def read_varint(data, pos):
+    value = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+class StateDecoder:
+    def __init__(self):
+        self.snapshots = {}
+
+    def feed(self, frame):
+        """Devuelve (seq, dict con todos los campos), o (seq, None) si falta
+        la trama de referencia (se recupera con el próximo keyframe)."""
+        keyframe = frame[1] & 1
+        seq, pos = read_varint(frame, 2)
+        if keyframe:
+            base = [0] * len(STATE_FIELDS)
+        else:
+            back, pos = read_varint(frame, pos)
+            base = self.snapshots.get(seq - back)
+        mask, pos = read_varint(frame, pos)
+        if base is None:
+            return seq, None
+        values = list(base)
+        for i in range(len(STATE_FIELDS)):
+            if mask & (1 << i):
+                delta, pos = read_varint(frame, pos)
+                values[i] += (delta >> 1) ^ -(delta & 1)
+        self.snapshots[seq] = values
+        self.snapshots.pop(seq - STATE_HISTORY, None)
+        return seq, dict(zip(STATE_FIELDS, values))
+
+
+def main():
+    # Prueba: cada argumento es una trama binaria guardada en un archivo
+    decoder = Decoder()
+    for path in sys.argv[1:]:
+        with open(path, "rb") as f:
+            kind, payload = decoder.feed(f.read(), False)
+        sys.stdout.buffer.write(payload)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Convierte la traza binaria del firmware (include/Trace.h) a JSON de Chrome
+trace, que se abre en https://ui.perfetto.dev o chrome://tracing.
+
+Uso: python3 tools/trace_to_perfetto.py captura_serial.bin > traza.json
+
+La captura puede tener texto de Serial mezclado; los registros se encuentran por
+la cabecera 0xA5 0x5A.
+"""
+import json
+import struct
+import sys
+
+CPU_MHZ = 240
+RECORD = struct.Struct("<IHHII")
+MAGIC = b"\xa5\x5a"
+
+EVENTS = {
+    1: "loop_start",
+    2: "loop_end",
+    3: "distance",
+    4: "command_received",
+    5: "command_applied",
+    6: "wall_stop",
+    7: "overrun",
+}
+
+
+def records(data):
+    pos = data.find(MAGIC)
+    while pos >= 0 and pos + 2 + RECORD.size <= len(data):
+        cycles, event, core, arg0, arg1 = RECORD.unpack_from(data, pos + 2)
+        if event in EVENTS:
+            yield cycles, event, core, arg0, arg1
+            pos = data.find(MAGIC, pos + 2 + RECORD.size)
+        else:
+            pos = data.find(MAGIC, pos + 1)
+
+
+def main():
+    with open(sys.argv[1], "rb") as f:
+        data = f.read()
+
+    trace = []
+    last_cycles = None
+    wraps = 0
+    loop_open = {}
+    for cycles, event, core, arg0, arg1 in records(data):
+        # El contador de ciclos es de 32 bits: da la vuelta cada ~18 s
+        if last_cycles is not None and cycles < last_cycles and last_cycles - cycles > 1 << 31:
+            wraps += 1
+        last_cycles = cycles
+        ts = ((wraps << 32) + cycles) / CPU_MHZ
+        name = EVENTS[event]
+        if event == 1:
+            loop_open[core] = ts
+        elif event == 2 and core in loop_open:
+            start = loop_open.pop(core)
+            trace.append({"name": "loop", "ph": "X", "ts": start, "dur": ts - start, "pid": 0, "tid": core})
+        else:
+            trace.append({"name": name, "ph": "i", "s": "t", "ts": ts, "pid": 0, "tid": core,
+                          "args": {"arg0": arg0, "arg1": arg1}})
+
+    json.dump({"traceEvents": trace, "displayTimeUnit": "ms"}, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()